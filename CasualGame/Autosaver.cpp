@@ -0,0 +1,657 @@
+#include "Autosaver.h"
+
+#include "LevelReaderWriter.h"
+#include "Utils.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+
+namespace fs = std::tr2::sys;
+
+namespace
+{
+	//records are stored in the byte order of the machine, the log never leaves it
+	template<typename T>
+	void put(std::vector<char>& out, const T& value)
+	{
+		auto bytes = reinterpret_cast<const char*>(&value);
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	template<typename T>
+	bool take(const char*& data, const char* end, T& value)
+	{
+		if (size_t(end - data) < sizeof(T))
+		{
+			return false;
+		}
+		std::memcpy(&value, data, sizeof(T));
+		data += sizeof(T);
+		return true;
+	}
+
+	void putSprite(std::vector<char>& out, const Sprite& sprite)
+	{
+		put(out, sprite.x);
+		put(out, sprite.y);
+		put(out, std::int32_t(sprite.texture));
+	}
+
+	bool takeSprite(const char*& data, const char* end, Sprite& sprite)
+	{
+		std::int32_t texture;
+		if (!take(data, end, sprite.x) || !take(data, end, sprite.y) || !take(data, end, texture))
+		{
+			return false;
+		}
+		sprite.texture = texture;
+		return true;
+	}
+}
+
+Autosaver::Autosaver(const std::string& path) :
+	m_path(path),
+	m_recoverable(hasSnapshot(path))
+{
+	m_worker = std::thread(&Autosaver::run, this);
+}
+
+Autosaver::~Autosaver()
+{
+	//the worker writes what is still queued before it stops
+	flush();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+
+	if (m_worker.joinable())
+	{
+		m_worker.join();
+	}
+}
+
+void Autosaver::begin(const TileMap& level, std::vector<Sprite> sprites, const std::string& levelPath)
+{
+	flush();
+
+	m_source = nullptr;
+	m_active = !level.isPaged() && !level.empty();
+	if (!m_active)
+	{
+		return;
+	}
+
+	//mapped tiles are shared, owned ones would stall the frame and follow line by line
+	Job job = { JobType::BEGIN, TileMap(), std::move(sprites) };
+	job.path = levelPath;
+	job.sizeX = level.getSizeX();
+	job.sizeY = level.getSizeY();
+	if (level.isAttached())
+	{
+		job.level = level;
+	}
+	else
+	{
+		m_source = &level;
+		m_sourceSizeX = job.sizeX;
+		m_sourceSizeY = job.sizeY;
+		m_copiedLines = 0;
+	}
+	queue(std::move(job));
+}
+
+void Autosaver::copyLines(const int maxTiles)
+{
+	if (!m_source)
+	{
+		return;
+	}
+
+	//the level was replaced without a new begin()
+	if (m_source->getSizeX() != m_sourceSizeX || m_source->getSizeY() != m_sourceSizeY)
+	{
+		m_source = nullptr;
+		m_active = false;
+		return;
+	}
+
+	//edits made meanwhile are replayed over the copied lines, so the order does not matter
+	const int sizeY = m_source->getSizeY();
+	const int count = std::min(std::max(maxTiles / sizeY, 1), m_source->getSizeX() - m_copiedLines);
+
+	Job job = { JobType::LINES };
+	job.firstLine = m_copiedLines;
+	job.tiles.resize(static_cast<size_t>(count) * sizeY);
+	for (int i = 0; i < count; i++)
+	{
+		m_source->copyLine(m_copiedLines + i, job.tiles.data() + static_cast<size_t>(i) * sizeY);
+	}
+	queue(std::move(job));
+
+	m_copiedLines += count;
+	if (m_copiedLines >= m_source->getSizeX())
+	{
+		m_source = nullptr;
+	}
+}
+
+bool Autosaver::save(const std::string& path, std::function<void(const bool succeeded)> saved)
+{
+	if (!m_active)
+	{
+		return false;
+	}
+
+	//the worker's level is only complete once it has every line and every edit
+	while (isCopying())
+	{
+		copyLines(INT_MAX);
+	}
+	if (!m_active)
+	{
+		return false;
+	}
+	flush();
+
+	Job job = { JobType::SAVE };
+	job.path = path;
+	job.saved = std::move(saved);
+	queue(std::move(job));
+
+	m_recoverable = false;
+	return true;
+}
+
+void Autosaver::save(const std::string& path, TileMap level, std::vector<Sprite> sprites, std::function<void(const bool succeeded)> saved)
+{
+	Job job = { JobType::WRITE, std::move(level), std::move(sprites) };
+	job.path = path;
+	job.saved = std::move(saved);
+	queue(std::move(job));
+}
+
+void Autosaver::discard()
+{
+	m_pending.clear();
+	m_active = false;
+	m_recoverable = false;
+	m_source = nullptr;
+
+	{
+		//edits of the discarded level are not written anymore, saves still are
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(), [](const Job& job) { return job.type != JobType::SAVE && job.type != JobType::WRITE; }), m_jobs.end());
+	}
+	queue({ JobType::DISCARD });
+}
+
+void Autosaver::recordTiles(const std::vector<TileRun>& runs)
+{
+	if (!m_active || runs.empty())
+	{
+		return;
+	}
+
+	m_payload.clear();
+	put(m_payload, std::uint32_t(runs.size()));
+	for (auto& run : runs)
+	{
+		put(m_payload, std::int32_t(run.x));
+		put(m_payload, std::int32_t(run.y));
+		put(m_payload, std::int32_t(run.length));
+		put(m_payload, std::int32_t(run.value));
+	}
+	appendRecord(RecordType::TILES);
+}
+
+void Autosaver::recordSpriteInsert(const int index, const Sprite& sprite)
+{
+	if (!m_active)
+	{
+		return;
+	}
+
+	m_payload.clear();
+	put(m_payload, std::int32_t(index));
+	putSprite(m_payload, sprite);
+	appendRecord(RecordType::SPRITE_INSERT);
+}
+
+void Autosaver::recordSpriteMove(const int index, const double x, const double y)
+{
+	if (!m_active)
+	{
+		return;
+	}
+
+	m_payload.clear();
+	put(m_payload, std::int32_t(index));
+	put(m_payload, x);
+	put(m_payload, y);
+	appendRecord(RecordType::SPRITE_MOVE);
+}
+
+void Autosaver::recordSpriteRemove(const int index)
+{
+	if (!m_active)
+	{
+		return;
+	}
+
+	m_payload.clear();
+	put(m_payload, std::int32_t(index));
+	appendRecord(RecordType::SPRITE_REMOVE);
+}
+
+void Autosaver::flush()
+{
+	if (m_pending.empty())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_jobs.empty() && m_jobs.back().type == JobType::RECORDS)
+		{
+			//the worker is behind, its next write takes both
+			auto& records = m_jobs.back().records;
+			records.insert(records.end(), m_pending.begin(), m_pending.end());
+		}
+		else
+		{
+			m_jobs.push_back({ JobType::RECORDS, TileMap(), {}, std::move(m_pending) });
+		}
+	}
+	m_pending.clear();
+	m_wake.notify_one();
+
+	//the first edits replace the log of an earlier session
+	m_recoverable = true;
+}
+
+bool Autosaver::recover(const std::string& path, TileMap& level, std::vector<Sprite>& sprites, std::string& levelPath)
+{
+	if (!hasSnapshot(path))
+	{
+		return false;
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	TileMap recovered;
+	std::vector<Sprite> recoveredSprites;
+	std::string recoveredPath;
+	const auto replayed = applyRecords(data.data(), data.size(), recovered, recoveredSprites, recoveredPath);
+	if (recovered.empty())
+	{
+		std::cout << "Autosave " << path << " has no readable snapshot" << std::endl;
+		return false;
+	}
+	if (replayed < data.size())
+	{
+		std::cout << "Autosave " << path << " is cut short, " << data.size() - replayed << " bytes were dropped" << std::endl;
+	}
+
+	level = std::move(recovered);
+	sprites = std::move(recoveredSprites);
+	levelPath = std::move(recoveredPath);
+	return true;
+}
+
+void Autosaver::run()
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+		if (m_jobs.empty())
+		{
+			return;
+		}
+
+		auto job = std::move(m_jobs.front());
+		m_jobs.pop_front();
+		lock.unlock();
+
+		process(job);
+	}
+}
+
+void Autosaver::queue(Job job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_wake.notify_one();
+}
+
+void Autosaver::process(Job& job)
+{
+	switch (job.type)
+	{
+	case JobType::BEGIN:
+		//the previous log stays recoverable until the new level is edited
+	{
+		m_log.close();
+		const bool copied = !job.level.empty();
+		m_level = copied ? std::move(job.level) : TileMap(job.sizeX, job.sizeY);
+		m_sprites = std::move(job.sprites);
+		m_levelPath = std::move(job.path);
+		m_missingLines = copied ? 0 : job.sizeX;
+		m_edited = false;
+		m_written = false;
+		break;
+	}
+	case JobType::LINES:
+	{
+		const int sizeY = m_level.getSizeY();
+		const int count = sizeY > 0 ? int(job.tiles.size() / sizeY) : 0;
+		for (int i = 0; i < count && m_level.contains(job.firstLine + i, 0); i++)
+		{
+			std::copy_n(job.tiles.data() + static_cast<size_t>(i) * sizeY, sizeY, m_level.editLine(job.firstLine + i));
+		}
+		m_missingLines -= count;
+		if (m_missingLines <= 0 && m_edited)
+		{
+			compact();
+		}
+		break;
+	}
+	case JobType::RECORDS:
+		applyRecords(job.records.data(), job.records.size(), m_level, m_sprites, m_levelPath);
+		m_edited = true;
+		if (m_missingLines > 0)
+		{
+			//the lines still to come already hold these edits
+			break;
+		}
+		if (!m_written)
+		{
+			compact();
+			break;
+		}
+
+		m_log.write(job.records.data(), job.records.size());
+		m_log.flush();
+		m_logSize += job.records.size();
+
+		//large levels are only rewritten once their edits outgrow them
+		if (!m_log || m_logSize - m_snapshotSize > std::max(g_editorAutosaveCompactSize, m_snapshotSize))
+		{
+			compact();
+		}
+		break;
+	case JobType::SAVE:
+	{
+		//the log is kept if the level could not be written, the edits are recovered next time
+		const bool saved = LevelReaderWriter::writeLevelFile(job.path, m_level, m_sprites);
+		if (saved)
+		{
+			//editing goes on, the next edits start a log of the saved level
+			removeLog();
+			m_levelPath = job.path;
+		}
+		if (job.saved)
+		{
+			job.saved(saved);
+		}
+		break;
+	}
+	case JobType::WRITE:
+	{
+		const bool saved = LevelReaderWriter::writeLevelFile(job.path, job.level, job.sprites);
+		if (job.saved)
+		{
+			job.saved(saved);
+		}
+		break;
+	}
+	case JobType::DISCARD:
+		removeLog();
+		m_level.clear();
+		m_sprites.clear();
+		m_levelPath.clear();
+		break;
+	}
+}
+
+void Autosaver::removeLog()
+{
+	m_log.close();
+	std::remove(m_path.c_str());
+	std::remove(Utils::temporaryPath(m_path).c_str());
+	m_written = false;
+}
+
+void Autosaver::compact()
+{
+	m_log.close();
+	m_written = false;
+
+	std::vector<char> payload;
+	encodeSnapshot(m_levelPath, m_level, m_sprites, payload);
+	RecordHeader header = { std::uint32_t(RecordType::SNAPSHOT), std::uint32_t(payload.size()), Utils::checksum(payload.data(), payload.size()) };
+
+	//a crash while writing leaves the old log in place
+	const auto temporaryPath = Utils::temporaryPath(m_path);
+	fs::create_directories(fs::path(m_path).parent_path());
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(payload.data(), payload.size());
+		file.close();
+		if (!file)
+		{
+			std::cout << "Could not write the autosave " << temporaryPath << std::endl;
+			return;
+		}
+	}
+
+	if (!Utils::replaceFile(temporaryPath, m_path))
+	{
+		std::cout << "Could not replace the autosave " << m_path << std::endl;
+		return;
+	}
+
+	m_log.clear();
+	m_log.open(m_path, std::ios::binary | std::ios::app);
+	m_snapshotSize = sizeof(header) + payload.size();
+	m_logSize = m_snapshotSize;
+	m_written = m_log.is_open();
+}
+
+void Autosaver::appendRecord(const RecordType type)
+{
+	appendRecord(m_pending, type, m_payload);
+}
+
+bool Autosaver::hasSnapshot(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	RecordHeader header;
+	return file.read(reinterpret_cast<char*>(&header), sizeof(header)) && header.type == std::uint32_t(RecordType::SNAPSHOT);
+}
+
+void Autosaver::encodeSnapshot(const std::string& levelPath, const TileMap& level, const std::vector<Sprite>& sprites, std::vector<char>& payload)
+{
+	const int sizeX = level.getSizeX();
+	const int sizeY = level.getSizeY();
+	const size_t lineBytes = static_cast<size_t>(sizeY) * sizeof(std::int32_t);
+
+	payload.clear();
+	payload.reserve(sizeof(std::uint32_t) + levelPath.size() + 2 * sizeof(std::int32_t) + sizeX * lineBytes + sizeof(std::uint32_t) + sprites.size() * 20);
+	put(payload, std::uint32_t(levelPath.size()));
+	payload.insert(payload.end(), levelPath.begin(), levelPath.end());
+	put(payload, std::int32_t(sizeX));
+	put(payload, std::int32_t(sizeY));
+
+	std::vector<std::int32_t> line(sizeY);
+	for (int x = 0; x < sizeX; x++)
+	{
+		level.copyLine(x, line.data());
+		auto bytes = reinterpret_cast<const char*>(line.data());
+		payload.insert(payload.end(), bytes, bytes + lineBytes);
+	}
+
+	put(payload, std::uint32_t(sprites.size()));
+	for (auto& sprite : sprites)
+	{
+		putSprite(payload, sprite);
+	}
+}
+
+void Autosaver::appendRecord(std::vector<char>& out, const RecordType type, const std::vector<char>& payload)
+{
+	const RecordHeader header = { std::uint32_t(type), std::uint32_t(payload.size()), Utils::checksum(payload.data(), payload.size()) };
+	put(out, header);
+	out.insert(out.end(), payload.begin(), payload.end());
+}
+
+size_t Autosaver::applyRecords(const char* data, const size_t size, TileMap& level, std::vector<Sprite>& sprites, std::string& levelPath)
+{
+	size_t offset = 0;
+	while (size - offset >= sizeof(RecordHeader))
+	{
+		RecordHeader header;
+		std::memcpy(&header, data + offset, sizeof(header));
+
+		const auto payload = data + offset + sizeof(header);
+		if (header.size > size - offset - sizeof(header) || Utils::checksum(payload, header.size) != header.checksum)
+		{
+			break;
+		}
+		if (!applyRecord(RecordType(header.type), payload, header.size, level, sprites, levelPath))
+		{
+			break;
+		}
+
+		offset += sizeof(header) + header.size;
+	}
+	return offset;
+}
+
+bool Autosaver::applyRecord(const RecordType type, const char* payload, const size_t size, TileMap& level, std::vector<Sprite>& sprites, std::string& levelPath)
+{
+	const char* data = payload;
+	const char* end = payload + size;
+
+	std::int32_t index;
+	switch (type)
+	{
+	case RecordType::SNAPSHOT:
+	{
+		std::uint32_t pathLength;
+		if (!take(data, end, pathLength) || size_t(end - data) < pathLength)
+		{
+			return false;
+		}
+		std::string snapshotPath(data, pathLength);
+		data += pathLength;
+
+		std::int32_t sizeX;
+		std::int32_t sizeY;
+		if (!take(data, end, sizeX) || !take(data, end, sizeY) || sizeX <= 0 || sizeY <= 0)
+		{
+			return false;
+		}
+
+		const size_t lineBytes = static_cast<size_t>(sizeY) * sizeof(std::int32_t);
+		if (size_t(end - data) / lineBytes < size_t(sizeX))
+		{
+			return false;
+		}
+
+		TileMap snapshot(sizeX, sizeY);
+		for (int x = 0; x < sizeX; x++)
+		{
+			std::memcpy(snapshot.editLine(x), data, lineBytes);
+			data += lineBytes;
+		}
+
+		std::uint32_t count;
+		if (!take(data, end, count))
+		{
+			return false;
+		}
+		std::vector<Sprite> snapshotSprites(count);
+		for (auto& sprite : snapshotSprites)
+		{
+			if (!takeSprite(data, end, sprite))
+			{
+				return false;
+			}
+		}
+
+		level = std::move(snapshot);
+		sprites = std::move(snapshotSprites);
+		levelPath = std::move(snapshotPath);
+		return true;
+	}
+	case RecordType::TILES:
+	{
+		std::uint32_t count;
+		if (!take(data, end, count))
+		{
+			return false;
+		}
+		for (std::uint32_t i = 0; i < count; i++)
+		{
+			std::int32_t run[4];
+			if (!take(data, end, run))
+			{
+				return false;
+			}
+
+			const TileRun tiles = { run[0], run[1], run[2], run[3] };
+			if (!level.contains(tiles.x, tiles.y) || tiles.length <= 0 || tiles.length > level.getSizeY() - tiles.y)
+			{
+				return false;
+			}
+			level.fill(tiles);
+		}
+		return true;
+	}
+	case RecordType::SPRITE_INSERT:
+	{
+		Sprite sprite;
+		if (!take(data, end, index) || !takeSprite(data, end, sprite) || index < 0 || size_t(index) > sprites.size())
+		{
+			return false;
+		}
+		sprites.insert(sprites.begin() + index, sprite);
+		return true;
+	}
+	case RecordType::SPRITE_MOVE:
+	{
+		double x;
+		double y;
+		if (!take(data, end, index) || !take(data, end, x) || !take(data, end, y) || index < 0 || size_t(index) >= sprites.size())
+		{
+			return false;
+		}
+		sprites[index].x = x;
+		sprites[index].y = y;
+		return true;
+	}
+	case RecordType::SPRITE_REMOVE:
+		if (!take(data, end, index) || index < 0 || size_t(index) >= sprites.size())
+		{
+			return false;
+		}
+		sprites.erase(sprites.begin() + index);
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Sprite.h"
+#include "TileMap.h"
+
+// Crash recovery of the level editor.
+// Edits are encoded into a buffer as they happen, flush() hands the buffer to a worker thread
+// that appends it to a log file and applies it to its own copy of the level.
+// Owned tiles reach the worker a few lines per frame, edits made meanwhile are replayed over them.
+// The log starts with a snapshot of that copy and the path of its level file, once it grows too large
+// the worker writes a new log holding just a snapshot to a temporary file and renames it over the old one.
+// Saving the level is a job of the worker too, it writes its copy next to the level file and renames it
+// over it, so the editor never waits for the disk.
+// Every record carries a checksum, a log cut short by a crash is replayed up to the last whole record.
+class Autosaver
+{
+public:
+	explicit Autosaver(const std::string& path);
+	virtual ~Autosaver();
+
+	// later edits are relative to this level, the log is only replaced once one arrives.
+	// paged levels share their tiles between copies and are not autosaved.
+	// owned tiles are handed to the worker by copyLines(), level has to outlive the copy
+	void begin(const TileMap& level, std::vector<Sprite> sprites, const std::string& levelPath);
+	// copies the next lines of the level given to begin(), about maxTiles of them, call once per frame
+	void copyLines(const int maxTiles);
+	bool isCopying() const { return m_source != nullptr; }
+	// writes the level with the edits recorded so far to path and removes the log, later edits start
+	// a new one. false if the level is not autosaved, saved runs on the worker once the file was replaced or could not be
+	bool save(const std::string& path, std::function<void(const bool succeeded)> saved);
+	// writes a level that is not autosaved, a paged one should page a store of its own
+	void save(const std::string& path, TileMap level, std::vector<Sprite> sprites, std::function<void(const bool succeeded)> saved);
+	// the level was saved elsewhere, the log is removed in the background
+	void discard();
+	bool isActive() const { return m_active; }
+
+	// the edit was already applied to the level
+	void recordTiles(const std::vector<TileRun>& runs);
+	void recordSpriteInsert(const int index, const Sprite& sprite);
+	void recordSpriteMove(const int index, const double x, const double y);
+	void recordSpriteRemove(const int index);
+
+	// queues the recorded edits for writing, does not wait for the disk
+	void flush();
+	bool hasPending() const { return !m_pending.empty(); }
+
+	// a log left behind by an earlier session or editor that did not end with a save,
+	// jobs still queued are taken into account
+	bool canRecover() const { return m_recoverable; }
+	// replays the log and the path of the level it was started from, false if it has no valid snapshot
+	static bool recover(const std::string& path, TileMap& level, std::vector<Sprite>& sprites, std::string& levelPath);
+
+private:
+
+	enum class RecordType : std::uint32_t
+	{
+		SNAPSHOT = 1,
+		TILES,
+		SPRITE_INSERT,
+		SPRITE_MOVE,
+		SPRITE_REMOVE
+	};
+
+	// type, payload size and checksum of the payload
+	struct RecordHeader
+	{
+		std::uint32_t type;
+		std::uint32_t size;
+		std::uint32_t checksum;
+	};
+
+	enum class JobType
+	{
+		BEGIN,
+		LINES,
+		RECORDS,
+		SAVE,
+		WRITE,
+		DISCARD
+	};
+
+	struct Job
+	{
+		JobType type;
+		TileMap level;
+		std::vector<Sprite> sprites;
+		std::vector<char> records;
+		std::string path;
+		std::function<void(const bool succeeded)> saved;
+		//size of the level of BEGIN, the tiles of LINES start at firstLine
+		int sizeX;
+		int sizeY;
+		int firstLine;
+		std::vector<std::int32_t> tiles;
+	};
+
+	std::string m_path;
+
+	//owned by the editor thread
+	bool m_active = false;
+	bool m_recoverable = false;
+	//owned level being copied to the worker and the next line to copy
+	const TileMap* m_source = nullptr;
+	int m_sourceSizeX = 0;
+	int m_sourceSizeY = 0;
+	int m_copiedLines = 0;
+	std::vector<char> m_pending;
+	std::vector<char> m_payload;
+
+	//guards the jobs
+	std::mutex m_mutex;
+	std::deque<Job> m_jobs;
+	std::condition_variable m_wake;
+	bool m_stop = false;
+
+	std::thread m_worker;
+
+	//owned by the worker, the level as the log describes it
+	TileMap m_level;
+	std::vector<Sprite> m_sprites;
+	std::string m_levelPath;
+	//lines still to arrive, the log is written once the copy is complete
+	int m_missingLines = 0;
+	bool m_edited = false;
+	bool m_written = false;
+	std::ofstream m_log;
+	size_t m_logSize = 0;
+	size_t m_snapshotSize = 0;
+
+	void run();
+	void process(Job& job);
+	// replaces the log with a snapshot of the worker's level
+	void compact();
+	void removeLog();
+	void queue(Job job);
+
+	void appendRecord(const RecordType type);
+	static bool hasSnapshot(const std::string& path);
+	static void encodeSnapshot(const std::string& levelPath, const TileMap& level, const std::vector<Sprite>& sprites, std::vector<char>& payload);
+	static void appendRecord(std::vector<char>& out, const RecordType type, const std::vector<char>& payload);
+	// applies whole records, returns the bytes they take
+	static size_t applyRecords(const char* data, const size_t size, TileMap& level, std::vector<Sprite>& sprites, std::string& levelPath);
+	static bool applyRecord(const RecordType type, const char* payload, const size_t size, TileMap& level, std::vector<Sprite>& sprites, std::string& levelPath);
+};
@@ -0,0 +1,430 @@
+#include "Benchmark.h"
+
+#include "GLRaycaster.h"
+#include "LevelReaderWriter.h"
+#include "LevelGenerator.h"
+#include "RandomGenerator.h"
+#include "Player.h"
+#include "Sprite.h"
+#include "SpriteIndex.h"
+#include "EditorBrush.h"
+#include "ParticleField.h"
+#include "Utils.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+	const int resolutions[][2] = { { 320, 240 }, { 800, 600 }, { 1920, 1080 } };
+	const int levelSizes[] = { 24, 64, 256, 1024 };
+	const int spriteCounts[] = { 10, 100, 1000, 10000 };
+	const int loadLevelSizes[] = { 24, 64, 256, 1024, 4096 };
+}
+
+Benchmark::Benchmark()
+{
+	m_random = std::make_unique<RandomGenerator>(g_benchmarkSeed);
+	m_levelReader = std::make_shared<LevelReaderWriter>();
+	m_player = std::make_shared<Player>();
+}
+
+Benchmark::~Benchmark() = default;
+
+void Benchmark::run()
+{
+	m_results.clear();
+
+	benchmarkRaycaster();
+	benchmarkSprites();
+	benchmarkCombSort();
+	benchmarkSpritePicking();
+	benchmarkFloodFill();
+	benchmarkParticles();
+	benchmarkLevelLoading();
+	benchmarkTextureLoading();
+}
+
+void Benchmark::measure(const std::string& name, const Params& params, const std::function<void()>& body)
+{
+	if (name.find(m_filter) == std::string::npos)
+	{
+		return;
+	}
+
+	typedef std::chrono::steady_clock Clock;
+
+	//warm up caches and lazy allocations, bodies shorter than the clock can resolve are timed in batches
+	int batch = 1;
+	for (;;)
+	{
+		const auto start = Clock::now();
+		for (int i = 0; i < batch; i++)
+		{
+			body();
+		}
+		if (Clock::now() - start >= std::chrono::microseconds(g_benchmarkMinimumSampleTime) || batch >= (1 << 20))
+		{
+			break;
+		}
+		batch *= 2;
+	}
+
+	std::vector<double> samples;
+	const auto total = Clock::now();
+	while (samples.size() < 5 || Clock::now() - total < std::chrono::microseconds(m_minimumTime))
+	{
+		const auto start = Clock::now();
+		for (int i = 0; i < batch; i++)
+		{
+			body();
+		}
+		samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / batch);
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	Result result;
+	result.name = name;
+	result.params = params;
+	result.iterations = static_cast<long long>(samples.size()) * batch;
+	result.minNs = samples.front();
+	result.medianNs = samples[samples.size() / 2];
+	result.meanNs = 0.0;
+	for (auto sample : samples)
+	{
+		result.meanNs += sample;
+	}
+	result.meanNs /= samples.size();
+
+	std::cerr << name;
+	for (auto& param : params)
+	{
+		std::cerr << " " << param.first << "=" << param.second;
+	}
+	std::cerr << ": median " << result.medianNs / 1000.0 << " us" << std::endl;
+
+	m_results.push_back(result);
+}
+
+// arena level with random inner walls and sprites
+void Benchmark::generateLevel(const int size, const int spriteCount)
+{
+	LevelGenerator::Settings settings;
+	settings.type = LevelType::ARENA;
+	settings.width = size;
+	settings.height = size;
+	settings.wallDensity = 0.1f;
+	settings.spriteCount = spriteCount;
+	settings.seed = g_benchmarkSeed;
+
+	LevelGenerator generator(settings);
+	generator.generate();
+
+	m_levelReader->setLevel(generator.getLevel(), generator.getSprites());
+	placePlayer();
+}
+
+// puts the player on an empty tile in the middle of the level
+void Benchmark::placePlayer()
+{
+	auto& level = m_levelReader->getLevel();
+	const int center = level.getSizeX() / 2;
+
+	m_player->m_dirX = -1.0;
+	m_player->m_dirY = 0.0;
+	m_player->m_planeX = 0.0;
+	m_player->m_planeY = 0.66;
+
+	for (int offset = 0; offset < center; offset++)
+	{
+		if (level.get(center + offset, center) == 0)
+		{
+			m_player->m_posX = center + offset + 0.5;
+			m_player->m_posY = center + 0.5;
+			return;
+		}
+	}
+}
+
+void Benchmark::benchmarkRaycaster()
+{
+	for (auto levelSize : levelSizes)
+	{
+		generateLevel(levelSize, 0);
+
+		for (auto& resolution : resolutions)
+		{
+			const int width = resolution[0];
+			const int height = resolution[1];
+			const Params params = { { "levelSize", levelSize }, { "width", width }, { "height", height } };
+
+			GLRaycaster raycaster;
+			raycaster.initialize(width, height, m_player, m_levelReader, true);
+			raycaster.setThreadCount(1);
+
+			//the column benchmarks draw the same hits whichever of them the filter selects
+			std::vector<GLRaycaster::RayHit> hits(width);
+			for (int x = 0; x < width; x++)
+			{
+				hits[x] = raycaster.castRay(x);
+			}
+
+			std::vector<GLRaycaster::RayHit> cast(width);
+			measure("dda_traversal", params, [&]()
+			{
+				for (int x = 0; x < width; x++)
+				{
+					cast[x] = raycaster.castRay(x);
+				}
+			});
+
+			measure("wall_column_texturing", params, [&]()
+			{
+				for (int x = 0; x < width; x++)
+				{
+					raycaster.drawWallColumn(x, hits[x]);
+				}
+			});
+
+			measure("floor_casting", params, [&]()
+			{
+				for (int x = 0; x < width; x++)
+				{
+					raycaster.drawFloorColumn(x, hits[x], height / 2);
+				}
+			});
+
+			measure("set_pixel", params, [&]()
+			{
+				for (int y = 0; y < height; y++)
+				{
+					for (int x = 0; x < width; x++)
+					{
+						raycaster.setPixel(x, y, 0xFF808080, (x + y) % 3);
+					}
+				}
+			});
+
+			measure("render_frame", params, [&]()
+			{
+				raycaster.render();
+			});
+
+			//what the editor preview renders after a typical edit
+			measure("render_columns", params, [&]()
+			{
+				raycaster.renderColumns(width / 2 - 4, width / 2 + 4);
+			});
+		}
+	}
+}
+
+void Benchmark::benchmarkSprites()
+{
+	for (auto spriteCount : spriteCounts)
+	{
+		generateLevel(64, spriteCount);
+
+		for (auto& resolution : resolutions)
+		{
+			const int width = resolution[0];
+			const int height = resolution[1];
+			const Params params = { { "sprites", spriteCount }, { "width", width }, { "height", height } };
+
+			GLRaycaster raycaster;
+			raycaster.initialize(width, height, m_player, m_levelReader, true);
+			raycaster.setThreadCount(1);
+			raycaster.calculateWalls();
+
+			measure("sprite_projection", params, [&]()
+			{
+				raycaster.calculateSprites();
+			});
+		}
+	}
+}
+
+void Benchmark::benchmarkCombSort()
+{
+	for (auto count : spriteCounts)
+	{
+		std::vector<double> distances(count);
+		for (auto& distance : distances)
+		{
+			distance = m_random->randomFloat(0.0f, 1000.0f);
+		}
+
+		std::vector<int> order(count);
+		std::vector<double> dist(count);
+
+		measure("comb_sort", { { "count", count } }, [&]()
+		{
+			for (int i = 0; i < count; i++)
+			{
+				order[i] = i;
+			}
+			dist = distances;
+			Utils::combSort(order, dist, count);
+		});
+	}
+}
+
+void Benchmark::benchmarkSpritePicking()
+{
+	const int levelSize = 1024;
+	const int queryCount = 1000;
+
+	for (auto count : { 1000, 10000, 100000 })
+	{
+		std::vector<Sprite> sprites(count);
+		for (auto& sprite : sprites)
+		{
+			sprite.x = m_random->randomFloat(1.0f, levelSize - 1.0f);
+			sprite.y = m_random->randomFloat(1.0f, levelSize - 1.0f);
+		}
+
+		std::vector<std::pair<double, double> > points(queryCount);
+		for (auto& point : points)
+		{
+			point.first = m_random->randomFloat(1.0f, levelSize - 1.0f);
+			point.second = m_random->randomFloat(1.0f, levelSize - 1.0f);
+		}
+
+		SpriteIndex index(g_editorSpriteIndexCellSize);
+		measure("sprite_index_build", { { "sprites", count } }, [&]()
+		{
+			index.rebuild(sprites);
+		});
+
+		int picked = 0;
+		measure("sprite_pick", { { "sprites", count }, { "queries", queryCount } }, [&]()
+		{
+			for (auto& point : points)
+			{
+				picked += index.findNearest(point.first, point.second, 0.5) != -1;
+			}
+		});
+
+		size_t selected = 0;
+		measure("sprite_box_select", { { "sprites", count }, { "queries", queryCount } }, [&]()
+		{
+			for (auto& point : points)
+			{
+				selected += index.findInBox(point.first, point.second, point.first + 16.0, point.second + 16.0).size();
+			}
+		});
+	}
+}
+
+void Benchmark::benchmarkFloodFill()
+{
+	//fills the open area around the player and writes it to the level as one batch
+	for (auto levelSize : loadLevelSizes)
+	{
+		generateLevel(levelSize, 0);
+		const auto level = m_levelReader->getLevel();
+		const int x = int(m_player->m_posX);
+		const int y = int(m_player->m_posY);
+
+		//applied whether or not the filter selects the fill itself
+		std::vector<TileRun> runs;
+		EditorBrush::floodFill(level, x, y, 1, runs);
+
+		std::vector<TileRun> filled;
+		measure("editor_flood_fill", { { "levelSize", levelSize } }, [&]()
+		{
+			filled.clear();
+			EditorBrush::floodFill(level, x, y, 1, filled);
+		});
+
+		measure("editor_apply_runs", { { "levelSize", levelSize }, { "runs", static_cast<long long>(runs.size()) } }, [&]()
+		{
+			m_levelReader->changeLevelTiles(runs);
+		});
+	}
+
+	generateLevel(levelSizes[0], 0);
+}
+
+void Benchmark::benchmarkParticles()
+{
+	//one drawn frame of the main menu background
+	for (auto count : { 200, 10000, 100000 })
+	{
+		ParticleField particles(sf::Vector2f(960.0f, 540.0f), g_menuParticleSize, sf::Color::White);
+		particles.reserve(count);
+		for (int i = 0; i < count; i++)
+		{
+			particles.add(sf::Vector2f(m_random->randomFloat(0.0f, 1920.0f), m_random->randomFloat(0.0f, 1920.0f)));
+		}
+
+		measure("menu_particles", { { "particles", count } }, [&]()
+		{
+			particles.rotate(g_menuParticleSpeed * 16.0f);
+			particles.update();
+		});
+	}
+}
+
+void Benchmark::benchmarkLevelLoading()
+{
+	for (auto levelSize : loadLevelSizes)
+	{
+		generateLevel(levelSize, levelSize);
+		m_levelReader->saveLevelFile(g_benchmarkLevelFile);
+
+		measure("load_level", { { "levelSize", levelSize } }, [&]()
+		{
+			m_levelReader->loadLevelFile(g_benchmarkLevelFile);
+		});
+	}
+
+	std::remove(g_benchmarkLevelFile);
+
+	//free the largest level before the next benchmarks
+	generateLevel(levelSizes[0], 0);
+}
+
+void Benchmark::benchmarkTextureLoading()
+{
+	measure("load_texture", { { "count", g_textureCount } }, [&]()
+	{
+		for (auto i = 0; i < g_textureCount; i++)
+		{
+			m_levelReader->loadTexture(i, g_textureFiles[i]);
+		}
+	});
+}
+
+void Benchmark::writeJson(std::ostream& out) const
+{
+	out << "{\n";
+	out << "  \"seed\": " << g_benchmarkSeed << ",\n";
+#ifdef NDEBUG
+	out << "  \"build\": \"release\",\n";
+#else
+	out << "  \"build\": \"debug\",\n";
+#endif
+	out << "  \"benchmarks\": [";
+
+	for (size_t i = 0; i < m_results.size(); i++)
+	{
+		auto& result = m_results[i];
+		out << (i == 0 ? "\n" : ",\n");
+		out << "    { \"name\": \"" << result.name << "\", \"params\": {";
+		for (size_t p = 0; p < result.params.size(); p++)
+		{
+			out << (p == 0 ? " " : ", ") << "\"" << result.params[p].first << "\": " << result.params[p].second;
+		}
+		out << " }, \"iterations\": " << result.iterations
+			<< ", \"mean_ns\": " << static_cast<long long>(result.meanNs)
+			<< ", \"median_ns\": " << static_cast<long long>(result.medianNs)
+			<< ", \"min_ns\": " << static_cast<long long>(result.minNs) << " }";
+	}
+
+	out << "\n  ]\n}\n";
+}
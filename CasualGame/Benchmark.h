@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+class LevelReaderWriter;
+class RandomGenerator;
+struct Player;
+struct Sprite;
+
+// Microbenchmarks of the raycaster and level loading hot paths.
+// Synthetic inputs come from a fixed seed so results can be compared across commits,
+// run with --benchmark.
+class Benchmark
+{
+public:
+	Benchmark();
+	virtual ~Benchmark();
+
+	// only runs benchmarks whose name contains the filter
+	void setFilter(const std::string& filter) { m_filter = filter; }
+	void setMinimumTime(const sf::Int64 microseconds) { m_minimumTime = microseconds; }
+
+	void run();
+	void writeJson(std::ostream& out) const;
+
+private:
+
+	typedef std::vector<std::pair<std::string, long long> > Params;
+
+	struct Result
+	{
+		std::string name;
+		Params params;
+		long long iterations;
+		double meanNs;
+		double medianNs;
+		double minNs;
+	};
+
+	std::string m_filter;
+	sf::Int64 m_minimumTime = 200000;
+	std::vector<Result> m_results;
+
+	std::unique_ptr<RandomGenerator> m_random;
+	std::shared_ptr<LevelReaderWriter> m_levelReader;
+	std::shared_ptr<Player> m_player;
+
+	void measure(const std::string& name, const Params& params, const std::function<void()>& body);
+
+	void generateLevel(const int size, const int spriteCount);
+	void placePlayer();
+
+	void benchmarkRaycaster();
+	void benchmarkSprites();
+	void benchmarkCombSort();
+	void benchmarkSpritePicking();
+	void benchmarkFloodFill();
+	void benchmarkParticles();
+	void benchmarkLevelLoading();
+	void benchmarkTextureLoading();
+};
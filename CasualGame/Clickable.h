@@ -9,8 +9,9 @@ public:
 	virtual ~Clickable() = default;
 
 	void update(const sf::Vector2f& size, const sf::Vector2f& position);
-	void draw(sf::RenderWindow& window);
 	bool containsVector(const sf::Vector2f& position) const;
+	// screen area of the sprite, the outline is drawn around it
+	sf::FloatRect getBounds() const { return sf::FloatRect(m_shape.getPosition(), m_shape.getSize()); }
 	bool isVisible() const { return m_visible; };
 	void setVisible(bool visible = true) { m_visible = visible; }
 
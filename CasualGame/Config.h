@@ -2,8 +2,6 @@
 
 #include <string>
 
-#include "FontLoader.h"
-
 static const auto g_gameTitle = "Casual Game by Miretz";
 
 static const auto g_defaultWidth = 800;
@@ -12,17 +10,66 @@ static const auto g_defaultHeight = 600;
 static const int g_textureWidth = 128;
 static const int g_textureHeight = 128;
 
+//frame pacing, 0 disables the limit
+static const int g_targetFramerate = 500;
+static const long long g_framePacerSpinTime = 1500; //microseconds spent spinning before a frame deadline
+
+//fixed timestep simulation, in updates per second
+static const int g_simulationRate = 120;
+//maximum number of simulation steps run to catch up after a slow frame
+static const int g_maxSimulationSteps = 8;
+
 //the constant value is in radians/second
 static const double g_lookSpeed = 3.0; //TODO Make configurable in game
 
 // Resources
 
-static const FontLoader* g_fontLoader = new FontLoader("resources/font/OtherF.ttf");
+//loaded once through the resource cache
+static const auto g_fontFile = "resources/font/OtherF.ttf";
+
+//changed assets are reloaded while the game runs
+static const bool g_hotReloadEnabled = true;
+static const auto g_resourceDirectory = "resources/";
+//built with --pack-resources, the loose files are used without it
+static const bool g_useResourcePack = true;
+static const auto g_resourcePackFile = "resources.pak";
+static const int g_hotReloadPollTime = 50;
+static const int g_hotReloadSettleTime = 100;
 
 static const auto g_defaultLevelFile = "resources/levels/level1.txt";
 static const auto g_defaultLevelSpriteFile = "resources/levels/level1_sprites.txt";
 
+static const auto g_levelDirectory = "resources/levels/";
 static const auto g_customLevelDirectory = "resources/levels/custom/";
+//cached metadata of the custom levels
+static const auto g_levelCatalogFile = "resources/levels/custom_catalog.txt";
+//level previews of the editor, cached by the hash of the level file
+static const auto g_thumbnailDirectory = "resources/levels/thumbnails/";
+static const int g_thumbnailMapSize = 96;
+static const int g_thumbnailViewWidth = 160;
+static const int g_thumbnailViewHeight = 96;
+//log of the level being edited, replayed to recover unsaved edits after a crash
+static const auto g_autosaveDirectory = "resources/levels/autosave/";
+static const auto g_autosaveFile = "resources/levels/autosave/editor.log";
+//suffix of files written next to the level or log they replace once complete
+static const auto g_temporaryFileSuffix = ".tmp";
+
+//binary levels are memory mapped, text levels are kept for editing
+static const auto g_binaryLevelExtension = ".lvl";
+//verifying the checksum reads the whole file on load
+static const bool g_verifyLevelChecksum = false;
+
+//binary levels with more tiles are stored in square chunks and paged in from disk on demand
+static const long long g_pagedLevelMinimumTiles = 4096LL * 4096LL;
+static const int g_levelChunkSize = 64;
+//resident chunks of a paged level, 16 KB each
+static const size_t g_levelChunkBudget = 2048;
+//chunks loaded ahead of the player
+static const int g_levelPrefetchDistance = 6;
+
+//player start position of every level
+static const double g_playerStartX = 22.0;
+static const double g_playerStartY = 11.5;
 
 static const int g_textureCount = 13;
 
@@ -48,8 +95,34 @@ static const std::string g_gunSprite_fire = "resources/sprites/gun_fire.png";
 static const std::string g_mainVertexShader = "resources/shaders/main.vert";
 static const std::string g_mainFragmentShader = "resources/shaders/main.frag";
 
+// Render verification
+
+static const auto g_renderReferenceDirectory = "resources/render_reference/";
+static const auto g_renderVerifyOutputDirectory = "render_verify/";
+static const int g_renderVerifyWidth = 320;
+static const int g_renderVerifyHeight = 240;
+
+// Level generator
+
+//the generator builds the whole level as one owned tile map, 8192x8192 tiles take 256 MiB
+//and still fit the 32 bit build, larger paged levels would have to be generated chunk by chunk
+static const int g_generatorMaxSize = 8192;
+static const int g_generatorMaxSprites = 100000;
+
+// Benchmarks
+
+static const unsigned int g_benchmarkSeed = 1337;
+static const auto g_benchmarkLevelFile = "benchmark_level.txt";
+//a sample of a fast benchmark repeats its body until it lasts this many microseconds
+static const int g_benchmarkMinimumSampleTime = 20;
+
 //Main menu
 
+//background particles circling the window center, rotation in degrees per millisecond
+static const int g_menuParticleCount = 200;
+static const float g_menuParticleSize = 3.0f;
+static const float g_menuParticleSpeed = 0.01f;
+
 static const auto g_mainTxtTitle = "Casual Game";
 static const auto g_mainTxtStartGame = "Start Game";
 static const auto g_mainTxtRestartGame = "Restart Game";
@@ -61,6 +134,31 @@ static const auto g_mainTxtQuit = "Quit";
 
 static const float g_editorPlayerArrowScale = 8.0f;
 static const int g_editorMenuWidth = 230;
+static const int g_editorLevelsPerPage = 6;
+//walls are batched in square chunks of tiles, only visible chunks are built and drawn
+static const int g_editorTileChunkSize = 32;
+//outline around each wall, in tiles
+static const float g_editorTileOutline = 0.06f;
+//zoom limits in pixels per tile, the initial zoom fits the whole level if the limits allow it
+static const float g_editorMinTileSize = 2.0f;
+static const float g_editorMaxTileSize = 96.0f;
+static const float g_editorZoomStep = 1.25f;
+//cell size of the grid used to pick sprites, in tiles
+static const double g_editorSpriteIndexCellSize = 4.0;
+//memory of the undo history, the oldest steps are dropped beyond it
+static const size_t g_editorJournalBudget = 4 * 1024 * 1024;
+//resolution of the 3D preview, drawn scaled up
+static const int g_editorPreviewWidth = 240;
+static const int g_editorPreviewHeight = 150;
+static const float g_editorPreviewScale = 1.5f;
+//radians the player marker turns with Q and E
+static const double g_editorPlayerTurnAngle = 0.2617993878;
+//seconds between handing the recorded edits to the autosave thread
+static const float g_editorAutosaveInterval = 2.0f;
+//the autosave log is compacted once its edits take more than this or the level snapshot
+static const size_t g_editorAutosaveCompactSize = 1024 * 1024;
+//tiles of a newly loaded level copied to the autosave thread per update, a whole line at least
+static const int g_editorAutosaveCopyTiles = 1 << 20;
 
 static const auto g_editorTxtSwitchMode = "Switch mode";
 static const auto g_editorTxtLoadDefault = "Load Default";
@@ -69,15 +167,32 @@ static const auto g_editorTxtSave = "Save";
 static const auto g_editorTxtQuit = "Back";
 static const auto g_editorTxtTexture = "Texture";
 static const auto g_editorTxtSprite = "Sprite";
-
-static const auto g_editorTxtModeWall = "Wall Mode (LMB - place, RMB - delete)";
+static const auto g_editorTxtNextPage = "More levels";
+static const auto g_editorTxtHistory = "History";
+static const auto g_editorTxtTool = "Tool";
+static const auto g_editorTxtRecover = "Recover autosave";
+static const auto g_editorTxtAutosaveOn = "Autosave on";
+static const auto g_editorTxtChangedOnDisk = "Level file changed on disk (F5 - reload it and drop the edits)";
+static const auto g_editorTxtPreview = "Tab - hide, P - place, Q/E - turn";
+static const char* const g_editorTxtToolNames[] = { "Pen", "Line", "Rectangle", "Filled rectangle", "Fill", "Region" };
+
+static const auto g_editorTxtModeWall = "Wall Mode (LMB - place, RMB - delete, T - tool)";
+static const auto g_editorTxtModeRegion = "Region Mode (LMB - select, Ctrl+C - copy, RMB/Ctrl+V - paste, R - rotate)";
 static const auto g_editorTxtModeEntity = "Entities Mode (LMB - Select/Move, RMB - place, Del - delete)";
 
 // Play state
 
 static const float g_playMinimapScale = 8.0f;
+//corner of the play view the minimap covers, in pixels, larger levels scroll inside it
+static const int g_playMinimapWidth = 256;
+static const int g_playMinimapHeight = 256;
 static const int g_playMinimapTransparency = 140;
 
+static const auto g_txtLoadingLevel = "Loading level";
+
+//threads used for the wall and floor casting, 0 uses all cores
+static const int g_raycasterThreadCount = 0;
+
 static const double g_Pi = 3.141592653589793238463;
 static const int g_playDrawDarkened = 1;
 static const int g_playhDrawHighlighted = 2;
@@ -0,0 +1,269 @@
+#include "EditJournal.h"
+
+#include <algorithm>
+
+namespace
+{
+	void writeVarint(std::vector<std::uint8_t>& out, std::uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<std::uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<std::uint8_t>(value));
+	}
+
+	std::uint32_t readVarint(const std::uint8_t*& in)
+	{
+		std::uint32_t value = 0;
+		for (int shift = 0;; shift += 7)
+		{
+			const std::uint8_t byte = *in++;
+			value |= std::uint32_t(byte & 0x7f) << shift;
+			if (byte < 0x80)
+			{
+				return value;
+			}
+		}
+	}
+
+	//small negative deltas stay small
+	std::uint32_t zigzag(const int value)
+	{
+		return (std::uint32_t(value) << 1) ^ std::uint32_t(value >> 31);
+	}
+
+	int unzigzag(const std::uint32_t value)
+	{
+		return int(value >> 1) ^ -int(value & 1);
+	}
+}
+
+EditJournal::EditJournal(const size_t budget) :
+	m_budget(budget)
+{
+	//Empty
+}
+
+void EditJournal::beginStep()
+{
+	if (m_open)
+	{
+		endStep();
+	}
+	m_open = true;
+}
+
+void EditJournal::endStep()
+{
+	if (!m_open)
+	{
+		return;
+	}
+	m_open = false;
+
+	//a tile painted back to its first value is no change
+	m_tiles.erase(std::remove_if(m_tiles.begin(), m_tiles.end(), [](const TileEdit& edit) { return edit.before == edit.after; }), m_tiles.end());
+
+	if (!m_tiles.empty() || !m_sprites.empty())
+	{
+		Step step;
+		encode(m_tiles, step);
+		step.sprites.swap(m_sprites);
+		push(m_undo, std::move(step));
+		trim();
+	}
+
+	m_tiles.clear();
+	m_tilePositions.clear();
+	m_sprites.clear();
+}
+
+void EditJournal::recordTile(const int x, const int y, const int before, const int after)
+{
+	const bool implicitStep = !m_open;
+	if (implicitStep)
+	{
+		beginStep();
+	}
+	clearRedo();
+
+	const long long key = (static_cast<long long>(x) << 32) | static_cast<std::uint32_t>(y);
+	auto found = m_tilePositions.find(key);
+	if (found != m_tilePositions.end())
+	{
+		m_tiles[found->second].after = after;
+	}
+	else
+	{
+		m_tilePositions[key] = m_tiles.size();
+		m_tiles.push_back({ x, y, 1, before, after });
+	}
+
+	if (implicitStep)
+	{
+		endStep();
+	}
+}
+
+void EditJournal::recordTiles(const std::vector<TileEdit>& runs)
+{
+	const bool implicitStep = !m_open;
+	if (implicitStep)
+	{
+		beginStep();
+	}
+	clearRedo();
+
+	m_tiles.insert(m_tiles.end(), runs.begin(), runs.end());
+
+	if (implicitStep)
+	{
+		endStep();
+	}
+}
+
+void EditJournal::recordSprite(const SpriteEdit& edit)
+{
+	const bool implicitStep = !m_open;
+	if (implicitStep)
+	{
+		beginStep();
+	}
+	clearRedo();
+
+	//repeated moves of a sprite within a step collapse into one
+	if (edit.action == SpriteAction::MOVE && !m_sprites.empty() &&
+		m_sprites.back().action == SpriteAction::MOVE && m_sprites.back().index == edit.index)
+	{
+		m_sprites.back().after = edit.after;
+	}
+	else
+	{
+		m_sprites.push_back(edit);
+	}
+
+	if (implicitStep)
+	{
+		endStep();
+	}
+}
+
+bool EditJournal::undo(std::vector<TileEdit>& tiles, std::vector<SpriteEdit>& sprites)
+{
+	endStep();
+	if (m_undo.empty())
+	{
+		return false;
+	}
+
+	Step step = std::move(m_undo.back());
+	m_undo.pop_back();
+	m_bytes -= step.getMemoryUsage();
+
+	decode(step, tiles);
+	sprites = step.sprites;
+
+	push(m_redo, std::move(step));
+	return true;
+}
+
+bool EditJournal::redo(std::vector<TileEdit>& tiles, std::vector<SpriteEdit>& sprites)
+{
+	endStep();
+	if (m_redo.empty())
+	{
+		return false;
+	}
+
+	Step step = std::move(m_redo.back());
+	m_redo.pop_back();
+	m_bytes -= step.getMemoryUsage();
+
+	decode(step, tiles);
+	sprites = step.sprites;
+
+	push(m_undo, std::move(step));
+	return true;
+}
+
+void EditJournal::clear()
+{
+	m_undo.clear();
+	m_redo.clear();
+	m_bytes = 0;
+
+	m_open = false;
+	m_tiles.clear();
+	m_tilePositions.clear();
+	m_sprites.clear();
+}
+
+void EditJournal::push(std::deque<Step>& steps, Step step)
+{
+	m_bytes += step.getMemoryUsage();
+	steps.push_back(std::move(step));
+}
+
+void EditJournal::clearRedo()
+{
+	for (auto& step : m_redo)
+	{
+		m_bytes -= step.getMemoryUsage();
+	}
+	m_redo.clear();
+}
+
+void EditJournal::trim()
+{
+	//the newest step is always kept, even if it alone is over budget
+	while (m_bytes > m_budget && m_undo.size() > 1)
+	{
+		m_bytes -= m_undo.front().getMemoryUsage();
+		m_undo.pop_front();
+	}
+}
+
+size_t EditJournal::Step::getMemoryUsage() const
+{
+	return sizeof(Step) + tiles.capacity() + sprites.capacity() * sizeof(SpriteEdit);
+}
+
+void EditJournal::encode(const std::vector<TileEdit>& tiles, Step& step)
+{
+	//positions relative to the previous run, values as they are
+	int lastX = 0;
+	int lastY = 0;
+	for (auto& tile : tiles)
+	{
+		writeVarint(step.tiles, zigzag(tile.x - lastX));
+		writeVarint(step.tiles, zigzag(tile.y - lastY));
+		writeVarint(step.tiles, std::uint32_t(tile.length));
+		writeVarint(step.tiles, zigzag(tile.before));
+		writeVarint(step.tiles, zigzag(tile.after));
+		lastX = tile.x;
+		lastY = tile.y;
+	}
+	step.runCount = tiles.size();
+	step.tiles.shrink_to_fit();
+}
+
+void EditJournal::decode(const Step& step, std::vector<TileEdit>& tiles)
+{
+	tiles.clear();
+	tiles.reserve(step.runCount);
+
+	const std::uint8_t* in = step.tiles.data();
+	int x = 0;
+	int y = 0;
+	for (size_t i = 0; i < step.runCount; i++)
+	{
+		x += unzigzag(readVarint(in));
+		y += unzigzag(readVarint(in));
+		const int length = int(readVarint(in));
+		const int before = unzigzag(readVarint(in));
+		const int after = unzigzag(readVarint(in));
+		tiles.push_back({ x, y, length, before, after });
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "Sprite.h"
+
+// Undo and redo history of the level editor.
+// Edits are recorded as deltas between beginStep() and endStep(), a paint stroke is one step.
+// Tiles edited twice in a step keep their first value, finished steps store their tile runs
+// varint encoded relative to the previous run, so a stroke costs a few bytes per tile
+// and a filled area a few bytes per line.
+// The oldest steps are dropped once the history exceeds its memory budget.
+class EditJournal
+{
+public:
+
+	// length tiles of line x from column y on
+	struct TileEdit
+	{
+		int x;
+		int y;
+		int length;
+		int before;
+		int after;
+	};
+
+	enum class SpriteAction
+	{
+		CREATE,
+		MOVE,
+		REMOVE
+	};
+
+	struct SpriteEdit
+	{
+		SpriteAction action;
+		int index;
+		Sprite before; //unused for CREATE
+		Sprite after; //unused for REMOVE
+	};
+
+	explicit EditJournal(const size_t budget);
+	virtual ~EditJournal() = default;
+
+	void beginStep();
+	// steps without a change are not kept
+	void endStep();
+	bool isStepOpen() const { return m_open; }
+
+	// the edit was already applied to the level, clears the redo history
+	void recordTile(const int x, const int y, const int before, const int after);
+	// runs of a batched edit, they are not coalesced with other edits of the step
+	void recordTiles(const std::vector<TileEdit>& runs);
+	void recordSprite(const SpriteEdit& edit);
+
+	// the edits of the step to revert or apply again, in the order they were recorded,
+	// tiles may repeat and have to be reverted in reverse order.
+	// returns false if there is nothing to undo or redo
+	bool undo(std::vector<TileEdit>& tiles, std::vector<SpriteEdit>& sprites);
+	bool redo(std::vector<TileEdit>& tiles, std::vector<SpriteEdit>& sprites);
+
+	void clear();
+
+	size_t getUndoCount() const { return m_undo.size(); }
+	size_t getRedoCount() const { return m_redo.size(); }
+	size_t getMemoryUsage() const { return m_bytes; }
+
+private:
+
+	struct Step
+	{
+		size_t runCount = 0;
+		std::vector<std::uint8_t> tiles;
+		std::vector<SpriteEdit> sprites;
+
+		size_t getMemoryUsage() const;
+	};
+
+	size_t m_budget;
+	size_t m_bytes = 0;
+
+	std::deque<Step> m_undo;
+	std::deque<Step> m_redo;
+
+	//edits of the open step, tiles are found by position for coalescing
+	bool m_open = false;
+	std::vector<TileEdit> m_tiles;
+	std::unordered_map<long long, size_t> m_tilePositions;
+	std::vector<SpriteEdit> m_sprites;
+
+	void push(std::deque<Step>& steps, Step step);
+	void clearRedo();
+	void trim();
+
+	static void encode(const std::vector<TileEdit>& tiles, Step& step);
+	static void decode(const Step& step, std::vector<TileEdit>& tiles);
+};
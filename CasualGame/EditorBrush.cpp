@@ -0,0 +1,227 @@
+#include "EditorBrush.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <initializer_list>
+#include <utility>
+
+void EditorBrush::line(const int x0, const int y0, const int x1, const int y1, const int value, std::vector<TileRun>& runs)
+{
+	//Bresenham, steps along the lines merge into runs
+	const int dx = std::abs(x1 - x0);
+	const int dy = -std::abs(y1 - y0);
+	const int stepX = x0 < x1 ? 1 : -1;
+	const int stepY = y0 < y1 ? 1 : -1;
+	int error = dx + dy;
+
+	int x = x0;
+	int y = y0;
+	while (true)
+	{
+		append(runs, x, y, 1, value);
+		if (x == x1 && y == y1)
+		{
+			break;
+		}
+
+		const int error2 = 2 * error;
+		if (error2 >= dy)
+		{
+			error += dy;
+			x += stepX;
+		}
+		if (error2 <= dx)
+		{
+			error += dx;
+			y += stepY;
+		}
+	}
+}
+
+void EditorBrush::rectangle(const int x0, const int y0, const int x1, const int y1, const bool filled, const int value, std::vector<TileRun>& runs)
+{
+	const int firstX = std::min(x0, x1);
+	const int lastX = std::max(x0, x1);
+	const int firstY = std::min(y0, y1);
+	const int lastY = std::max(y0, y1);
+	const int length = lastY - firstY + 1;
+
+	for (int x = firstX; x <= lastX; x++)
+	{
+		if (filled || x == firstX || x == lastX)
+		{
+			runs.push_back({ x, firstY, length, value });
+		}
+		else
+		{
+			runs.push_back({ x, firstY, 1, value });
+			if (lastY != firstY)
+			{
+				runs.push_back({ x, lastY, 1, value });
+			}
+		}
+	}
+}
+
+void EditorBrush::floodFill(const TileMap& level, const int x, const int y, const int value, std::vector<TileRun>& runs)
+{
+	if (!level.contains(x, y))
+	{
+		return;
+	}
+
+	const int target = level.get(x, y);
+	if (target == value)
+	{
+		return;
+	}
+
+	//each seed is filled to the ends of its line, the lines above and below are seeded once per
+	//stretch of target tiles, so the stack stays small even for a whole 4096x4096 level
+	const int sizeX = level.getSizeX();
+	const int sizeY = level.getSizeY();
+	std::vector<std::uint8_t> filled(static_cast<size_t>(sizeX) * sizeY, 0);
+	auto isTarget = [&](const int tx, const int ty)
+	{
+		return !filled[static_cast<size_t>(tx) * sizeY + ty] && level.get(tx, ty) == target;
+	};
+
+	std::vector<std::pair<int, int> > seeds;
+	seeds.emplace_back(x, y);
+	while (!seeds.empty())
+	{
+		const auto seed = seeds.back();
+		seeds.pop_back();
+
+		const int line = seed.first;
+		if (!isTarget(line, seed.second))
+		{
+			continue;
+		}
+
+		int first = seed.second;
+		while (first > 0 && isTarget(line, first - 1))
+		{
+			first--;
+		}
+		int last = seed.second;
+		while (last < sizeY - 1 && isTarget(line, last + 1))
+		{
+			last++;
+		}
+
+		std::fill(filled.begin() + static_cast<size_t>(line) * sizeY + first, filled.begin() + static_cast<size_t>(line) * sizeY + last + 1, 1);
+		runs.push_back({ line, first, last - first + 1, value });
+
+		//a fill across a paged level would otherwise keep every chunk it touched
+		level.trim();
+
+		for (int next : { line - 1, line + 1 })
+		{
+			if (next < 0 || next >= sizeX)
+			{
+				continue;
+			}
+
+			bool inStretch = false;
+			for (int column = first; column <= last; column++)
+			{
+				const bool matches = isTarget(next, column);
+				if (matches && !inStretch)
+				{
+					seeds.emplace_back(next, column);
+				}
+				inStretch = matches;
+			}
+		}
+	}
+}
+
+TileRegion EditorBrush::copy(const TileMap& level, const int x0, const int y0, const int x1, const int y1)
+{
+	const int firstX = std::max(std::min(x0, x1), 0);
+	const int lastX = std::min(std::max(x0, x1), level.getSizeX() - 1);
+	const int firstY = std::max(std::min(y0, y1), 0);
+	const int lastY = std::min(std::max(y0, y1), level.getSizeY() - 1);
+
+	TileRegion region;
+	if (firstX > lastX || firstY > lastY)
+	{
+		return region;
+	}
+
+	region.sizeX = lastX - firstX + 1;
+	region.sizeY = lastY - firstY + 1;
+	region.tiles.reserve(static_cast<size_t>(region.sizeX) * region.sizeY);
+	for (int x = firstX; x <= lastX; x++)
+	{
+		for (int y = firstY; y <= lastY; y++)
+		{
+			region.tiles.push_back(level.get(x, y));
+		}
+		level.trim();
+	}
+
+	return region;
+}
+
+TileRegion EditorBrush::rotate(const TileRegion& region)
+{
+	//lines are drawn top to bottom and columns left to right, so the columns become the lines
+	TileRegion rotated;
+	rotated.sizeX = region.sizeY;
+	rotated.sizeY = region.sizeX;
+	rotated.tiles.resize(region.tiles.size());
+
+	for (int x = 0; x < region.sizeX; x++)
+	{
+		for (int y = 0; y < region.sizeY; y++)
+		{
+			rotated.tiles[static_cast<size_t>(y) * rotated.sizeY + (region.sizeX - 1 - x)] = region.tiles[static_cast<size_t>(x) * region.sizeY + y];
+		}
+	}
+
+	rotated.sprites.reserve(region.sprites.size());
+	for (auto sprite : region.sprites)
+	{
+		const double x = sprite.x;
+		sprite.x = sprite.y;
+		sprite.y = region.sizeX - x;
+		rotated.sprites.push_back(sprite);
+	}
+
+	return rotated;
+}
+
+void EditorBrush::paste(const TileRegion& region, const TileMap& level, const int x, const int y, std::vector<TileRun>& runs)
+{
+	const int firstY = std::max(y, 0);
+	const int endY = std::min(y + region.sizeY, level.getSizeY());
+	for (int line = 0; line < region.sizeX; line++)
+	{
+		if (x + line < 0 || x + line >= level.getSizeX())
+		{
+			continue;
+		}
+
+		const auto tiles = region.tiles.data() + static_cast<size_t>(line) * region.sizeY;
+		for (int column = firstY; column < endY; column++)
+		{
+			append(runs, x + line, column, 1, tiles[column - y]);
+		}
+	}
+}
+
+void EditorBrush::append(std::vector<TileRun>& runs, const int x, const int y, const int length, const int value)
+{
+	if (!runs.empty())
+	{
+		auto& last = runs.back();
+		if (last.x == x && last.value == value && last.y + last.length == y)
+		{
+			last.length += length;
+			return;
+		}
+	}
+	runs.push_back({ x, y, length, value });
+}
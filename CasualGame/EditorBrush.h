@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Sprite.h"
+#include "TileMap.h"
+
+// rectangular part of a level, sprite positions are relative to its first line and column
+struct TileRegion
+{
+	int sizeX = 0;
+	int sizeY = 0;
+	std::vector<std::int32_t> tiles;
+	std::vector<Sprite> sprites;
+
+	bool empty() const { return sizeX == 0 || sizeY == 0; }
+};
+
+// Bulk tile operations of the level editor.
+// Shapes are produced as runs along the level lines, the editor applies and records
+// a whole shape as one batch instead of one edit per tile.
+// Coordinates are level ones: x is the line, y the column.
+class EditorBrush
+{
+public:
+
+	// the tiles from one end to the other, both included
+	static void line(const int x0, const int y0, const int x1, const int y1, const int value, std::vector<TileRun>& runs);
+	// corners in any order, hollow rectangles only have their border
+	static void rectangle(const int x0, const int y0, const int x1, const int y1, const bool filled, const int value, std::vector<TileRun>& runs);
+	// the 4-connected area of tiles equal to the one at x, y, filled line by line
+	static void floodFill(const TileMap& level, const int x, const int y, const int value, std::vector<TileRun>& runs);
+
+	// corners in any order, clipped to the level
+	static TileRegion copy(const TileMap& level, const int x0, const int y0, const int x1, const int y1);
+	// a quarter turn clockwise as seen in the editor
+	static TileRegion rotate(const TileRegion& region);
+	// the region with its first tile at x, y, clipped to the level
+	static void paste(const TileRegion& region, const TileMap& level, const int x, const int y, std::vector<TileRun>& runs);
+
+private:
+
+	// extends the last run if the tile continues it
+	static void append(std::vector<TileRun>& runs, const int x, const int y, const int length, const int value);
+};
@@ -0,0 +1,206 @@
+#include "EditorPreview.h"
+
+#include "GLRaycaster.h"
+#include "LevelReaderWriter.h"
+#include "Player.h"
+#include "Sprite.h"
+
+#include <algorithm>
+#include <cmath>
+
+EditorPreview::EditorPreview(const int width, const int height, std::shared_ptr<Player> player, std::shared_ptr<LevelReaderWriter> levelReader) :
+	m_width(width),
+	m_height(height),
+	m_player(move(player)),
+	m_dirty(width, true)
+{
+	//a few columns are rendered at a time, threads would cost more than they save
+	m_raycaster = std::make_unique<GLRaycaster>();
+	m_raycaster->initialize(width, height, m_player, move(levelReader), true);
+	m_raycaster->setThreadCount(1);
+
+	m_pixels.resize(static_cast<size_t>(width) * height * 4, 255);
+	m_texture.create(width, height);
+	m_sprite.setTexture(m_texture);
+
+	m_frame.setSize(sf::Vector2f(float(width), float(height)));
+	m_frame.setFillColor(sf::Color::Transparent);
+	m_frame.setOutlineColor(sf::Color::Black);
+
+	std::fill(std::begin(m_pose), std::end(m_pose), 0.0);
+}
+
+EditorPreview::~EditorPreview() = default;
+
+void EditorPreview::setPosition(const sf::Vector2f& position, const float scale)
+{
+	m_sprite.setPosition(position);
+	m_sprite.setScale(scale, scale);
+	m_frame.setPosition(position);
+	m_frame.setScale(scale, scale);
+	m_frame.setOutlineThickness(1.0f / scale);
+}
+
+void EditorPreview::invalidate()
+{
+	std::fill(m_dirty.begin(), m_dirty.end(), true);
+	m_anyDirty = true;
+}
+
+void EditorPreview::invalidateArea(const int x, const int y, const int sizeX, const int sizeY)
+{
+	//the area covers the columns between its projected corners, a column only
+	//changes if the area is nearer than the wall the column hit
+	const double cornersX[] = { double(x), double(x + sizeX) };
+	const double cornersY[] = { double(y), double(y + sizeY) };
+
+	double first = m_width;
+	double last = -1.0;
+	double nearest = 0.0;
+	int behind = 0;
+	for (auto cornerX : cornersX)
+	{
+		for (auto cornerY : cornersY)
+		{
+			double column;
+			double depth;
+			if (!project(cornerX, cornerY, column, depth))
+			{
+				behind++;
+				continue;
+			}
+
+			nearest = last < 0.0 ? depth : std::min(nearest, depth);
+			first = std::min(first, column);
+			last = std::max(last, column);
+		}
+	}
+
+	if (behind == 4)
+	{
+		return;
+	}
+	if (behind > 0)
+	{
+		//the area reaches behind the camera, its projection is unbounded
+		markColumns(0, m_width - 1, 0.0);
+		return;
+	}
+
+	markColumns(int(std::floor(first)), int(std::ceil(last)), nearest);
+}
+
+void EditorPreview::invalidateSprite(const Sprite& sprite)
+{
+	//same extent calculateSprites() draws
+	double column;
+	double depth;
+	if (!project(sprite.x, sprite.y, column, depth))
+	{
+		return;
+	}
+
+	const int halfWidth = std::abs(int(m_height / depth)) / 2;
+	markColumns(int(column) - halfWidth - 1, int(column) + halfWidth + 1, 0.0);
+}
+
+int EditorPreview::update()
+{
+	const double pose[] = { m_player->m_posX, m_player->m_posY, m_player->m_dirX, m_player->m_dirY, m_player->m_planeX, m_player->m_planeY };
+	if (!std::equal(std::begin(pose), std::end(pose), std::begin(m_pose)))
+	{
+		std::copy(std::begin(pose), std::end(pose), std::begin(m_pose));
+		invalidate();
+	}
+
+	if (!m_anyDirty)
+	{
+		return 0;
+	}
+
+	//contiguous dirty columns are rendered and uploaded together
+	int rendered = 0;
+	for (int first = 0; first < m_width; first++)
+	{
+		if (!m_dirty[first])
+		{
+			continue;
+		}
+
+		int last = first;
+		while (last + 1 < m_width && m_dirty[last + 1])
+		{
+			last++;
+		}
+
+		renderColumns(first, last);
+		rendered += last - first + 1;
+		first = last;
+	}
+
+	std::fill(m_dirty.begin(), m_dirty.end(), false);
+	m_anyDirty = false;
+	return rendered;
+}
+
+bool EditorPreview::project(const double x, const double y, double& column, double& depth) const
+{
+	//camera space transform of GLRaycaster::calculateSprites()
+	const double relativeX = x - m_player->m_posX;
+	const double relativeY = y - m_player->m_posY;
+
+	const double invDet = 1.0 / (m_player->m_planeX * m_player->m_dirY - m_player->m_dirX * m_player->m_planeY);
+	const double transformX = invDet * (m_player->m_dirY * relativeX - m_player->m_dirX * relativeY);
+	depth = invDet * (-m_player->m_planeY * relativeX + m_player->m_planeX * relativeY);
+	if (depth <= 1e-6)
+	{
+		return false;
+	}
+
+	column = (m_width / 2) * (1.0 + transformX / depth);
+	return true;
+}
+
+void EditorPreview::markColumns(const int first, const int last, const double depth)
+{
+	const auto& zBuffer = m_raycaster->getZBuffer();
+	for (int x = std::max(first, 0); x <= std::min(last, m_width - 1); x++)
+	{
+		if (!m_dirty[x] && depth <= zBuffer[x] + 1e-6)
+		{
+			m_dirty[x] = true;
+			m_anyDirty = true;
+		}
+	}
+}
+
+void EditorPreview::renderColumns(const int first, const int last)
+{
+	m_raycaster->renderColumns(first, last + 1);
+
+	//the texture is updated with the columns packed into a smaller image
+	const int width = last - first + 1;
+	const auto& buffer = m_raycaster->getBuffer();
+	for (int y = 0; y < m_height; y++)
+	{
+		auto source = buffer.data() + (static_cast<size_t>(y) * m_width + first) * 3;
+		auto destination = m_pixels.data() + static_cast<size_t>(y) * width * 4;
+		for (int x = 0; x < width; x++)
+		{
+			destination[0] = source[0];
+			destination[1] = source[1];
+			destination[2] = source[2];
+			destination[3] = 255;
+			source += 3;
+			destination += 4;
+		}
+	}
+
+	m_texture.update(m_pixels.data(), width, m_height, first, 0);
+}
+
+void EditorPreview::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	target.draw(m_sprite, states);
+	target.draw(m_frame, states);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <vector>
+
+class GLRaycaster;
+class LevelReaderWriter;
+struct Player;
+struct Sprite;
+
+// Low resolution view from the player marker shown inside the level editor.
+// Rendered on the CPU by a headless raycaster and uploaded to a texture.
+// An edit only marks the screen columns its tiles or sprite project to, update() renders
+// and uploads just those, a moved player marker renders the whole view again.
+class EditorPreview : public sf::Drawable
+{
+public:
+	EditorPreview(const int width, const int height, std::shared_ptr<Player> player, std::shared_ptr<LevelReaderWriter> levelReader);
+	virtual ~EditorPreview();
+
+	void setPosition(const sf::Vector2f& position, const float scale);
+	// screen area covered by the preview
+	sf::FloatRect getBounds() const { return m_frame.getGlobalBounds(); }
+
+	// the whole view is rendered on the next update
+	void invalidate();
+	// tiles of sizeX lines and sizeY columns from line x, column y on changed
+	void invalidateArea(const int x, const int y, const int sizeX, const int sizeY);
+	// a sprite at this position appeared, moved away or disappeared
+	void invalidateSprite(const Sprite& sprite);
+
+	// renders the marked columns, returns how many were rendered
+	int update();
+
+private:
+
+	int m_width;
+	int m_height;
+	std::shared_ptr<Player> m_player;
+	std::unique_ptr<GLRaycaster> m_raycaster;
+
+	//pose the view was rendered from
+	double m_pose[6];
+
+	std::vector<bool> m_dirty;
+	bool m_anyDirty = true;
+
+	//RGBA copy of the columns uploaded to the texture
+	std::vector<sf::Uint8> m_pixels;
+	sf::Texture m_texture;
+	sf::Sprite m_sprite;
+	sf::RectangleShape m_frame;
+
+	// screen column and depth of a level position, false behind the camera
+	bool project(const double x, const double y, double& column, double& depth) const;
+	void markColumns(const int first, const int last, const double depth);
+	void renderColumns(const int first, const int last);
+
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
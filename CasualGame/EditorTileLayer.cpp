@@ -0,0 +1,148 @@
+#include "EditorTileLayer.h"
+
+#include "LevelReaderWriter.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//tiles 1 to 8 are walls, drawn with textures 0 to 7
+	const int wallTextureCount = 8;
+}
+
+EditorTileLayer::EditorTileLayer(std::shared_ptr<LevelReaderWriter> levelReader) :
+	m_levelReader(move(levelReader))
+{
+	reset();
+}
+
+void EditorTileLayer::reset()
+{
+	const auto& level = m_levelReader->getLevel();
+	m_chunksX = (level.getSizeX() + g_editorTileChunkSize - 1) / g_editorTileChunkSize;
+	m_chunksY = (level.getSizeY() + g_editorTileChunkSize - 1) / g_editorTileChunkSize;
+
+	m_chunks.clear();
+	m_chunks.resize(size_t(m_chunksX) * m_chunksY);
+}
+
+void EditorTileLayer::invalidate(const int x, const int y)
+{
+	const int chunkX = x / g_editorTileChunkSize;
+	const int chunkY = y / g_editorTileChunkSize;
+	if (x >= 0 && y >= 0 && chunkX < m_chunksX && chunkY < m_chunksY)
+	{
+		m_chunks[size_t(chunkX) * m_chunksY + chunkY].dirty = true;
+	}
+}
+
+void EditorTileLayer::invalidate(const int x, const int y, const int sizeX, const int sizeY)
+{
+	const int firstX = std::max(x, 0) / g_editorTileChunkSize;
+	const int firstY = std::max(y, 0) / g_editorTileChunkSize;
+	const int lastX = std::min((x + sizeX - 1) / g_editorTileChunkSize, m_chunksX - 1);
+	const int lastY = std::min((y + sizeY - 1) / g_editorTileChunkSize, m_chunksY - 1);
+	for (int chunkX = firstX; chunkX <= lastX; chunkX++)
+	{
+		for (int chunkY = firstY; chunkY <= lastY; chunkY++)
+		{
+			m_chunks[size_t(chunkX) * m_chunksY + chunkY].dirty = true;
+		}
+	}
+}
+
+void EditorTileLayer::setColors(const sf::Color& wall, const sf::Color& outline)
+{
+	if (wall == m_wallColor && outline == m_outlineColor)
+	{
+		return;
+	}
+
+	m_wallColor = wall;
+	m_outlineColor = outline;
+	for (auto& chunk : m_chunks)
+	{
+		chunk.dirty = true;
+	}
+}
+
+void EditorTileLayer::draw(sf::RenderTarget& target, const sf::FloatRect& visible)
+{
+	//the screen x axis runs along the level columns
+	const float chunkSize = float(g_editorTileChunkSize);
+	const int firstX = std::max(int(std::floor(visible.top / chunkSize)), 0);
+	const int firstY = std::max(int(std::floor(visible.left / chunkSize)), 0);
+	const int lastX = std::min(int(std::floor((visible.top + visible.height) / chunkSize)), m_chunksX - 1);
+	const int lastY = std::min(int(std::floor((visible.left + visible.width) / chunkSize)), m_chunksY - 1);
+
+	for (int chunkX = firstX; chunkX <= lastX; chunkX++)
+	{
+		for (int chunkY = firstY; chunkY <= lastY; chunkY++)
+		{
+			auto& chunk = m_chunks[size_t(chunkX) * m_chunksY + chunkY];
+			if (chunk.dirty)
+			{
+				build(chunk, chunkX, chunkY);
+			}
+
+			target.draw(chunk.outlines);
+			for (int i = 0; i < wallTextureCount; i++)
+			{
+				if (chunk.walls[i].getVertexCount() > 0)
+				{
+					target.draw(chunk.walls[i], m_levelReader->getTextureSfml(i));
+				}
+			}
+		}
+	}
+}
+
+void EditorTileLayer::build(Chunk& chunk, const int chunkX, const int chunkY)
+{
+	const auto& level = m_levelReader->getLevel();
+	const sf::FloatRect textureRect(0.0f, 0.0f, float(g_textureWidth), float(g_textureHeight));
+
+	chunk.outlines.clear();
+	chunk.walls.resize(wallTextureCount, sf::VertexArray(sf::Quads));
+	for (auto& walls : chunk.walls)
+	{
+		walls.clear();
+	}
+
+	const int endX = std::min((chunkX + 1) * g_editorTileChunkSize, level.getSizeX());
+	const int endY = std::min((chunkY + 1) * g_editorTileChunkSize, level.getSizeY());
+	for (int x = chunkX * g_editorTileChunkSize; x < endX; x++)
+	{
+		for (int y = chunkY * g_editorTileChunkSize; y < endY; y++)
+		{
+			const auto id = level.get(x, y);
+			if (id > 0 && id <= wallTextureCount)
+			{
+				appendQuad(chunk.outlines, sf::FloatRect(float(y), float(x), 1.0f, 1.0f), m_outlineColor);
+
+				const float inset = g_editorTileOutline;
+				appendQuad(chunk.walls[id - 1], sf::FloatRect(y + inset, x + inset, 1.0f - 2.0f * inset, 1.0f - 2.0f * inset), m_wallColor, textureRect);
+			}
+		}
+	}
+
+	chunk.dirty = false;
+
+	//zoomed out views build many chunks of a paged level in one frame
+	level.trim();
+}
+
+void EditorTileLayer::appendQuad(sf::VertexArray& vertices, const sf::FloatRect& rect, const sf::Color& color, const sf::FloatRect& textureRect)
+{
+	const float right = rect.left + rect.width;
+	const float bottom = rect.top + rect.height;
+	const float textureRight = textureRect.left + textureRect.width;
+	const float textureBottom = textureRect.top + textureRect.height;
+
+	vertices.append(sf::Vertex({ rect.left, rect.top }, color, { textureRect.left, textureRect.top }));
+	vertices.append(sf::Vertex({ right, rect.top }, color, { textureRight, textureRect.top }));
+	vertices.append(sf::Vertex({ right, bottom }, color, { textureRight, textureBottom }));
+	vertices.append(sf::Vertex({ rect.left, bottom }, color, { textureRect.left, textureBottom }));
+}
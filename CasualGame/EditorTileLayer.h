@@ -0,0 +1,52 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <vector>
+
+class LevelReaderWriter;
+
+// Wall tiles of the level editor, batched into one vertex array per wall texture and chunk.
+// Vertices are in tile units: one tile is 1x1, x is the level column and y the level line.
+// Only chunks touching the visible area are built and drawn, a chunk is rebuilt after it was invalidated.
+class EditorTileLayer
+{
+public:
+	explicit EditorTileLayer(std::shared_ptr<LevelReaderWriter> levelReader);
+	virtual ~EditorTileLayer() = default;
+
+	// the level was replaced, every chunk is rebuilt
+	void reset();
+	// the tile at level line x, column y changed
+	void invalidate(const int x, const int y);
+	// the tiles of sizeX lines and sizeY columns from line x, column y on changed
+	void invalidate(const int x, const int y, const int sizeX, const int sizeY);
+	// colors of the wall and its outline, rebuilds every chunk
+	void setColors(const sf::Color& wall, const sf::Color& outline);
+
+	// visible is in tile units, the target's view has to use them too
+	void draw(sf::RenderTarget& target, const sf::FloatRect& visible);
+
+	// appends a quad covering rect, texture coordinates are left at 0 without a texture rect
+	static void appendQuad(sf::VertexArray& vertices, const sf::FloatRect& rect, const sf::Color& color, const sf::FloatRect& textureRect = sf::FloatRect());
+
+private:
+
+	struct Chunk
+	{
+		bool dirty = true;
+		sf::VertexArray outlines{ sf::Quads };
+		std::vector<sf::VertexArray> walls;
+	};
+
+	std::shared_ptr<LevelReaderWriter> m_levelReader;
+
+	int m_chunksX = 0;
+	int m_chunksY = 0;
+	std::vector<Chunk> m_chunks;
+
+	sf::Color m_wallColor = sf::Color::White;
+	sf::Color m_outlineColor = sf::Color::Black;
+
+	void build(Chunk& chunk, const int chunkX, const int chunkY);
+};
@@ -0,0 +1,225 @@
+#include "FileWatcher.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <filesystem>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+namespace
+{
+	//size of the change notification buffer
+	const size_t bufferBytes = 64 * 1024;
+}
+
+FileWatcher::FileWatcher(const std::string& directory) :
+	m_directory(directory)
+{
+	m_handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (m_handle == INVALID_HANDLE_VALUE)
+	{
+		m_handle = nullptr;
+		std::cout << "Could not watch " << directory << std::endl;
+		return;
+	}
+
+	auto overlapped = new OVERLAPPED();
+	overlapped->hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	m_overlapped = overlapped;
+
+	m_buffer.resize(bufferBytes / sizeof(unsigned long));
+	issueRead();
+}
+
+FileWatcher::~FileWatcher()
+{
+	if (m_handle)
+	{
+		//the pending read has to finish before its buffer goes away
+		auto overlapped = static_cast<OVERLAPPED*>(m_overlapped);
+		DWORD bytes;
+		CancelIo(m_handle);
+		GetOverlappedResult(m_handle, overlapped, &bytes, TRUE);
+
+		CloseHandle(overlapped->hEvent);
+		delete overlapped;
+		CloseHandle(m_handle);
+	}
+}
+
+bool FileWatcher::isWatching() const
+{
+	return m_handle != nullptr;
+}
+
+bool FileWatcher::issueRead()
+{
+	auto overlapped = static_cast<OVERLAPPED*>(m_overlapped);
+	ResetEvent(overlapped->hEvent);
+
+	const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+	return ReadDirectoryChangesW(m_handle, m_buffer.data(), DWORD(bufferBytes), TRUE, filter, nullptr, overlapped, nullptr) != 0;
+}
+
+std::vector<std::string> FileWatcher::wait(const int timeoutMs)
+{
+	std::vector<std::string> changes;
+	if (!m_handle)
+	{
+		Sleep(timeoutMs);
+		return changes;
+	}
+
+	auto overlapped = static_cast<OVERLAPPED*>(m_overlapped);
+	if (WaitForSingleObject(overlapped->hEvent, DWORD(timeoutMs)) != WAIT_OBJECT_0)
+	{
+		return changes;
+	}
+
+	DWORD bytes = 0;
+	if (GetOverlappedResult(m_handle, overlapped, &bytes, FALSE) && bytes == 0)
+	{
+		std::cout << "Too many file changes in " << m_directory << ", some were missed" << std::endl;
+	}
+
+	auto data = reinterpret_cast<const unsigned char*>(m_buffer.data());
+	for (DWORD offset = 0; bytes > 0;)
+	{
+		auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data + offset);
+
+		if (info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+		{
+			const int length = int(info->FileNameLength / sizeof(WCHAR));
+			const int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, nullptr, 0, nullptr, nullptr);
+			std::string name(size, '\0');
+			WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, &name[0], size, nullptr, nullptr);
+
+			for (auto& c : name)
+			{
+				if (c == '\\') c = '/';
+			}
+			changes.push_back(m_directory + name);
+		}
+
+		if (info->NextEntryOffset == 0)
+		{
+			break;
+		}
+		offset += info->NextEntryOffset;
+	}
+
+	issueRead();
+	return changes;
+}
+
+#else
+
+namespace fs = std::tr2::sys;
+
+FileWatcher::FileWatcher(const std::string& directory) :
+	m_directory(directory)
+{
+	m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_fd < 0)
+	{
+		std::cout << "Could not watch " << directory << std::endl;
+		return;
+	}
+
+	//inotify watches single directories
+	addWatch(directory);
+	if (fs::is_directory(fs::path(directory)))
+	{
+		for (auto it = fs::recursive_directory_iterator(fs::path(directory)); it != fs::recursive_directory_iterator(); ++it)
+		{
+			if (fs::is_directory(it->path()))
+			{
+				addWatch(it->path().string() + "/");
+			}
+		}
+	}
+}
+
+FileWatcher::~FileWatcher()
+{
+	if (m_fd >= 0)
+	{
+		close(m_fd);
+	}
+}
+
+bool FileWatcher::isWatching() const
+{
+	return m_fd >= 0 && !m_watches.empty();
+}
+
+void FileWatcher::addWatch(const std::string& directory)
+{
+	const int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM);
+	if (wd >= 0)
+	{
+		m_watches[wd] = directory;
+	}
+}
+
+std::vector<std::string> FileWatcher::wait(const int timeoutMs)
+{
+	std::vector<std::string> changes;
+	if (m_fd < 0)
+	{
+		usleep(timeoutMs * 1000);
+		return changes;
+	}
+
+	pollfd descriptor = { m_fd, POLLIN, 0 };
+	if (poll(&descriptor, 1, timeoutMs) <= 0)
+	{
+		return changes;
+	}
+
+	alignas(inotify_event) char buffer[16 * 1024];
+	ssize_t length;
+	while ((length = read(m_fd, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* pos = buffer; pos < buffer + length;)
+		{
+			auto event = reinterpret_cast<const inotify_event*>(pos);
+			pos += sizeof(inotify_event) + event->len;
+
+			auto watch = m_watches.find(event->wd);
+			if (watch == m_watches.end() || event->len == 0)
+			{
+				continue;
+			}
+
+			const auto path = watch->second + event->name;
+			if (event->mask & IN_ISDIR)
+			{
+				//new directories are watched as well
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					addWatch(path + "/");
+				}
+			}
+			else if ((event->mask & IN_CREATE) == 0)
+			{
+				//created files are reported once they are written
+				changes.push_back(path);
+			}
+		}
+	}
+
+	return changes;
+}
+
+#endif
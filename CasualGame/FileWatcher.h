@@ -0,0 +1,40 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Reports the files changed below a directory, including its subdirectories.
+// Uses ReadDirectoryChangesW on Windows and inotify elsewhere.
+class FileWatcher
+{
+public:
+	// the directory has to end with a slash, reported paths start with it
+	explicit FileWatcher(const std::string& directory);
+	virtual ~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	bool isWatching() const;
+
+	// blocks up to timeoutMs for changes, returns the written, created, renamed or removed files
+	std::vector<std::string> wait(const int timeoutMs);
+
+private:
+
+	std::string m_directory;
+
+#ifdef _WIN32
+	void* m_handle = nullptr;
+	void* m_overlapped = nullptr;
+	std::vector<unsigned long> m_buffer;
+
+	bool issueRead();
+#else
+	int m_fd = -1;
+	std::map<int, std::string> m_watches;
+
+	void addWatch(const std::string& directory);
+#endif
+};
@@ -0,0 +1,137 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+FramePacer::FramePacer(const int targetFramerate, const sf::Int64 spinMicroseconds) :
+	m_spinMicroseconds(spinMicroseconds)
+{
+	setTargetFramerate(targetFramerate);
+	resetStatistics();
+}
+
+void FramePacer::setTargetFramerate(const int targetFramerate)
+{
+	m_targetFramerate = std::max(targetFramerate, 0);
+	m_frameDuration = m_targetFramerate > 0 ? 1000000 / m_targetFramerate : 0;
+}
+
+sf::Int64 FramePacer::waitForNextFrame()
+{
+	if (m_frameDuration > 0)
+	{
+		//coarse sleep, leave the spin window for the scheduler wakeup latency
+		auto remaining = m_frameDuration - m_clock.getElapsedTime().asMicroseconds();
+		if (remaining > m_spinMicroseconds)
+		{
+			sf::sleep(sf::microseconds(remaining - m_spinMicroseconds));
+		}
+
+		//spin for the rest of the frame
+		while (m_clock.getElapsedTime().asMicroseconds() < m_frameDuration)
+		{
+			//Empty
+		}
+	}
+
+	m_lastFrameTime = m_clock.restart().asMicroseconds();
+	recordFrame(m_lastFrameTime);
+
+	return m_lastFrameTime;
+}
+
+double FramePacer::getMeanFrameTime() const
+{
+	if (m_frameCount == 0)
+	{
+		return 0.0;
+	}
+	return m_frameTimeSum / m_frameCount;
+}
+
+double FramePacer::getJitter() const
+{
+	if (m_frameCount == 0)
+	{
+		return 0.0;
+	}
+	const double mean = getMeanFrameTime();
+	const double variance = m_frameTimeSquaredSum / m_frameCount - mean * mean;
+	return variance > 0.0 ? std::sqrt(variance) : 0.0;
+}
+
+sf::Int64 FramePacer::getPercentile(const double percentile) const
+{
+	if (m_frameCount == 0)
+	{
+		return 0;
+	}
+
+	const auto threshold = static_cast<sf::Uint64>(std::ceil(m_frameCount * std::min(std::max(percentile, 0.0), 1.0)));
+	sf::Uint64 accumulated = 0;
+	for (size_t i = 0; i < m_bucketCount; i++)
+	{
+		accumulated += m_histogram[i];
+		if (accumulated >= threshold)
+		{
+			//report the upper bound of the bucket, clamped to the slowest frame seen
+			return std::min(static_cast<sf::Int64>(i + 1) * m_bucketWidth, m_maxFrameTime);
+		}
+	}
+	return m_maxFrameTime;
+}
+
+void FramePacer::resetStatistics()
+{
+	m_histogram.assign(m_bucketCount, 0);
+	m_frameCount = 0;
+	m_frameTimeSum = 0.0;
+	m_frameTimeSquaredSum = 0.0;
+	m_minFrameTime = 0;
+	m_maxFrameTime = 0;
+}
+
+void FramePacer::printHistogram(std::ostream& out) const
+{
+	out << "Frame pacing: target " << m_targetFramerate << " fps, " << m_frameCount << " frames" << std::endl;
+	out << "  mean " << getMeanFrameTime() << " us, jitter " << getJitter() << " us"
+		<< ", min " << m_minFrameTime << " us, max " << m_maxFrameTime << " us" << std::endl;
+	out << "  p50 " << getPercentile(0.5) << " us, p99 " << getPercentile(0.99)
+		<< " us, p99.9 " << getPercentile(0.999) << " us" << std::endl;
+
+	for (size_t i = 0; i < m_bucketCount; i++)
+	{
+		if (m_histogram[i] == 0)
+		{
+			continue;
+		}
+
+		out << "  " << static_cast<sf::Int64>(i) * m_bucketWidth << " us";
+		if (i == m_bucketCount - 1)
+		{
+			out << "+";
+		}
+		out << ": " << m_histogram[i] << std::endl;
+	}
+}
+
+void FramePacer::recordFrame(const sf::Int64 frameTime)
+{
+	const auto bucket = std::min(static_cast<size_t>(std::max(frameTime, sf::Int64(0)) / m_bucketWidth), m_bucketCount - 1);
+	m_histogram[bucket]++;
+
+	if (m_frameCount == 0)
+	{
+		m_minFrameTime = frameTime;
+		m_maxFrameTime = frameTime;
+	}
+	else
+	{
+		m_minFrameTime = std::min(m_minFrameTime, frameTime);
+		m_maxFrameTime = std::max(m_maxFrameTime, frameTime);
+	}
+
+	m_frameCount++;
+	m_frameTimeSum += static_cast<double>(frameTime);
+	m_frameTimeSquaredSum += static_cast<double>(frameTime) * static_cast<double>(frameTime);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <ostream>
+#include <vector>
+
+// Paces the main loop to a target framerate by sleeping most of the remaining
+// frame time and spinning for the last part, which avoids the judder caused by
+// the coarse sleep granularity behind sf::Window::setFramerateLimit.
+// Frame times are kept in a histogram so pacing jitter can be inspected.
+class FramePacer
+{
+public:
+	FramePacer(const int targetFramerate, const sf::Int64 spinMicroseconds);
+	virtual ~FramePacer() = default;
+
+	// 0 disables pacing, frames are only measured
+	void setTargetFramerate(const int targetFramerate);
+	int getTargetFramerate() const { return m_targetFramerate; }
+
+	// waits until the current frame has used up its time budget,
+	// returns the duration of the finished frame in microseconds
+	sf::Int64 waitForNextFrame();
+
+	sf::Int64 getLastFrameTime() const { return m_lastFrameTime; }
+
+	// frame time statistics in microseconds
+	double getMeanFrameTime() const;
+	double getJitter() const;
+	sf::Int64 getPercentile(const double percentile) const;
+	sf::Int64 getMinFrameTime() const { return m_minFrameTime; }
+	sf::Int64 getMaxFrameTime() const { return m_maxFrameTime; }
+	sf::Uint64 getFrameCount() const { return m_frameCount; }
+
+	void resetStatistics();
+	void printHistogram(std::ostream& out) const;
+
+private:
+
+	// histogram bucket width and count, the last bucket collects everything slower
+	static const sf::Int64 m_bucketWidth = 100;
+	static const size_t m_bucketCount = 500;
+
+	int m_targetFramerate = 0;
+	sf::Int64 m_frameDuration = 0;
+	sf::Int64 m_spinMicroseconds;
+	sf::Int64 m_lastFrameTime = 0;
+
+	sf::Clock m_clock;
+
+	std::vector<sf::Uint64> m_histogram;
+	sf::Uint64 m_frameCount = 0;
+	double m_frameTimeSum = 0.0;
+	double m_frameTimeSquaredSum = 0.0;
+	sf::Int64 m_minFrameTime = 0;
+	sf::Int64 m_maxFrameTime = 0;
+
+	void recordFrame(const sf::Int64 frameTime);
+};
@@ -8,16 +8,23 @@
 #include "Utils.h"
 #include "Config.h"
 
+#include <algorithm>
+#include <thread>
+
 GLRaycaster::GLRaycaster() 
 {
 	m_glRenderer = std::make_unique<GLRenderer>();
+	setThreadCount(g_raycasterThreadCount);
+}
+GLRaycaster::~GLRaycaster()
+{
+	stopWorkers();
 }
-GLRaycaster::~GLRaycaster() {}
 
 void GLRaycaster::initialize(
 	const int windowWidth, const int windowHeight,
 	std::shared_ptr<Player> player, 
-	std::shared_ptr<LevelReaderWriter> levelReader)
+	std::shared_ptr<LevelReaderWriter> levelReader, const bool headless)
 {
 	m_windowWidth = windowWidth;
 	m_windowHeight = windowHeight;
@@ -33,22 +40,61 @@ void GLRaycaster::initialize(
 	m_clickables.resize(m_levelReader->getSprites().size());
 
 	m_buffer.resize(windowHeight * windowWidth * 3);
-	m_glRenderer->init(&m_buffer[0], windowWidth, windowHeight);
+
+	if (!headless)
+	{
+		m_glRenderer->init(&m_buffer[0], windowWidth, windowHeight);
+	}
 
 }
 
 void GLRaycaster::draw()
 {
-	std::vector<unsigned char>().swap(m_buffer);
-	m_buffer.resize(m_windowWidth * m_windowHeight * 3);
+	m_glRenderer->draw(&m_buffer[0], m_windowWidth, m_windowHeight);
+}
+
+void GLRaycaster::render()
+{
+	//clear the buffer, not every pixel is written each frame
+	std::fill(m_buffer.begin(), m_buffer.end(), static_cast<unsigned char>(0));
 
 	//calculate a new buffer
 	calculateWalls();
 	calculateSprites();
+}
 
-	m_glRenderer->draw(&m_buffer[0], m_windowWidth, m_windowHeight);
-	m_glRenderer->unbindBuffers();
+void GLRaycaster::renderColumns(const int startX, const int endX)
+{
+	const int first = std::max(startX, 0);
+	const int last = std::min(endX, m_windowWidth);
+	if (first >= last)
+	{
+		return;
+	}
 
+	for (int y = 0; y < m_windowHeight; y++)
+	{
+		const auto row = m_buffer.begin() + static_cast<size_t>(y) * m_windowWidth * 3;
+		std::fill(row + first * 3, row + last * 3, static_cast<unsigned char>(0));
+	}
+
+	calculateWallColumns(first, last);
+	calculateSprites(first, last);
+}
+
+void GLRaycaster::setThreadCount(const int threadCount)
+{
+	//the next frame starts as many workers as it needs
+	stopWorkers();
+
+	if (threadCount > 0)
+	{
+		m_threadCount = threadCount;
+	}
+	else
+	{
+		m_threadCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	}
 }
 
 void GLRaycaster::bindGlBuffers()
@@ -56,207 +102,336 @@ void GLRaycaster::bindGlBuffers()
 	m_glRenderer->bindBuffers();
 }
 
+void GLRaycaster::unbindGlBuffers()
+{
+	m_glRenderer->unbindBuffers();
+}
+
 void GLRaycaster::cleanup()
 {
+	stopWorkers();
 	m_glRenderer->cleanup();
 }
 
+bool GLRaycaster::reloadShaders(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	return m_glRenderer->reloadShaders(vertexSource, fragmentSource);
+}
+
 void GLRaycaster::calculateWalls()
 {
+	const int threadCount = std::min(m_threadCount, m_windowWidth);
+	if (threadCount <= 1)
+	{
+		calculateWallColumns(0, m_windowWidth);
+		return;
+	}
 
-	const double rayPosX = m_player->m_posX;
-	const double rayPosY = m_player->m_posY;
+	if (static_cast<int>(m_workers.size()) != threadCount - 1)
+	{
+		stopWorkers();
+		startWorkers(threadCount - 1);
+	}
 
-	//what direction to step in x or y-direction (either +1 or -1)
-	int stepX;
-	int stepY;
+	//every column only touches its own pixels and zbuffer entry, so the screen can be split freely
+	const int columnsPerThread = (m_windowWidth + threadCount - 1) / threadCount;
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_columnsPerWorker = columnsPerThread;
+		m_workersBusy = static_cast<int>(m_workers.size());
+		m_workGeneration++;
+	}
+	m_workStart.notify_all();
 
-	//length of ray from current position to next x or y-side
-	double sideDistX;
-	double sideDistY;
+	calculateWallColumns(0, std::min(columnsPerThread, m_windowWidth));
 
-	double perpWallDist;
-	double wallX; //where exactly the wall was hit
+	std::unique_lock<std::mutex> lock(m_workMutex);
+	m_workDone.wait(lock, [this] { return m_workersBusy == 0; });
+}
 
-	auto& tex8 = m_levelReader->getTexture(8);//floor
-	auto& tex9 = m_levelReader->getTexture(9);//ceiling
-	
-	for (int x = 0; x < m_windowWidth; x++)
+void GLRaycaster::startWorkers(const int count)
+{
+	m_stopWorkers = false;
+	m_workers.reserve(count);
+	for (int i = 0; i < count; i++)
 	{
-		
-		//which box of the map we're in
-		int mapX = static_cast<int>(rayPosX);
-		int mapY = static_cast<int>(rayPosY);
-
-		//calculate ray position and direction
-		const double cameraX = 2.0 * x / m_windowWidth - 1.0; //x-coordinate in camera space
+		m_workers.emplace_back(&GLRaycaster::runWorker, this, i, m_workGeneration);
+	}
+}
 
-		const double rayDirX = m_player->m_dirX + m_player->m_planeX * cameraX;
-		const double rayDirY = m_player->m_dirY + m_player->m_planeY * cameraX;
+void GLRaycaster::stopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_stopWorkers = true;
+	}
+	m_workStart.notify_all();
 
-		//length of ray from one x or y-side to next x or y-side
-		const double rayDirXsq = rayDirX * rayDirX;
-		const double rayDirYsq = rayDirY * rayDirY;
-		const double deltaDistX = sqrt(1 + rayDirYsq / rayDirXsq);
-		const double deltaDistY = sqrt(1 + rayDirXsq / rayDirYsq);
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
 
-		//calculate step and initial sideDist
-		if (rayDirX < 0)
-		{
-			stepX = -1;
-			sideDistX = (rayPosX - mapX) * deltaDistX;
-		}
-		else
-		{
-			stepX = 1;
-			sideDistX = (mapX + 1.0 - rayPosX) * deltaDistX;
-		}
-		if (rayDirY < 0)
-		{
-			stepY = -1;
-			sideDistY = (rayPosY - mapY) * deltaDistY;
-		}
-		else
+void GLRaycaster::runWorker(const int index, unsigned int generation)
+{
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(m_workMutex);
+		m_workStart.wait(lock, [this, generation] { return m_stopWorkers || m_workGeneration != generation; });
+		if (m_stopWorkers)
 		{
-			stepY = 1;
-			sideDistY = (mapY + 1.0 - rayPosY) * deltaDistY;
+			return;
 		}
 
-		int hit = 0; //was there a wall hit?
-		int side = 0; //was a NS or a EW wall hit?
+		generation = m_workGeneration;
+		const int startX = (index + 1) * m_columnsPerWorker;
+		const int endX = std::min(startX + m_columnsPerWorker, m_windowWidth);
+		lock.unlock();
 
-		//perform DDA
-		while (hit == 0)
+		if (startX < endX)
 		{
-			//jump to next map square, OR in x-direction, OR in y-direction
-			if (sideDistX < sideDistY)
-			{
-				sideDistX += deltaDistX;
-				mapX += stepX;
-				side = 0;
-			}
-			else
-			{
-				sideDistY += deltaDistY;
-				mapY += stepY;
-				side = 1;
-			}
-			//Check if ray has hit a wall
-			if (m_levelReader->getLevel()[mapX][mapY] > 0) hit = 1;
+			calculateWallColumns(startX, endX);
 		}
 
-		//Calculate distance projected on camera direction (oblique distance will give fisheye effect!)
-		if (side == 0)
-		{
-			perpWallDist = std::abs((mapX - rayPosX + (1 - stepX) / 2) / rayDirX);
-		}
-		else
+		lock.lock();
+		if (--m_workersBusy == 0)
 		{
-			perpWallDist = std::abs((mapY - rayPosY + (1 - stepY) / 2) / rayDirY);
+			m_workDone.notify_one();
 		}
+	}
+}
+
+void GLRaycaster::calculateWallColumns(const int startX, const int endX)
+{
+	for (int x = startX; x < endX; x++)
+	{
+		const RayHit hit = castRay(x);
+		const int drawEnd = drawWallColumn(x, hit);
+
+		//SET THE ZBUFFER FOR THE SPRITE CASTING
+		m_ZBuffer[x] = hit.perpWallDist; //perpendicular distance is used
 
-		//Calculate height of line to draw on screen
-		const int lineHeight = static_cast<int>(std::abs(m_windowHeight / perpWallDist));
+		drawFloorColumn(x, hit, drawEnd);
+	}
+}
+
+GLRaycaster::RayHit GLRaycaster::castRay(const int x) const
+{
+	const double rayPosX = m_player->m_posX;
+	const double rayPosY = m_player->m_posY;
 
-		//calculate lowest and highest pixel to fill in current stripe
-		int drawStart = -lineHeight / 2 + m_windowHeight / 2;
-		if (drawStart < 0)drawStart = 0;
-		int drawEnd = lineHeight / 2 + m_windowHeight / 2;
-		if (drawEnd >= m_windowHeight)drawEnd = m_windowHeight - 1;
+	RayHit hit;
 
-		if (side == 1)
+	//which box of the map we're in
+	hit.mapX = static_cast<int>(rayPosX);
+	hit.mapY = static_cast<int>(rayPosY);
+
+	//calculate ray position and direction
+	const double cameraX = 2.0 * x / m_windowWidth - 1.0; //x-coordinate in camera space
+
+	hit.rayDirX = m_player->m_dirX + m_player->m_planeX * cameraX;
+	hit.rayDirY = m_player->m_dirY + m_player->m_planeY * cameraX;
+
+	//length of ray from one x or y-side to next x or y-side
+	const double rayDirXsq = hit.rayDirX * hit.rayDirX;
+	const double rayDirYsq = hit.rayDirY * hit.rayDirY;
+	const double deltaDistX = sqrt(1 + rayDirYsq / rayDirXsq);
+	const double deltaDistY = sqrt(1 + rayDirXsq / rayDirYsq);
+
+	//what direction to step in x or y-direction (either +1 or -1)
+	int stepX;
+	int stepY;
+
+	//length of ray from current position to next x or y-side
+	double sideDistX;
+	double sideDistY;
+
+	//calculate step and initial sideDist
+	if (hit.rayDirX < 0)
+	{
+		stepX = -1;
+		sideDistX = (rayPosX - hit.mapX) * deltaDistX;
+	}
+	else
+	{
+		stepX = 1;
+		sideDistX = (hit.mapX + 1.0 - rayPosX) * deltaDistX;
+	}
+	if (hit.rayDirY < 0)
+	{
+		stepY = -1;
+		sideDistY = (rayPosY - hit.mapY) * deltaDistY;
+	}
+	else
+	{
+		stepY = 1;
+		sideDistY = (hit.mapY + 1.0 - rayPosY) * deltaDistY;
+	}
+
+	hit.side = 0; //was a NS or a EW wall hit?
+
+	//perform DDA
+	const auto& level = m_levelReader->getLevel();
+	while (true)
+	{
+		//jump to next map square, OR in x-direction, OR in y-direction
+		if (sideDistX < sideDistY)
 		{
-			wallX = rayPosX + ((mapY - rayPosY + (1 - stepY) / 2) / rayDirY) * rayDirX;
+			sideDistX += deltaDistX;
+			hit.mapX += stepX;
+			hit.side = 0;
 		}
 		else
 		{
-			wallX = rayPosY + ((mapX - rayPosX + (1 - stepX) / 2) / rayDirX) * rayDirY;
+			sideDistY += deltaDistY;
+			hit.mapY += stepY;
+			hit.side = 1;
 		}
-		wallX -= floor(wallX);
+		//Check if ray has hit a wall
+		if (level.get(hit.mapX, hit.mapY) > 0) break;
+	}
 
-		//x coordinate on the texture
-		int texX = static_cast<int>(wallX * g_textureWidth);
-		if (side == 0 && rayDirX > 0) texX = g_textureWidth - texX - 1;
-		if (side == 1 && rayDirY < 0) texX = g_textureWidth - texX - 1;
+	//Calculate distance projected on camera direction (oblique distance will give fisheye effect!)
+	if (hit.side == 0)
+	{
+		hit.perpWallDist = std::abs((hit.mapX - rayPosX + (1 - stepX) / 2) / hit.rayDirX);
+	}
+	else
+	{
+		hit.perpWallDist = std::abs((hit.mapY - rayPosY + (1 - stepY) / 2) / hit.rayDirY);
+	}
 
-		const int texNum = m_levelReader->getLevel()[mapX][mapY] - 1; //1 subtracted from it so that texture 0 can be used!
-		const std::vector<sf::Uint32>& texture = m_levelReader->getTexture(texNum);
-		const int texSize = static_cast<int>(texture.size());
+	//where exactly the wall was hit
+	if (hit.side == 1)
+	{
+		hit.wallX = rayPosX + ((hit.mapY - rayPosY + (1 - stepY) / 2) / hit.rayDirY) * hit.rayDirX;
+	}
+	else
+	{
+		hit.wallX = rayPosY + ((hit.mapX - rayPosX + (1 - stepX) / 2) / hit.rayDirX) * hit.rayDirY;
+	}
+	hit.wallX -= floor(hit.wallX);
 
-		for (int y = drawStart; y < drawEnd; y++)
-		{
+	return hit;
+}
 
-			int d = y * 256 - m_windowHeight * 128 + lineHeight * 128;  //256 and 128 factors to avoid floats
-			int texY = ((d * g_textureHeight) / lineHeight) / 256;
-			int texNumY = g_textureHeight * texX + texY;
+int GLRaycaster::drawWallColumn(const int x, const RayHit& hit)
+{
+	//Calculate height of line to draw on screen
+	const int lineHeight = static_cast<int>(std::abs(m_windowHeight / hit.perpWallDist));
 
-			if (texNumY < texSize)
-			{
-				auto color = texture[texNumY];
-				setPixel(x, y, color, side);
-			}
-		}
+	//calculate lowest and highest pixel to fill in current stripe
+	int drawStart = -lineHeight / 2 + m_windowHeight / 2;
+	if (drawStart < 0)drawStart = 0;
+	int drawEnd = lineHeight / 2 + m_windowHeight / 2;
+	if (drawEnd >= m_windowHeight)drawEnd = m_windowHeight - 1;
 
-		//SET THE ZBUFFER FOR THE SPRITE CASTING
-		m_ZBuffer[x] = perpWallDist; //perpendicular distance is used
+	//x coordinate on the texture
+	int texX = static_cast<int>(hit.wallX * g_textureWidth);
+	if (hit.side == 0 && hit.rayDirX > 0) texX = g_textureWidth - texX - 1;
+	if (hit.side == 1 && hit.rayDirY < 0) texX = g_textureWidth - texX - 1;
 
-		//FLOOR CASTING
-		double floorXWall, floorYWall; //x, y position of the floor texel at the bottom of the wall
+	const int texNum = m_levelReader->getLevel().get(hit.mapX, hit.mapY) - 1; //1 subtracted from it so that texture 0 can be used!
+	const std::vector<sf::Uint32>& texture = m_levelReader->getTexture(texNum);
+	const int texSize = static_cast<int>(texture.size());
 
-		if (side == 0 && rayDirX > 0)
-		{
-			floorXWall = mapX;
-			floorYWall = mapY + wallX;
-		}
-		else if (side == 0 && rayDirX < 0)
-		{
-			floorXWall = mapX + 1.0;
-			floorYWall = mapY + wallX;
-		}
-		else if (side == 1 && rayDirY > 0)
-		{
-			floorXWall = mapX + wallX;
-			floorYWall = mapY;
-		}
-		else
+	for (int y = drawStart; y < drawEnd; y++)
+	{
+
+		int d = y * 256 - m_windowHeight * 128 + lineHeight * 128;  //256 and 128 factors to avoid floats
+		int texY = ((d * g_textureHeight) / lineHeight) / 256;
+		int texNumY = g_textureHeight * texX + texY;
+
+		if (texNumY < texSize)
 		{
-			floorXWall = mapX + wallX;
-			floorYWall = mapY + 1.0;
+			auto color = texture[texNumY];
+			setPixel(x, y, color, hit.side);
 		}
+	}
 
-		if (drawEnd < 0) drawEnd = m_windowHeight; //becomes < 0 when the integer overflows
+	return drawEnd;
+}
 
-												   //draw the floor from drawEnd to the bottom of the screen
-		for (int y = drawEnd + 1; y < m_windowHeight; y++)
-		{
+void GLRaycaster::drawFloorColumn(const int x, const RayHit& hit, int drawEnd)
+{
+	const double rayPosX = m_player->m_posX;
+	const double rayPosY = m_player->m_posY;
+
+	auto& tex8 = m_levelReader->getTexture(8);//floor
+	auto& tex9 = m_levelReader->getTexture(9);//ceiling
+
+	//FLOOR CASTING
+	double floorXWall, floorYWall; //x, y position of the floor texel at the bottom of the wall
+
+	if (hit.side == 0 && hit.rayDirX > 0)
+	{
+		floorXWall = hit.mapX;
+		floorYWall = hit.mapY + hit.wallX;
+	}
+	else if (hit.side == 0 && hit.rayDirX < 0)
+	{
+		floorXWall = hit.mapX + 1.0;
+		floorYWall = hit.mapY + hit.wallX;
+	}
+	else if (hit.side == 1 && hit.rayDirY > 0)
+	{
+		floorXWall = hit.mapX + hit.wallX;
+		floorYWall = hit.mapY;
+	}
+	else
+	{
+		floorXWall = hit.mapX + hit.wallX;
+		floorYWall = hit.mapY + 1.0;
+	}
 
-			const double currentDist = m_windowHeight / (2.0 * y - m_windowHeight); //you could make a small lookup table for this instead
-			const double weight = currentDist / perpWallDist;
+	if (drawEnd < 0) drawEnd = m_windowHeight; //becomes < 0 when the integer overflows
 
-			const double currentFloorX = weight * floorXWall + (1.0 - weight) * rayPosX;
-			const double currentFloorY = weight * floorYWall + (1.0 - weight) * rayPosY;
+	//draw the floor from drawEnd to the bottom of the screen
+	for (int y = drawEnd + 1; y < m_windowHeight; y++)
+	{
 
-			const int floorTexX = static_cast<int>(currentFloorX * g_textureWidth) % g_textureWidth;
-			const int floorTexY = static_cast<int>(currentFloorY * g_textureHeight) % g_textureHeight;
+		const double currentDist = m_windowHeight / (2.0 * y - m_windowHeight); //you could make a small lookup table for this instead
+		const double weight = currentDist / hit.perpWallDist;
 
-			//floor textures
-			sf::Uint32 color1 = tex8[g_textureWidth * floorTexY + floorTexX];
-			sf::Uint32 color2 = tex9[g_textureWidth * floorTexY + floorTexX];
+		const double currentFloorX = weight * floorXWall + (1.0 - weight) * rayPosX;
+		const double currentFloorY = weight * floorYWall + (1.0 - weight) * rayPosY;
 
-			setPixel(x, y, color1, 0);
-			setPixel(x, m_windowHeight - y, color2, 0);
-		}
+		const int floorTexX = static_cast<int>(currentFloorX * g_textureWidth) % g_textureWidth;
+		const int floorTexY = static_cast<int>(currentFloorY * g_textureHeight) % g_textureHeight;
+
+		//floor textures
+		sf::Uint32 color1 = tex8[g_textureWidth * floorTexY + floorTexX];
+		sf::Uint32 color2 = tex9[g_textureWidth * floorTexY + floorTexX];
+
+		setPixel(x, y, color1, 0);
+		setPixel(x, m_windowHeight - y, color2, 0);
 	}
 }
 
 
 void GLRaycaster::calculateSprites()
+{
+	calculateSprites(0, m_windowWidth);
+}
+
+void GLRaycaster::calculateSprites(const int startX, const int endX)
 {
 
 	//SPRITE CASTING
 	//sort sprites from far to close
 
-	auto sprites = m_levelReader->getSprites();
+	const auto& sprites = m_levelReader->getSprites();
+
+	//the level may have been replaced since the last frame
+	if (sprites.size() != m_spriteSize)
+	{
+		m_spriteSize = sprites.size();
+		m_spriteOrder.resize(m_spriteSize);
+		m_spriteDistance.resize(m_spriteSize);
+		m_clickables.resize(m_spriteSize);
+	}
 
 	for (size_t i = 0; i < m_spriteSize; i++)
 	{
@@ -307,6 +482,8 @@ void GLRaycaster::calculateSprites()
 		if (drawEndY >= m_windowHeight) drawEndY = m_windowHeight - 1;
 		if (drawStartX < 0) drawStartX = 0;
 		if (drawEndX >= m_windowWidth) drawEndX = m_windowWidth - 1;
+		if (drawStartX < startX) drawStartX = startX;
+		if (drawEndX > endX) drawEndX = endX;
 
 		//loop through every vertical stripe of the sprite on screen
 		for (int stripe = drawStartX; stripe < drawEndX; stripe++)
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 class Game;
 class GLRenderer;
@@ -12,24 +15,67 @@ struct Player;
 class GLRaycaster
 {
 public:
+
+	// result of casting the ray of one screen column
+	struct RayHit
+	{
+		int mapX;
+		int mapY;
+		int side;
+		double rayDirX;
+		double rayDirY;
+		double perpWallDist;
+		double wallX;
+	};
+
 	GLRaycaster();
 	virtual ~GLRaycaster();
 
+	// headless skips the OpenGL setup, frames can then only be produced with render()
 	void initialize(const int windowWidth, const int windowHeight, 
-		std::shared_ptr<Player> player, std::shared_ptr<LevelReaderWriter> levelReader);
+		std::shared_ptr<Player> player, std::shared_ptr<LevelReaderWriter> levelReader, const bool headless = false);
+	void render();
+	// renders the screen columns from startX to endX only, the other columns keep their pixels
+	void renderColumns(const int startX, const int endX);
 	void calculateWalls();
 	void calculateSprites();
+	// sprite stripes outside the columns from startX to endX are skipped
+	void calculateSprites(const int startX, const int endX);
+
+	// single column steps of calculateWalls
+	RayHit castRay(const int x) const;
+	int drawWallColumn(const int x, const RayHit& hit);
+	void drawFloorColumn(const int x, const RayHit& hit, int drawEnd);
+
 	void setPixel(int x, int y, const sf::Uint32 colorRgba, int style);
+	// uploads the rendering buffer and draws it, the GL buffers stay bound
 	void draw();
 	void bindGlBuffers();
+	void unbindGlBuffers();
 	void cleanup();
+	bool reloadShaders(const std::string& vertexSource, const std::string& fragmentSource);
 
 	std::vector<Clickable>& getClickables() { return m_clickables; }
 
+	// RGB rendering buffer of the last frame
+	const std::vector<unsigned char>& getBuffer() const { return m_buffer; }
+	// the HUD is blended into it between render() and draw()
+	std::vector<unsigned char>& getBuffer() { return m_buffer; }
+	// size of the buffer in pixels, set by initialize()
+	int getWidth() const { return m_windowWidth; }
+	int getHeight() const { return m_windowHeight; }
+	// perpendicular wall distance of every column of the last frame
+	const std::vector<double>& getZBuffer() const { return m_ZBuffer; }
+
+	// number of threads the wall and floor columns are split across, 0 uses all cores
+	void setThreadCount(const int threadCount);
+	int getThreadCount() const { return m_threadCount; }
+
 private:
 
 	int m_windowWidth = 0;
 	int m_windowHeight = 0;
+	int m_threadCount = 1;
 
 	std::unique_ptr<GLRenderer> m_glRenderer;
 
@@ -49,5 +95,22 @@ private:
 	// buffer of clickable items in the view
 	std::vector<Clickable> m_clickables;
 
+	//wall and floor workers, they sleep between frames and are started again when the thread count changes
+	std::vector<std::thread> m_workers;
+	std::mutex m_workMutex;
+	std::condition_variable m_workStart;
+	std::condition_variable m_workDone;
+	//a new frame bumps the generation, the workers still running are counted down
+	unsigned int m_workGeneration = 0;
+	int m_workersBusy = 0;
+	int m_columnsPerWorker = 0;
+	bool m_stopWorkers = false;
+
+	void calculateWallColumns(const int startX, const int endX);
+	void startWorkers(const int count);
+	void stopWorkers();
+	// worker index renders the columns of the screen part index + 1, the first part is left to the caller
+	void runWorker(const int index, unsigned int generation);
+
 };
 
@@ -1,11 +1,15 @@
 #include "GLRenderer.h"
 
 #include "Config.h"
-#include "Utils.h"
+#include "ResourcePack.h"
 
 #include "GL/glew.h"
 #include <SFML/OpenGL.hpp>
 
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
 
 GLRenderer::GLRenderer() : vao(0), vbo(0), ebo(0), shaderProgram(0), vertexShader(0), fragmentShader(0), tex(0)
 {
@@ -14,10 +18,8 @@ GLRenderer::GLRenderer() : vao(0), vbo(0), ebo(0), shaderProgram(0), vertexShade
 
 void GLRenderer::init(unsigned char* buffer, int width, int height)
 {
-	std::string vertSrcStr = Utils::readFile(g_mainVertexShader);
-	std::string fragSrcStr = Utils::readFile(g_mainFragmentShader);
-	const char* vertSrc = vertSrcStr.c_str();
-	const char* fragSrc = fragSrcStr.c_str();
+	std::string vertSrcStr = ResourcePack::readText(g_mainVertexShader);
+	std::string fragSrcStr = ResourcePack::readText(g_mainFragmentShader);
 
 	// Initialize GLEW
 	glewExperimental = GL_TRUE;
@@ -51,36 +53,14 @@ void GLRenderer::init(unsigned char* buffer, int width, int height)
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(elements), elements, GL_STATIC_DRAW);
 
-	// Create and compile the vertex shader
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertSrc, nullptr);
-	glCompileShader(vertexShader);
-
-	// Create and compile the fragment shader
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragSrc, nullptr);
-	glCompileShader(fragmentShader);
-
-	// Link the vertex and fragment shader into a shader program
-	shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glBindFragDataLocation(shaderProgram, 0, "outColor");
-	glLinkProgram(shaderProgram);
+	// Compile the vertex and fragment shader and link them into a shader program
+	vertexShader = compileShader(GL_VERTEX_SHADER, vertSrcStr);
+	fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragSrcStr);
+	shaderProgram = linkProgram(vertexShader, fragmentShader);
 	glUseProgram(shaderProgram);
 
 	// Specify the layout of the vertex data
-	GLint posAttrib = glGetAttribLocation(shaderProgram, "position");
-	glEnableVertexAttribArray(posAttrib);
-	glVertexAttribPointer(posAttrib, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), nullptr);
-
-	GLint colAttrib = glGetAttribLocation(shaderProgram, "color");
-	glEnableVertexAttribArray(colAttrib);
-	glVertexAttribPointer(colAttrib, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), reinterpret_cast<void*>(2 * sizeof(GLfloat)));
-
-	GLint texAttrib = glGetAttribLocation(shaderProgram, "texcoord");
-	glEnableVertexAttribArray(texAttrib);
-	glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), reinterpret_cast<void*>(6 * sizeof(GLfloat)));
+	setupAttributes();
 
 	// Load texture
 	glGenTextures(1, &tex);
@@ -96,6 +76,101 @@ void GLRenderer::init(unsigned char* buffer, int width, int height)
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 }
 
+bool GLRenderer::reloadShaders(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	const GLuint newVertex = compileShader(GL_VERTEX_SHADER, vertexSource);
+	const GLuint newFragment = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	const GLuint newProgram = newVertex && newFragment ? linkProgram(newVertex, newFragment) : 0;
+
+	if (newProgram == 0)
+	{
+		glDeleteShader(newVertex);
+		glDeleteShader(newFragment);
+		return false;
+	}
+
+	glDeleteProgram(shaderProgram);
+	glDeleteShader(fragmentShader);
+	glDeleteShader(vertexShader);
+
+	vertexShader = newVertex;
+	fragmentShader = newFragment;
+	shaderProgram = newProgram;
+
+	//attribute locations may differ in the new program
+	glUseProgram(shaderProgram);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	setupAttributes();
+
+	return true;
+}
+
+GLuint GLRenderer::compileShader(const unsigned int type, const std::string& source)
+{
+	const char* src = source.c_str();
+
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &src, nullptr);
+	glCompileShader(shader);
+
+	GLint status = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint length = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		std::vector<char> log(std::max(length, 1));
+		glGetShaderInfoLog(shader, GLsizei(log.size()), nullptr, log.data());
+		std::cout << "Shader compilation failed: " << log.data() << std::endl;
+
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+GLuint GLRenderer::linkProgram(const GLuint vertex, const GLuint fragment)
+{
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glBindFragDataLocation(program, 0, "outColor");
+	glLinkProgram(program);
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint length = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		std::vector<char> log(std::max(length, 1));
+		glGetProgramInfoLog(program, GLsizei(log.size()), nullptr, log.data());
+		std::cout << "Shader linking failed: " << log.data() << std::endl;
+
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	return program;
+}
+
+void GLRenderer::setupAttributes() const
+{
+	GLint posAttrib = glGetAttribLocation(shaderProgram, "position");
+	glEnableVertexAttribArray(posAttrib);
+	glVertexAttribPointer(posAttrib, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), nullptr);
+
+	GLint colAttrib = glGetAttribLocation(shaderProgram, "color");
+	glEnableVertexAttribArray(colAttrib);
+	glVertexAttribPointer(colAttrib, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), reinterpret_cast<void*>(2 * sizeof(GLfloat)));
+
+	GLint texAttrib = glGetAttribLocation(shaderProgram, "texcoord");
+	glEnableVertexAttribArray(texAttrib);
+	glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), reinterpret_cast<void*>(6 * sizeof(GLfloat)));
+}
+
 void GLRenderer::cleanup() const
 {
 
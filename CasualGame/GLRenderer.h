@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 typedef unsigned int GLuint;
 
 class GLRenderer
@@ -13,6 +15,9 @@ public:
 	void unbindBuffers() const;
 	void bindBuffers() const;
 
+	// compiles and links new shader sources, the old program stays in use if that fails
+	bool reloadShaders(const std::string& vertexSource, const std::string& fragmentSource);
+
 private:
 	//opengl stuffs
 	GLuint vao;
@@ -22,5 +27,9 @@ private:
 	GLuint vertexShader;
 	GLuint fragmentShader;
 	GLuint tex;
+
+	static GLuint compileShader(const unsigned int type, const std::string& source);
+	static GLuint linkProgram(const GLuint vertex, const GLuint fragment);
+	void setupAttributes() const;
 };
 
@@ -6,30 +6,83 @@
 #include "LevelEditorState.h"
 
 #include "LevelReaderWriter.h"
+#include "FramePacer.h"
+#include "HotReloader.h"
+#include "ResourceCache.h"
 #include "Config.h"
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
 Game::Game()
 {
+	//decoded while the window and the OpenGL context are created
+	ResourceCache::get().prefetchFont(g_fontFile);
+	ResourceCache::get().prefetchImage(g_gunSprite);
+	ResourceCache::get().prefetchImage(g_gunSprite_fire);
+
 	m_window = std::make_unique<sf::RenderWindow>(sf::VideoMode(g_defaultWidth, g_defaultHeight), g_gameTitle, sf::Style::Close);
 	m_currentState = std::make_unique<MainMenuState>(g_defaultWidth, g_defaultHeight);
-	m_clock = std::make_unique<sf::Clock>();
+	m_framePacer = std::make_unique<FramePacer>(g_targetFramerate, g_framePacerSpinTime);
+	setSimulationRate(g_simulationRate);
 
-	m_window->setFramerateLimit(500);
 	m_levelReader = std::make_shared<LevelReaderWriter>();
 	m_player = std::make_shared<Player>();
+
+	if (g_hotReloadEnabled)
+	{
+		m_hotReloader = std::make_unique<HotReloader>(g_resourceDirectory);
+	}
+
+	ResourceCache::get().report(std::cout);
 }
 
+Game::~Game() = default;
+
 void Game::run()
 {
 	//Main Loop
 	while (m_running)
 	{
+		//finished background loads are swapped in between frames
+		const bool wasLoading = m_levelReader->isLoading();
+		if (m_levelReader->publishLoadedLevel())
+		{
+			if (m_resetPlayerOnLoad)
+			{
+				resetPlayer();
+			}
+			m_currentState->onLevelLoaded();
+			ResourceCache::get().evictUnused();
+		}
+		if (wasLoading && !m_levelReader->isLoading())
+		{
+			m_resetPlayerOnLoad = false;
+		}
+		if (m_levelReader->publishSavedLevels())
+		{
+			m_currentState->onCustomLevelsChanged();
+		}
+		if (m_hotReloader)
+		{
+			m_hotReloader->apply(*m_levelReader, *m_currentState, m_suspendedState.get());
+		}
+
 		update();
 		draw();
 		updateTimers();
 		checkInput();
 	}
+
+	//states and cached resources release their OpenGL objects while the context exists
+	discardSuspendedState();
+	m_currentState.reset();
+	ResourceCache::get().report(std::cout);
+	ResourceCache::get().clear();
 	m_window->close();
+
+	m_framePacer->printHistogram(std::cout);
 }
 
 void Game::checkInput()
@@ -53,10 +106,26 @@ void Game::checkInput()
 void Game::update()
 {
 	m_currentSlice += m_lastFt;
-	for (; m_currentSlice >= 1; m_currentSlice -= 1)
+
+	//drop the time we cannot catch up on, otherwise slow frames snowball
+	const auto maxSlice = m_simulationStep * g_maxSimulationSteps;
+	if (m_currentSlice > maxSlice)
 	{
-		m_currentState->update(1.0f);
+		m_currentSlice = maxSlice;
 	}
+
+	const auto stepMs = m_simulationStep / 1000.0f;
+	for (; m_currentSlice >= m_simulationStep; m_currentSlice -= m_simulationStep)
+	{
+		m_currentState->update(stepMs);
+	}
+
+	m_currentState->interpolate(float(m_currentSlice) / float(m_simulationStep));
+}
+
+void Game::setSimulationRate(const int updatesPerSecond)
+{
+	m_simulationStep = 1000000 / std::max(updatesPerSecond, 1);
 }
 
 void Game::draw() const
@@ -66,15 +135,14 @@ void Game::draw() const
 
 void Game::updateTimers()
 {
-	m_lastFt = m_clock->restart().asMilliseconds();
+	m_lastFt = m_framePacer->waitForNextFrame();
 
 	if (m_fpsShowTimer == 0)
 	{
 		m_fpsShowTimer = 2;
-		auto ftSeconds = m_lastFt / 1000.f;
-		if (ftSeconds > 0.f)
+		if (m_lastFt > 0)
 		{
-			m_fps = static_cast<int>(1.f / ftSeconds);
+			m_fps = static_cast<int>(1000000 / m_lastFt);
 		}
 	}
 	m_fpsShowTimer--;
@@ -86,6 +154,14 @@ void Game::changeState(GameStateName newState)
 	const auto sizeX = m_window->getSize().x;
 	const auto sizeY = m_window->getSize().y;
 
+	//the state calling this is still running, it is destroyed when this returns
+	auto previousState = std::move(m_currentState);
+	if (previousState && previousState->canSuspend())
+	{
+		previousState->onSuspend();
+		m_suspendedState = std::move(previousState);
+	}
+
 	switch (newState)
 	{
 	case GameStateName::MAINMENU:
@@ -94,18 +170,20 @@ void Game::changeState(GameStateName newState)
 		break;
 	case GameStateName::PLAY:
 		m_window->setMouseCursorVisible(false);
-		m_currentState.reset(new PlayState(sizeX, sizeY, m_player, m_levelReader));
+		resumeOrCreatePlayState(sizeX, sizeY);
 		break;
 	case GameStateName::RESTART:
 		m_window->setMouseCursorVisible(false);
 		resetLevel();
-		m_currentState.reset(new PlayState(sizeX, sizeY, m_player, m_levelReader));
+		resumeOrCreatePlayState(sizeX, sizeY);
 		break;
 	case GameStateName::LEVEL_EDITOR:
 		m_window->setMouseCursorVisible(true);
 		m_currentState.reset(new LevelEditorState(sizeX, sizeY, m_player, m_levelReader));
 		break;
 	case GameStateName::SWITCH_FULLSCREEN:
+		//the OpenGL objects of the play state belong to the old window
+		discardSuspendedState();
 		switchFullscreen();
 		m_currentState.reset(new MainMenuState(m_window->getSize().x, m_window->getSize().y));
 		break;
@@ -116,21 +194,51 @@ void Game::changeState(GameStateName newState)
 		m_currentState.reset(new MainMenuState(sizeX, sizeY));
 		break;
 	}
+
+	//resources only the previous state used are released
+	previousState.reset();
+	ResourceCache::get().evictUnused();
+}
+
+void Game::resumeOrCreatePlayState(const unsigned int sizeX, const unsigned int sizeY)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	const bool resumed = m_suspendedState != nullptr;
+	if (resumed)
+	{
+		m_currentState = std::move(m_suspendedState);
+		m_currentState->onResume();
+	}
+	else
+	{
+		m_currentState.reset(new PlayState(sizeX, sizeY, m_player, m_levelReader));
+	}
+
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << (resumed ? "Play state resumed in " : "Play state created in ") << ms << " ms" << std::endl;
+}
+
+void Game::discardSuspendedState()
+{
+	m_suspendedState.reset();
 }
 
 void Game::resetLevel()
 {
-	//reset player position
-	m_player->m_posX = 22.0;
-	m_player->m_posY = 11.5;
+	//reload level in the background, the play state waits for it with the old level and pose
+	m_levelReader->loadDefaultLevelAsync();
+	m_resetPlayerOnLoad = true;
+}
+
+void Game::resetPlayer() const
+{
+	m_player->m_posX = g_playerStartX;
+	m_player->m_posY = g_playerStartY;
 	m_player->m_dirX = -1.0;
 	m_player->m_dirY = 0.0;
 	m_player->m_planeX = 0.0;
 	m_player->m_planeY = 0.66;
-
-	//reload level
-	m_levelReader->loadDefaultLevel();
-
 }
 
 void Game::switchFullscreen()
@@ -147,5 +255,4 @@ void Game::switchFullscreen()
 		m_window->create(sf::VideoMode(1024, 768), g_gameTitle, sf::Style::Close);
 		m_fullscreen = false;
 	}
-	m_window->setFramerateLimit(500);
 }
\ No newline at end of file
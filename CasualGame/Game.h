@@ -7,35 +7,47 @@
 
 struct Player;
 class LevelReaderWriter;
+class FramePacer;
+class HotReloader;
 
 class Game
 {
 public:
 	Game();
-	virtual ~Game() = default;
+	virtual ~Game();
 
 	void run();
 	void changeState(GameStateName newState);
 	bool isRunning() const { return m_running; };
 	void switchFullscreen();
 
+	void setSimulationRate(const int updatesPerSecond);
+
 	int getFps() const { return m_fps; }
+	const FramePacer& getFramePacer() const { return *m_framePacer; }
 
 	sf::RenderWindow& getWindow() const { return *m_window; }
 
 private:
 
-	int m_lastFt = 0;
-	int m_currentSlice = 0;
+	//frame times in microseconds
+	sf::Int64 m_lastFt = 0;
+	sf::Int64 m_currentSlice = 0;
+	sf::Int64 m_simulationStep = 0;
 	bool m_running = true;
 	int m_fpsShowTimer = 0;
 	bool m_fullscreen = false;
 	int m_fps = 0;
+	//the restart pose is applied once the restarted level is swapped in
+	bool m_resetPlayerOnLoad = false;
 
 	std::unique_ptr<sf::RenderWindow> m_window;
-	std::unique_ptr<sf::Clock> m_clock;
+	std::unique_ptr<FramePacer> m_framePacer;
+	std::unique_ptr<HotReloader> m_hotReloader;
 
 	std::unique_ptr<GameState> m_currentState;
+	//play state kept with its OpenGL objects while the menu or the editor runs
+	std::unique_ptr<GameState> m_suspendedState;
 
 	std::shared_ptr<LevelReaderWriter> m_levelReader;
 	std::shared_ptr<Player> m_player;
@@ -44,6 +56,9 @@ private:
 	void update();
 	void draw() const;
 	void resetLevel();
+	void resetPlayer() const;
+	void resumeOrCreatePlayState(const unsigned int sizeX, const unsigned int sizeY);
+	void discardSuspendedState();
 	void updateTimers();
 
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <string>
 
 class Game;
 
@@ -20,6 +21,21 @@ class GameState
 public:
 
 	virtual void update(const float ft) = 0;
+	// alpha is the fraction of a simulation step elapsed since the last update
+	virtual void interpolate(const float alpha) {}
+	// called between frames after an asynchronous load replaced the level
+	virtual void onLevelLoaded() {}
+	// called between frames when files changed on disk, see HotReloader
+	virtual void onShadersChanged(const std::string& vertexSource, const std::string& fragmentSource) {}
+	virtual void onCustomLevelsChanged() {}
+	// edits of the level that were not saved, the level is not replaced under them
+	virtual bool hasUnsavedEdits() const { return false; }
+	// the file of the level in use changed while it had unsaved edits
+	virtual void onLevelChangedOnDisk() {}
+	// states that can be suspended are kept by Game while another state runs and resumed later
+	virtual bool canSuspend() const { return false; }
+	virtual void onSuspend() {}
+	virtual void onResume() {}
 	virtual void draw(sf::RenderWindow& window) = 0;
 	virtual void handleInput(const sf::Event& event, const sf::Vector2f& mousePosition, Game& game) = 0;
 
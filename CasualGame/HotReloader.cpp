@@ -0,0 +1,188 @@
+#include "HotReloader.h"
+
+#include "FileWatcher.h"
+#include "GameState.h"
+#include "LevelReaderWriter.h"
+#include "ResourcePack.h"
+#include "Utils.h"
+#include "Config.h"
+
+#include <iostream>
+#include <map>
+
+HotReloader::HotReloader(const std::string& directory)
+{
+	m_watcher = std::make_unique<FileWatcher>(directory);
+	if (m_watcher->isWatching())
+	{
+		m_worker = std::thread(&HotReloader::run, this);
+	}
+}
+
+HotReloader::~HotReloader()
+{
+	m_stop = true;
+	if (m_worker.joinable())
+	{
+		m_worker.join();
+	}
+}
+
+void HotReloader::apply(LevelReaderWriter& levelReader, GameState& state, GameState* suspendedState)
+{
+	std::vector<Reload> finished;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_levelPath = levelReader.getLevelPath();
+		finished.swap(m_finished);
+	}
+
+	bool customLevelsChanged = false;
+	for (auto& reload : finished)
+	{
+		const auto applyStart = Clock::now();
+
+		if (reload.textureIndex >= 0 && reload.succeeded && !levelReader.reloadTexture(reload.textureIndex, reload.image))
+		{
+			std::cout << "Texture " << reload.path << " does not have the size " << g_textureWidth << "x" << g_textureHeight << std::endl;
+			reload.succeeded = false;
+		}
+
+		if (reload.shaders && reload.succeeded)
+		{
+			state.onShadersChanged(reload.vertexSource, reload.fragmentSource);
+			if (suspendedState)
+			{
+				suspendedState->onShadersChanged(reload.vertexSource, reload.fragmentSource);
+			}
+		}
+
+		//a level loaded in the meantime wins, edits are only dropped when the state asks for it
+		if (reload.level && reload.succeeded && reload.path == levelReader.getLevelPath() && !levelReader.isLoading())
+		{
+			if (state.hasUnsavedEdits())
+			{
+				std::cout << "Kept the unsaved edits of " << reload.path << std::endl;
+				state.onLevelChangedOnDisk();
+				continue;
+			}
+			levelReader.setLevel(std::move(reload.tiles), std::move(reload.sprites));
+			state.onLevelLoaded();
+		}
+
+		if (reload.customLevel)
+		{
+			//unreadable or removed levels leave the catalog
+			levelReader.getCatalog().set(reload.path.substr(std::string(g_customLevelDirectory).size()), reload.entry.name.empty() ? nullptr : &reload.entry);
+			customLevelsChanged = true;
+		}
+
+		log(reload, applyStart);
+	}
+
+	if (customLevelsChanged)
+	{
+		levelReader.getCatalog().save();
+		state.onCustomLevelsChanged();
+	}
+}
+
+void HotReloader::run()
+{
+	//files are read once no change was seen for the settle time, editors write in several steps
+	std::map<std::string, Clock::time_point> pending;
+
+	while (!m_stop)
+	{
+		for (auto& path : m_watcher->wait(g_hotReloadPollTime))
+		{
+			//both shaders are relinked together
+			pending[path == g_mainFragmentShader ? g_mainVertexShader : path] = Clock::now();
+		}
+
+		const auto now = Clock::now();
+		for (auto it = pending.begin(); it != pending.end();)
+		{
+			if (now - it->second < std::chrono::milliseconds(g_hotReloadSettleTime))
+			{
+				++it;
+				continue;
+			}
+
+			Reload reload;
+			reload.changed = it->second;
+			if (read(it->first, reload))
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_finished.push_back(std::move(reload));
+			}
+			it = pending.erase(it);
+		}
+	}
+}
+
+// reads a changed file, returns false for files that are not reloaded
+bool HotReloader::read(const std::string& path, Reload& reload)
+{
+	const auto start = Clock::now();
+	reload.path = path;
+
+	//the game's own saves are already in use
+	if (LevelReaderWriter::isOwnWrite(path))
+	{
+		return false;
+	}
+
+	//the packed copy is out of date now
+	ResourcePack::get().markChanged(path);
+
+	for (int i = 0; i < g_textureCount; i++)
+	{
+		if (path == g_textureFiles[i])
+		{
+			reload.textureIndex = i;
+			reload.succeeded = reload.image.loadFromFile(path);
+		}
+	}
+
+	if (path == g_mainVertexShader)
+	{
+		reload.shaders = true;
+		reload.vertexSource = Utils::readFile(g_mainVertexShader);
+		reload.fragmentSource = Utils::readFile(g_mainFragmentShader);
+		reload.succeeded = !reload.vertexSource.empty() && !reload.fragmentSource.empty();
+	}
+
+	const std::string customDirectory = g_customLevelDirectory;
+	if (path.compare(0, customDirectory.size(), customDirectory) == 0 && path.find('/', customDirectory.size()) == std::string::npos &&
+		!Utils::isTemporaryFile(path))
+	{
+		reload.customLevel = true;
+		reload.succeeded = LevelCatalog::readEntry(customDirectory, path.substr(customDirectory.size()), reload.entry);
+	}
+
+	bool inUse;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		inUse = path == m_levelPath;
+	}
+	if (inUse)
+	{
+		reload.level = true;
+		reload.succeeded = LevelReaderWriter::readLevelFile(path, reload.tiles, reload.sprites);
+	}
+
+	reload.readMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	return reload.textureIndex >= 0 || reload.shaders || reload.customLevel || reload.level;
+}
+
+void HotReloader::log(const Reload& reload, const Clock::time_point applyStart) const
+{
+	const auto now = Clock::now();
+	const double applyMs = std::chrono::duration<double, std::milli>(now - applyStart).count();
+	const double latencyMs = std::chrono::duration<double, std::milli>(now - reload.changed).count();
+
+	std::cout << (reload.succeeded ? "Reloaded " : "Could not reload ") << reload.path
+		<< ": read " << reload.readMs << " ms, applied " << applyMs << " ms, "
+		<< latencyMs << " ms after the last change" << std::endl;
+}
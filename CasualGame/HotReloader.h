@@ -0,0 +1,74 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LevelCatalog.h"
+#include "Sprite.h"
+#include "TileMap.h"
+
+class FileWatcher;
+class GameState;
+class LevelReaderWriter;
+
+// Watches the resources directory and reloads the assets that changed on disk:
+// a texture slot, the level in use, the custom level catalog or the main shaders.
+// Files are read on a worker thread once they stopped changing, apply() hands the results over between frames.
+class HotReloader
+{
+public:
+	explicit HotReloader(const std::string& directory);
+	virtual ~HotReloader();
+
+	HotReloader(const HotReloader&) = delete;
+	HotReloader& operator=(const HotReloader&) = delete;
+
+	// call between frames, a suspended state still gets new shaders
+	void apply(LevelReaderWriter& levelReader, GameState& state, GameState* suspendedState);
+
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct Reload
+	{
+		std::string path;
+		Clock::time_point changed;
+		double readMs = 0.0;
+		bool succeeded = false;
+
+		int textureIndex = -1;
+		sf::Image image;
+
+		bool shaders = false;
+		std::string vertexSource;
+		std::string fragmentSource;
+
+		bool level = false;
+		TileMap tiles;
+		std::vector<Sprite> sprites;
+
+		bool customLevel = false;
+		LevelCatalogEntry entry;
+	};
+
+	std::unique_ptr<FileWatcher> m_watcher;
+
+	//guards the finished reloads and the level path
+	std::mutex m_mutex;
+	std::vector<Reload> m_finished;
+	std::string m_levelPath;
+
+	std::atomic<bool> m_stop{ false };
+	std::thread m_worker;
+
+	void run();
+	bool read(const std::string& path, Reload& reload);
+	void log(const Reload& reload, const Clock::time_point applyStart) const;
+};
@@ -0,0 +1,362 @@
+#include "HudCompositor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	inline void blendPixel(unsigned char* destination, const sf::Uint8 r, const sf::Uint8 g, const sf::Uint8 b, const unsigned int alpha)
+	{
+		const unsigned int inverse = 255 - alpha;
+		destination[0] = static_cast<unsigned char>((r * alpha + destination[0] * inverse + 127) / 255);
+		destination[1] = static_cast<unsigned char>((g * alpha + destination[1] * inverse + 127) / 255);
+		destination[2] = static_cast<unsigned char>((b * alpha + destination[2] * inverse + 127) / 255);
+	}
+}
+
+HudCompositor::Layer HudCompositor::rasterize(const sf::Image& image, const int width, const int height, const sf::Color& mask)
+{
+	Layer layer;
+	const auto size = image.getSize();
+	if (size.x == 0 || size.y == 0 || width <= 0 || height <= 0)
+	{
+		return layer;
+	}
+
+	layer.width = width;
+	layer.height = height;
+	layer.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+	const auto source = image.getPixelsPtr();
+	auto destination = layer.pixels.data();
+	for (int y = 0; y < height; y++)
+	{
+		const auto row = source + static_cast<size_t>(y * size.y / height) * size.x * 4;
+		for (int x = 0; x < width; x++, destination += 4)
+		{
+			const auto pixel = row + static_cast<size_t>(x * size.x / width) * 4;
+			std::copy(pixel, pixel + 4, destination);
+			if (pixel[0] == mask.r && pixel[1] == mask.g && pixel[2] == mask.b && pixel[3] == mask.a)
+			{
+				destination[3] = 0;
+			}
+		}
+	}
+
+	return layer;
+}
+
+HudCompositor::Layer HudCompositor::rasterizeCircle(const float radius, const sf::Color& color)
+{
+	Layer layer;
+	layer.width = static_cast<int>(std::ceil(radius * 2.0f));
+	layer.height = layer.width;
+	layer.pixels.resize(static_cast<size_t>(layer.width) * layer.height * 4, 0);
+
+	for (int y = 0; y < layer.height; y++)
+	{
+		for (int x = 0; x < layer.width; x++)
+		{
+			const float dx = x + 0.5f - radius;
+			const float dy = y + 0.5f - radius;
+			if (dx * dx + dy * dy <= radius * radius)
+			{
+				auto pixel = &layer.pixels[(static_cast<size_t>(y) * layer.width + x) * 4];
+				pixel[0] = color.r;
+				pixel[1] = color.g;
+				pixel[2] = color.b;
+				pixel[3] = color.a;
+			}
+		}
+	}
+
+	return layer;
+}
+
+HudCompositor::HudCompositor(std::shared_ptr<const sf::Font> font) :
+	m_font(move(font))
+{
+	//Empty
+}
+
+int HudCompositor::addText(const unsigned int characterSize, const sf::Color& color)
+{
+	TextRun run;
+	run.characterSize = characterSize;
+	run.color = color;
+	m_runs.push_back(run);
+	return int(m_runs.size()) - 1;
+}
+
+void HudCompositor::setText(const int run, const std::string& text)
+{
+	auto& textRun = m_runs[run];
+	if (textRun.rasterized && textRun.text == text)
+	{
+		return;
+	}
+
+	textRun.text = text;
+	rasterizeText(textRun);
+}
+
+sf::IntRect HudCompositor::getTextBounds(const int run) const
+{
+	const auto& textRun = m_runs[run];
+	return sf::IntRect(textRun.offset.x, textRun.offset.y, textRun.layer.width, textRun.layer.height);
+}
+
+void HudCompositor::begin(unsigned char* buffer, const int width, const int height)
+{
+	m_buffer = buffer;
+	m_width = width;
+	m_height = height;
+	resetClip();
+}
+
+void HudCompositor::setClip(const sf::IntRect& clip)
+{
+	if (!clip.intersects(sf::IntRect(0, 0, m_width, m_height), m_clip))
+	{
+		m_clip = sf::IntRect();
+	}
+}
+
+void HudCompositor::blend(const Layer& layer, const int x, const int y)
+{
+	const int firstX = std::max(x, m_clip.left);
+	const int lastX = std::min(x + layer.width, m_clip.left + m_clip.width);
+	const int firstY = std::max(y, m_clip.top);
+	const int lastY = std::min(y + layer.height, m_clip.top + m_clip.height);
+
+	for (int row = firstY; row < lastY; row++)
+	{
+		auto source = layer.pixels.data() + (static_cast<size_t>(row - y) * layer.width + (firstX - x)) * 4;
+		auto destination = m_buffer + (static_cast<size_t>(row) * m_width + firstX) * 3;
+		for (int column = firstX; column < lastX; column++, source += 4, destination += 3)
+		{
+			if (source[3] != 0)
+			{
+				blendPixel(destination, source[0], source[1], source[2], source[3]);
+			}
+		}
+	}
+}
+
+void HudCompositor::blendText(const int run, const int x, const int y)
+{
+	const auto& textRun = m_runs[run];
+	blend(textRun.layer, x + textRun.offset.x, y + textRun.offset.y);
+}
+
+void HudCompositor::blendRect(const sf::FloatRect& rect, const sf::Color& color)
+{
+	//covers the pixels whose center is inside the rectangle
+	const int firstX = static_cast<int>(std::ceil(rect.left - 0.5f));
+	const int lastX = static_cast<int>(std::ceil(rect.left + rect.width - 0.5f));
+	const int firstY = std::max(static_cast<int>(std::ceil(rect.top - 0.5f)), m_clip.top);
+	const int lastY = std::min(static_cast<int>(std::ceil(rect.top + rect.height - 0.5f)), m_clip.top + m_clip.height);
+
+	for (int y = firstY; y < lastY; y++)
+	{
+		fillSpan(y, firstX, lastX, color);
+	}
+}
+
+void HudCompositor::blendOutline(const sf::FloatRect& rect, const int thickness, const sf::Color& color)
+{
+	const float t = float(thickness);
+	blendRect(sf::FloatRect(rect.left - t, rect.top - t, rect.width + 2.0f * t, t), color);
+	blendRect(sf::FloatRect(rect.left - t, rect.top + rect.height, rect.width + 2.0f * t, t), color);
+	blendRect(sf::FloatRect(rect.left - t, rect.top, t, rect.height), color);
+	blendRect(sf::FloatRect(rect.left + rect.width, rect.top, t, rect.height), color);
+}
+
+void HudCompositor::blendPolygon(const std::vector<sf::Vector2f>& points, const sf::Color& color)
+{
+	if (points.size() < 3)
+	{
+		return;
+	}
+
+	float top = points[0].y;
+	float bottom = points[0].y;
+	for (auto& point : points)
+	{
+		top = std::min(top, point.y);
+		bottom = std::max(bottom, point.y);
+	}
+
+	//spans between pairs of edge crossings at the pixel centers of each row
+	std::vector<float> crossings;
+	const int firstY = std::max(static_cast<int>(std::floor(top)), m_clip.top);
+	const int lastY = std::min(static_cast<int>(std::ceil(bottom)), m_clip.top + m_clip.height);
+	for (int y = firstY; y < lastY; y++)
+	{
+		const float center = y + 0.5f;
+		crossings.clear();
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			const auto& a = points[i];
+			const auto& b = points[(i + 1) % points.size()];
+			if ((a.y <= center) != (b.y <= center))
+			{
+				crossings.push_back(a.x + (center - a.y) * (b.x - a.x) / (b.y - a.y));
+			}
+		}
+		std::sort(crossings.begin(), crossings.end());
+
+		for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+		{
+			fillSpan(y, static_cast<int>(std::ceil(crossings[i] - 0.5f)), static_cast<int>(std::ceil(crossings[i + 1] - 0.5f)), color);
+		}
+	}
+}
+
+void HudCompositor::rasterizeText(TextRun& run)
+{
+	cacheGlyphs(run.text, run.characterSize);
+
+	//laid out like sf::Text, the baseline of the first line is one character size down
+	struct Placed
+	{
+		const GlyphMask* glyph;
+		int x;
+		int y;
+	};
+	std::vector<Placed> placed;
+
+	float x = 0.0f;
+	const int baseline = int(run.characterSize);
+	int left = 0;
+	int top = 0;
+	int right = 0;
+	int bottom = 0;
+	sf::Uint32 previous = 0;
+	for (auto c : run.text)
+	{
+		const sf::Uint32 codePoint = static_cast<unsigned char>(c);
+		x += m_font->getKerning(previous, codePoint, run.characterSize);
+		previous = codePoint;
+
+		const auto& glyph = m_glyphs[glyphKey(codePoint, run.characterSize)];
+		if (glyph.width > 0 && glyph.height > 0)
+		{
+			const Placed p = { &glyph, static_cast<int>(std::floor(x)) + glyph.left, baseline + glyph.top };
+			if (placed.empty())
+			{
+				left = p.x;
+				top = p.y;
+				right = p.x + glyph.width;
+				bottom = p.y + glyph.height;
+			}
+			left = std::min(left, p.x);
+			top = std::min(top, p.y);
+			right = std::max(right, p.x + glyph.width);
+			bottom = std::max(bottom, p.y + glyph.height);
+			placed.push_back(p);
+		}
+		x += glyph.advance;
+	}
+
+	run.rasterized = true;
+	run.offset = sf::Vector2i(left, top);
+	run.layer.width = right - left;
+	run.layer.height = bottom - top;
+	run.layer.pixels.assign(static_cast<size_t>(run.layer.width) * run.layer.height * 4, 0);
+
+	//coverage first, overlapping glyphs keep the larger one
+	for (auto& p : placed)
+	{
+		for (int gy = 0; gy < p.glyph->height; gy++)
+		{
+			auto source = p.glyph->alpha.data() + static_cast<size_t>(gy) * p.glyph->width;
+			auto destination = run.layer.pixels.data() + (static_cast<size_t>(p.y - top + gy) * run.layer.width + (p.x - left)) * 4;
+			for (int gx = 0; gx < p.glyph->width; gx++, destination += 4)
+			{
+				destination[3] = std::max(destination[3], source[gx]);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < run.layer.pixels.size(); i += 4)
+	{
+		auto pixel = &run.layer.pixels[i];
+		pixel[0] = run.color.r;
+		pixel[1] = run.color.g;
+		pixel[2] = run.color.b;
+		pixel[3] = static_cast<sf::Uint8>(pixel[3] * run.color.a / 255);
+	}
+}
+
+void HudCompositor::cacheGlyphs(const std::string& text, const unsigned int characterSize)
+{
+	std::vector<sf::Uint32> missing;
+	for (auto c : text)
+	{
+		const sf::Uint32 codePoint = static_cast<unsigned char>(c);
+		if (m_glyphs.find(glyphKey(codePoint, characterSize)) == m_glyphs.end() &&
+			std::find(missing.begin(), missing.end(), codePoint) == missing.end())
+		{
+			//adds the glyph to the font texture
+			m_font->getGlyph(codePoint, characterSize, false);
+			missing.push_back(codePoint);
+		}
+	}
+
+	if (missing.empty())
+	{
+		return;
+	}
+
+	const auto page = m_font->getTexture(characterSize).copyToImage();
+	const auto pageSize = page.getSize();
+	const auto pixels = page.getPixelsPtr();
+	for (auto codePoint : missing)
+	{
+		const auto& glyph = m_font->getGlyph(codePoint, characterSize, false);
+
+		GlyphMask mask;
+		mask.left = static_cast<int>(std::floor(glyph.bounds.left));
+		mask.top = static_cast<int>(std::floor(glyph.bounds.top));
+		mask.advance = glyph.advance;
+
+		const auto rect = glyph.textureRect;
+		if (rect.width > 0 && rect.height > 0 && rect.left + rect.width <= int(pageSize.x) && rect.top + rect.height <= int(pageSize.y))
+		{
+			mask.width = rect.width;
+			mask.height = rect.height;
+			mask.alpha.resize(static_cast<size_t>(rect.width) * rect.height);
+			for (int y = 0; y < rect.height; y++)
+			{
+				for (int x = 0; x < rect.width; x++)
+				{
+					mask.alpha[static_cast<size_t>(y) * rect.width + x] = pixels[(static_cast<size_t>(rect.top + y) * pageSize.x + rect.left + x) * 4 + 3];
+				}
+			}
+		}
+
+		m_glyphs[glyphKey(codePoint, characterSize)] = std::move(mask);
+	}
+}
+
+void HudCompositor::fillSpan(const int y, int x0, int x1, const sf::Color& color)
+{
+	if (y < m_clip.top || y >= m_clip.top + m_clip.height)
+	{
+		return;
+	}
+
+	x0 = std::max(x0, m_clip.left);
+	x1 = std::min(x1, m_clip.left + m_clip.width);
+	auto destination = m_buffer + (static_cast<size_t>(y) * m_width + x0) * 3;
+	for (int x = x0; x < x1; x++, destination += 3)
+	{
+		blendPixel(destination, color.r, color.g, color.b, color.a);
+	}
+}
+
+std::uint64_t HudCompositor::glyphKey(const sf::Uint32 codePoint, const unsigned int characterSize)
+{
+	return (static_cast<std::uint64_t>(characterSize) << 32) | codePoint;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Blends the play state's HUD into the raycaster's RGB frame before it is uploaded,
+// so a frame is drawn with the raycaster's single quad and SFML's GL states are not needed.
+// Images are rasterized once into layers. Text is laid out from glyphs copied out of the
+// font texture the first time they are used, a run is rasterized again only when its string changes.
+class HudCompositor
+{
+public:
+
+	// RGBA pixels, blended with their alpha
+	struct Layer
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<sf::Uint8> pixels;
+	};
+
+	// scaled to width x height with the nearest pixel, pixels of the mask color become transparent
+	static Layer rasterize(const sf::Image& image, const int width, const int height, const sf::Color& mask = sf::Color::Transparent);
+	// filled circle covering the pixels whose center is inside it
+	static Layer rasterizeCircle(const float radius, const sf::Color& color);
+
+	explicit HudCompositor(std::shared_ptr<const sf::Font> font);
+	virtual ~HudCompositor() = default;
+
+	// returns the id of a new text run
+	int addText(const unsigned int characterSize, const sf::Color& color);
+	void setText(const int run, const std::string& text);
+	// pixels the run covers relative to its position, like sf::Text::getLocalBounds()
+	sf::IntRect getTextBounds(const int run) const;
+
+	// RGB frame the blend functions draw into, rows without padding
+	void begin(unsigned char* buffer, const int width, const int height);
+	// blending outside the clip rectangle is dropped, begin() and resetClip() clip to the frame
+	void setClip(const sf::IntRect& clip);
+	void resetClip() { m_clip = sf::IntRect(0, 0, m_width, m_height); }
+
+	void blend(const Layer& layer, const int x, const int y);
+	void blendText(const int run, const int x, const int y);
+	void blendRect(const sf::FloatRect& rect, const sf::Color& color);
+	// border of thickness pixels around the outside of the rectangle
+	void blendOutline(const sf::FloatRect& rect, const int thickness, const sf::Color& color);
+	// even-odd filled, concave polygons are allowed
+	void blendPolygon(const std::vector<sf::Vector2f>& points, const sf::Color& color);
+
+private:
+
+	// coverage of a glyph, positioned like sf::Glyph::bounds
+	struct GlyphMask
+	{
+		int left = 0;
+		int top = 0;
+		int width = 0;
+		int height = 0;
+		float advance = 0.0f;
+		std::vector<sf::Uint8> alpha;
+	};
+
+	struct TextRun
+	{
+		unsigned int characterSize;
+		sf::Color color;
+		std::string text;
+		bool rasterized = false;
+		sf::Vector2i offset;
+		Layer layer;
+	};
+
+	std::shared_ptr<const sf::Font> m_font;
+	std::unordered_map<std::uint64_t, GlyphMask> m_glyphs;
+	std::vector<TextRun> m_runs;
+
+	unsigned char* m_buffer = nullptr;
+	int m_width = 0;
+	int m_height = 0;
+	sf::IntRect m_clip;
+
+	void rasterizeText(TextRun& run);
+	// copies the glyphs of the string that are not cached yet, one read of the font texture for all of them
+	void cacheGlyphs(const std::string& text, const unsigned int characterSize);
+	void fillSpan(const int y, int x0, int x1, const sf::Color& color);
+
+	static std::uint64_t glyphKey(const sf::Uint32 codePoint, const unsigned int characterSize);
+};
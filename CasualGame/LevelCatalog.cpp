@@ -0,0 +1,218 @@
+#include "LevelCatalog.h"
+
+#include "LevelReaderWriter.h"
+#include "Sprite.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::tr2::sys;
+
+namespace
+{
+	bool byName(const LevelCatalogEntry& a, const LevelCatalogEntry& b)
+	{
+		return a.name < b.name;
+	}
+
+	// hashes the file in blocks, chunked levels can be larger than memory
+	sf::Uint32 hashFile(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		std::vector<char> block(1 << 16);
+		auto hash = Utils::checksum(nullptr, 0);
+		while (file.read(block.data(), block.size()) || file.gcount() > 0)
+		{
+			hash = Utils::checksum(block.data(), static_cast<size_t>(file.gcount()), hash);
+		}
+		return hash;
+	}
+}
+
+LevelCatalog::LevelCatalog(const std::string& directory, const std::string& catalogFile) :
+	m_directory(directory),
+	m_catalogFile(catalogFile)
+{
+}
+
+bool LevelCatalog::load()
+{
+	std::ifstream file(m_catalogFile);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	m_entries.clear();
+
+	//one tab separated entry per line
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		LevelCatalogEntry entry;
+		if (std::getline(fields, entry.name, '\t') &&
+			fields >> entry.sizeX >> entry.sizeY >> entry.spriteCount >> entry.modified >> entry.fileSize >> entry.hash)
+		{
+			m_entries.push_back(entry);
+		}
+	}
+
+	std::sort(m_entries.begin(), m_entries.end(), byName);
+	m_modified = false;
+	return true;
+}
+
+bool LevelCatalog::save() const
+{
+	std::ofstream file(m_catalogFile, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write the level catalog: " << m_catalogFile << std::endl;
+		return false;
+	}
+
+	file << "# name\tsizeX sizeY sprites modified size hash\n";
+	for (auto& entry : m_entries)
+	{
+		file << entry.name << '\t' << entry.sizeX << ' ' << entry.sizeY << ' ' << entry.spriteCount << ' '
+			<< entry.modified << ' ' << entry.fileSize << ' ' << entry.hash << '\n';
+	}
+
+	m_modified = false;
+	return file.good();
+}
+
+size_t LevelCatalog::refresh()
+{
+	const auto directory = fs::path(m_directory);
+	if (!fs::is_directory(directory))
+	{
+		const size_t removed = m_entries.size();
+		m_entries.clear();
+		m_modified = m_modified || removed > 0;
+		return removed;
+	}
+
+	std::vector<LevelCatalogEntry> entries;
+	size_t changes = 0;
+
+	for (auto it = fs::directory_iterator(directory); it != fs::directory_iterator(); ++it)
+	{
+		if (fs::is_directory(it->path()))
+		{
+			continue;
+		}
+
+		//levels being saved are only listed once they replaced their file
+		const auto name = it->path().filename().string();
+		if (Utils::isTemporaryFile(name))
+		{
+			continue;
+		}
+
+		const auto modified = static_cast<long long>(fs::last_write_time(it->path()).time_since_epoch().count());
+		const auto fileSize = static_cast<unsigned long long>(fs::file_size(it->path()));
+
+		//unchanged files keep their cached metadata
+		auto cached = find(name);
+		if (cached && cached->modified == modified && cached->fileSize == fileSize)
+		{
+			entries.push_back(*cached);
+			continue;
+		}
+
+		LevelCatalogEntry entry;
+		if (readEntry(m_directory, name, entry))
+		{
+			entries.push_back(entry);
+			changes++;
+		}
+	}
+
+	std::sort(entries.begin(), entries.end(), byName);
+
+	//entries whose file is gone
+	for (auto& entry : m_entries)
+	{
+		if (!std::binary_search(entries.begin(), entries.end(), entry, byName))
+		{
+			changes++;
+		}
+	}
+
+	m_entries.swap(entries);
+	m_modified = m_modified || changes > 0;
+	return changes;
+}
+
+void LevelCatalog::update(const std::string& name)
+{
+	LevelCatalogEntry entry;
+	set(name, readEntry(m_directory, name, entry) ? &entry : nullptr);
+}
+
+void LevelCatalog::set(const std::string& name, const LevelCatalogEntry* entry)
+{
+	LevelCatalogEntry key;
+	key.name = name;
+	auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key, byName);
+	if (it != m_entries.end() && it->name == name)
+	{
+		m_entries.erase(it);
+	}
+
+	if (entry)
+	{
+		insert(*entry);
+	}
+	m_modified = true;
+}
+
+const LevelCatalogEntry* LevelCatalog::find(const std::string& name) const
+{
+	LevelCatalogEntry key;
+	key.name = name;
+	auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key, byName);
+	return it != m_entries.end() && it->name == name ? &*it : nullptr;
+}
+
+bool LevelCatalog::readEntry(const std::string& directory, const std::string& name, LevelCatalogEntry& entry)
+{
+	const auto path = directory + name;
+	if (!fs::exists(fs::path(path)))
+	{
+		return false;
+	}
+
+	TileMap level;
+	std::vector<Sprite> sprites;
+	if (!LevelReaderWriter::readLevelFile(path, level, sprites))
+	{
+		return false;
+	}
+
+	entry.name = name;
+	entry.sizeX = level.getSizeX();
+	entry.sizeY = level.getSizeY();
+	entry.spriteCount = sprites.size();
+	entry.modified = static_cast<long long>(fs::last_write_time(fs::path(path)).time_since_epoch().count());
+	entry.fileSize = static_cast<unsigned long long>(fs::file_size(fs::path(path)));
+	entry.hash = hashFile(path);
+	return true;
+}
+
+void LevelCatalog::insert(LevelCatalogEntry entry)
+{
+	auto it = std::upper_bound(m_entries.begin(), m_entries.end(), entry, byName);
+	m_entries.insert(it, std::move(entry));
+}
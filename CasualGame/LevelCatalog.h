@@ -0,0 +1,56 @@
+#pragma once
+
+#include <SFML/Config.hpp>
+#include <string>
+#include <vector>
+
+struct LevelCatalogEntry
+{
+	std::string name;
+	int sizeX = 0;
+	int sizeY = 0;
+	size_t spriteCount = 0;
+	long long modified = 0;
+	unsigned long long fileSize = 0;
+	sf::Uint32 hash = 0;
+};
+
+// Metadata of the custom levels, persisted next to them so startup does not parse every level.
+// A level is only read again when the size or the modification time of its file changed.
+class LevelCatalog
+{
+public:
+	LevelCatalog(const std::string& directory, const std::string& catalogFile);
+	virtual ~LevelCatalog() = default;
+
+	bool load();
+	bool save() const;
+
+	// compares the catalog with the directory and re-reads new and changed levels,
+	// returns the number of added, changed and removed entries
+	size_t refresh();
+
+	// re-reads a single level after it was written, removes it if the file is gone
+	void update(const std::string& name);
+
+	// replaces the entry of a level, nullptr removes it
+	void set(const std::string& name, const LevelCatalogEntry* entry);
+
+	// reads the metadata of a level file, only touches the file so it can run on any thread
+	static bool readEntry(const std::string& directory, const std::string& name, LevelCatalogEntry& entry);
+
+	// sorted by name
+	const std::vector<LevelCatalogEntry>& getEntries() const { return m_entries; }
+	const LevelCatalogEntry* find(const std::string& name) const;
+
+	bool isModified() const { return m_modified; }
+
+private:
+
+	std::string m_directory;
+	std::string m_catalogFile;
+	std::vector<LevelCatalogEntry> m_entries;
+	mutable bool m_modified = false;
+
+	void insert(LevelCatalogEntry entry);
+};
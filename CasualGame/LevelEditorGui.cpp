@@ -1,11 +1,13 @@
 #include "LevelEditorGui.h"
 
+#include "ResourceCache.h"
 #include "Config.h"
 
 LevelEditorGui::LevelEditorGui(const int x, const int y, const int width) :
 	m_xPos(x),
 	m_yPos(y),
-	m_width(width)
+	m_width(width),
+	m_font(ResourceCache::get().getFont(g_fontFile))
 {
 	//Empty
 }
@@ -13,7 +15,7 @@ LevelEditorGui::LevelEditorGui(const int x, const int y, const int width) :
 int LevelEditorGui::addButton(const std::string & text)
 {
 	sf::Text btnText;
-	btnText.setFont(g_fontLoader->getFont());
+	btnText.setFont(*m_font);
 	btnText.setString(text);
 	btnText.setCharacterSize(22);
 	btnText.setOrigin(0.0f, btnText.getGlobalBounds().height / 2.0f);
@@ -49,10 +51,13 @@ void LevelEditorGui::handleInput(const sf::Event & event, const sf::Vector2f & m
 {
 	auto mousePressed = event.type == sf::Event::MouseButtonPressed;
 
-	for (auto& button : m_buttons)
+	m_hovered = -1;
+	for (size_t i = 0; i < m_buttons.size(); i++)
 	{
+		auto& button = m_buttons[i];
 		if (button.background.getGlobalBounds().contains(mousepPosition))
 		{
+			m_hovered = int(i);
 			button.background.setOutlineColor(m_hoverColor);
 			button.text.setFillColor(m_hoverColor);
 			button.pressed = mousePressed;
@@ -74,6 +79,17 @@ void LevelEditorGui::draw(sf::RenderWindow & window)
 	}
 }
 
+bool LevelEditorGui::getPressed(const int index)
+{
+	auto& button = m_buttons[index];
+	if (button.pressed)
+	{
+		button.pressed = false;
+		return true;
+	}
+	return false;
+}
+
 bool LevelEditorGui::getPressed(const std::string & text)
 {
 	for (auto& button : m_buttons)
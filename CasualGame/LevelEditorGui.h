@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <memory>
 
 struct GuiButton
 {
@@ -25,6 +26,10 @@ public:
 	void draw(sf::RenderWindow& window);
 
 	bool getPressed(const std::string& text);
+	bool getPressed(const int index);
+
+	// index of the button under the mouse or -1
+	int getHovered() const { return m_hovered; };
 
 	GuiButton& get(const int index) { return m_buttons[index]; };
 
@@ -38,11 +43,13 @@ private:
 	int m_xPos;
 	int m_yPos;
 	int m_width;
+	std::shared_ptr<const sf::Font> m_font;
 
 	sf::Color m_idleColor = sf::Color::White;
 	sf::Color m_hoverColor = sf::Color::Green;
 
 	std::vector<GuiButton> m_buttons;
+	int m_hovered = -1;
 
 };
 
@@ -5,40 +5,86 @@
 #include "Player.h"
 #include "LevelReaderWriter.h"
 #include "LevelEditorGui.h"
+#include "ProgressBar.h"
+#include "ThumbnailGenerator.h"
+#include "EditorTileLayer.h"
+#include "SpriteIndex.h"
+#include "EditJournal.h"
+#include "EditorBrush.h"
+#include "EditorPreview.h"
+#include "Autosaver.h"
+#include "LevelCatalog.h"
+#include "ResourceCache.h"
 #include "Config.h"
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+
 LevelEditorState::LevelEditorState(const int w, const int h, std::shared_ptr<Player> player, std::shared_ptr<LevelReaderWriter> levelReader) :
 	m_windowWidth(w),
 	m_windowHeight(h),
 	m_player(move(player)),
-	m_levelReader(move(levelReader))
+	m_levelReader(move(levelReader)),
+	m_font(ResourceCache::get().getFont(g_fontFile))
 {
-	m_scale = float(h - 30) / m_levelReader->getLevel().size();
+	fitView();
 
-	m_statusBar.setFont(g_fontLoader->getFont());
-	m_statusBar.setString(g_editorTxtModeWall);
+	m_statusBar.setFont(*m_font);
 	m_statusBar.setCharacterSize(32);
-
-	m_statusBar.setPosition(10.f, float(h));
-	m_statusBar.setOrigin(0.0f, m_statusBar.getGlobalBounds().height * 2.0f);
-
 	m_statusBar.setFillColor(sf::Color::Black);
 
+	m_journal = std::make_unique<EditJournal>(g_editorJournalBudget);
+	updateHistoryText();
+
 	m_customLevels = m_levelReader->getCustomLevels();
+	//the palette and the previews need every texture, not just the ones of the level
+	m_levelReader->loadAllTextures();
+	m_thumbnails = std::make_unique<ThumbnailGenerator>(m_levelReader->getTextures(), g_thumbnailDirectory);
+	m_tiles = std::make_unique<EditorTileLayer>(m_levelReader);
+	m_spriteIndex = std::make_unique<SpriteIndex>(g_editorSpriteIndexCellSize);
+	m_spriteIndex->rebuild(m_levelReader->getSprites());
+	m_spriteQuads.resize(g_textureCount, sf::VertexArray(sf::Quads));
+
+	//view from the player marker in the top left corner of the map
+	m_preview = std::make_unique<EditorPreview>(g_editorPreviewWidth, g_editorPreviewHeight, m_player, m_levelReader);
+	m_preview->setPosition(sf::Vector2f(10.0f, 10.0f), g_editorPreviewScale);
+	m_previewText.setFont(*m_font);
+	m_previewText.setString(g_editorTxtPreview);
+	m_previewText.setCharacterSize(16);
+	m_previewText.setFillColor(sf::Color::Black);
+	m_previewText.setPosition(10.0f, 14.0f + g_editorPreviewHeight * g_editorPreviewScale);
+
+	m_autosaver = m_levelReader->getAutosaver();
+	m_canRecover = m_autosaver->canRecover();
+	if (!m_levelReader->isLoading())
+	{
+		beginAutosave();
+	}
 
 	//Gui
 	m_gui = std::make_unique<LevelEditorGui>(w - g_editorMenuWidth + 1, 10, g_editorMenuWidth);
 	m_gui->addButton(g_editorTxtSwitchMode);
+	m_toolButtonId = m_gui->addButton(g_editorTxtTool);
 	m_gui->addButton(g_editorTxtLoadDefault);
 
+	//custom levels are listed a page at a time
 	m_gui->addSpace();
+	for (int i = 0; i < g_editorLevelsPerPage; i++)
+	{
+		m_levelButtonIds.push_back(m_gui->addButton(g_editorTxtNextPage));
+	}
+	m_pageButtonId = m_gui->addButton(g_editorTxtNextPage);
+	showLevelPage(0);
 	for (auto& cl : m_customLevels)
 	{
-		m_gui->addButton(cl);
+		requestPreview(cl, false);
 	}
 	m_gui->addSpace();
 	m_filenameGuiIndex = m_gui->addButton(m_customLevelName);
 	m_gui->addButton(g_editorTxtSave);
+	m_recoverButtonId = m_gui->addButton(m_canRecover ? g_editorTxtRecover : g_editorTxtAutosaveOn);
 	m_gui->addSpace();
 	m_gui->addButton(g_editorTxtQuit);
 	m_gui->addSpace();
@@ -51,11 +97,99 @@ LevelEditorState::LevelEditorState(const int w, const int h, std::shared_ptr<Pla
 	m_gui->setTexturedButton(m_spriteButtonId, m_levelReader->getTextureSfml(m_selectedSprite - 1));
 
 	m_gui->get(m_spriteButtonId).background.setSize({ 100,100 });
+	setTool(BrushTool::PEN);
+
+	const float editorWidth = float(w - g_editorMenuWidth);
+	m_loadingBar = std::make_unique<ProgressBar>(sf::Vector2f(editorWidth / 4.0f, h / 2.0f), sf::Vector2f(editorWidth / 2.0f, 20.0f), g_txtLoadingLevel);
 }
 
+LevelEditorState::~LevelEditorState() = default;
+
 void LevelEditorState::update(const float ft)
 {
-	//Empty
+	if (m_levelReader->isLoading())
+	{
+		m_loadingBar->setProgress(m_levelReader->getLoadProgress());
+	}
+	else
+	{
+		//a failed load keeps the old level and its pose
+		m_resetPlayerOnLoad = false;
+
+		if (m_showPreview)
+		{
+			m_preview->update();
+		}
+	}
+
+	//the first edit replaces the log of the earlier session
+	if (m_canRecover && m_autosaver->hasPending())
+	{
+		m_canRecover = false;
+		m_gui->get(m_recoverButtonId).text.setString(g_editorTxtAutosaveOn);
+	}
+
+	m_autosaver->copyLines(g_editorAutosaveCopyTiles);
+	m_autosaveTime += ft;
+	if (m_autosaveTime >= g_editorAutosaveInterval)
+	{
+		m_autosaveTime = 0.0f;
+		m_autosaver->flush();
+	}
+
+	//chunks of a paged level the view, the preview and the brushes read are evicted like in play
+	if (!m_levelReader->isLoading())
+	{
+		m_levelReader->getLevel().trim();
+	}
+}
+
+bool LevelEditorState::hasUnsavedEdits() const
+{
+	return m_unsavedEdits || m_autosaver->hasPending();
+}
+
+void LevelEditorState::onLevelChangedOnDisk()
+{
+	m_changedOnDisk = true;
+	updateStatusBar();
+}
+
+void LevelEditorState::onLevelLoaded()
+{
+	if (m_resetPlayerOnLoad)
+	{
+		m_resetPlayerOnLoad = false;
+		resetPlayer();
+	}
+	m_unsavedEdits = false;
+	m_changedOnDisk = false;
+	m_selectedSprites.clear();
+	m_boxSelecting = false;
+	m_spriteIndex->rebuild(m_levelReader->getSprites());
+	m_painting = false;
+	m_hasRegion = false;
+	updateBrushPreview();
+	m_journal->clear();
+	updateHistoryText();
+	fitView();
+	m_tiles->reset();
+	m_preview->invalidate();
+	beginAutosave();
+
+	//textures the new level does not use were released
+	m_gui->setTexturedButton(m_textureButtonId, m_levelReader->getTextureSfml(m_selectedTexture - 1));
+	m_gui->setTexturedButton(m_spriteButtonId, m_levelReader->getTextureSfml(m_selectedSprite - 1));
+}
+
+void LevelEditorState::onCustomLevelsChanged()
+{
+	m_customLevels = m_levelReader->getCustomLevels();
+	showLevelPage(m_levelPage);
+	for (auto& cl : m_customLevels)
+	{
+		requestPreview(cl, false);
+	}
 }
 
 void LevelEditorState::draw(sf::RenderWindow & window)
@@ -72,14 +206,53 @@ void LevelEditorState::draw(sf::RenderWindow & window)
 	// Render Player on map
 	drawPlayer(window);
 
-	//walls
-	drawWalls(window);
+	//walls and entities are drawn in tile units
+	window.setView(getMapView());
+
+	if (!m_editEntities)
+	{
+		m_tiles->setColors(sf::Color(255, 255, 255, 255), sf::Color(0, 0, 0, 255));
+	}
+	else
+	{
+		m_tiles->setColors(sf::Color(255, 255, 255, 100), sf::Color(0, 0, 0, 100));
+	}
+	m_tiles->draw(window, getVisibleArea());
+
+	//shape being dragged, selected region and where the clipboard would be pasted
+	if (!m_editEntities)
+	{
+		window.draw(m_brushPreview);
+		if (m_tool == BrushTool::REGION && m_clipboard && !m_painting)
+		{
+			const auto tile = toTile(toMap(m_mousePos));
+			sf::RectangleShape paste({ float(m_clipboard->sizeY), float(m_clipboard->sizeX) });
+			paste.setPosition(float(tile.y), float(tile.x));
+			paste.setOutlineThickness(1.0f / m_scale);
+			paste.setOutlineColor(sf::Color(0, 128, 255, 255));
+			paste.setFillColor(sf::Color(0, 0, 0, 0));
+			window.draw(paste);
+		}
+	}
 
-	// Render entities on minimap
 	drawSprites(window);
 
+	window.setView(window.getDefaultView());
+
+	//selection box in progress
+	if (m_boxSelecting)
+	{
+		const auto start = toScreen(m_boxStart);
+		sf::RectangleShape box(m_mousePos - start);
+		box.setPosition(start);
+		box.setOutlineThickness(1);
+		box.setOutlineColor(sf::Color(0, 255, 0, 255));
+		box.setFillColor(sf::Color(0, 255, 0, 40));
+		window.draw(box);
+	}
+
 	// Render placement square under mouse
-	if (m_editEntities && (m_entitySelected != -1))
+	if (m_editEntities && !m_selectedSprites.empty())
 	{
 		sf::RectangleShape mouseRect(sf::Vector2f(m_scale - 1.0f, m_scale - 1.0f));
 		mouseRect.setPosition(m_mousePos.x, m_mousePos.y);
@@ -92,9 +265,20 @@ void LevelEditorState::draw(sf::RenderWindow & window)
 
 	//draw status bar
 	window.draw(m_statusBar);
+	if (m_showPreview)
+	{
+		window.draw(*m_preview);
+		window.draw(m_previewText);
+	}
 
 	//draw Gui Menu
 	m_gui->draw(window);
+	drawLevelPreview(window);
+
+	if (m_levelReader->isLoading())
+	{
+		window.draw(*m_loadingBar);
+	}
 
 	window.display();
 
@@ -116,18 +300,81 @@ void LevelEditorState::handleInput(const sf::Event & event, const sf::Vector2f&
 	m_gui->handleInput(event, mousepPosition);
 	handleMenuCallbacks(event, game);
 
-	//is the mouse inside the editor area
-	const auto levelSize = m_levelReader->getLevel().size();
-	auto mouseInEditor = (mousepPosition.x < levelSize * m_scale);
+	//is the mouse inside the editor area, the level is not editable while another one loads
+	const auto& level = m_levelReader->getLevel();
+	const auto mapPosition = toMap(mousepPosition);
+	const bool mouseInMap = mousepPosition.x < m_windowWidth - g_editorMenuWidth &&
+		!(m_showPreview && m_preview->getBounds().contains(mousepPosition));
+	auto mouseInEditor = !m_levelReader->isLoading() && mouseInMap && mapPosition.x >= 0.0f && mapPosition.y >= 0.0f &&
+		level.contains(int(mapPosition.y), int(mapPosition.x));
+
+	//pan with the middle mouse button, zoom with the wheel
+	if (event.type == sf::Event::MouseWheelScrolled && mouseInMap)
+	{
+		zoom(std::pow(g_editorZoomStep, event.mouseWheelScroll.delta), mousepPosition);
+	}
+	if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Middle && mouseInMap)
+	{
+		m_panning = true;
+		m_panOrigin = mousepPosition;
+	}
+	if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Middle)
+	{
+		m_panning = false;
+	}
+	if (event.type == sf::Event::MouseMoved && m_panning)
+	{
+		m_viewOffset -= (mousepPosition - m_panOrigin) / m_scale;
+		m_panOrigin = mousepPosition;
+	}
+
+	//undo with ctrl+z, redo with ctrl+y or ctrl+shift+z, repeats while held
+	//regions are copied with ctrl+c and pasted at the mouse with ctrl+v
+	if (event.type == sf::Event::KeyPressed && event.key.control && !m_painting && !m_levelReader->isLoading())
+	{
+		if (event.key.code == sf::Keyboard::Z && !event.key.shift)
+		{
+			undo(true);
+		}
+		else if (event.key.code == sf::Keyboard::Y || event.key.code == sf::Keyboard::Z)
+		{
+			undo(false);
+		}
+		else if (event.key.code == sf::Keyboard::C)
+		{
+			copyRegion();
+		}
+		else if (event.key.code == sf::Keyboard::V && mouseInEditor)
+		{
+			pasteRegion(toTile(mapPosition));
+		}
+	}
+
+	//a wall tool drag ends when its button is released, wherever the mouse is,
+	//a release outside the window is never reported so leaving it ends the drag too
+	if (m_painting && ((event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == m_paintButton) ||
+		event.type == sf::Event::LostFocus || event.type == sf::Event::MouseLeft))
+	{
+		endDrag();
+	}
+	if (event.type == sf::Event::MouseMoved && m_painting && !m_levelReader->isLoading())
+	{
+		continueDrag(toTile(mapPosition), mouseInEditor);
+	}
 
 	//process button press
 	if (event.type == sf::Event::KeyReleased)
 	{
 		if (event.key.code == sf::Keyboard::Escape)
 		{
-			if (m_entitySelected != -1)
+			if (!m_selectedSprites.empty())
+			{
+				m_selectedSprites.clear();
+			}
+			else if (m_hasRegion)
 			{
-				m_entitySelected = -1;
+				m_hasRegion = false;
+				updateBrushPreview();
 			}
 			else
 			{
@@ -138,47 +385,88 @@ void LevelEditorState::handleInput(const sf::Event & event, const sf::Vector2f&
 		{
 			toggleMode();
 		}
+		if (event.key.code == sf::Keyboard::Home)
+		{
+			fitView();
+		}
+		if (event.key.code == sf::Keyboard::F5 && m_changedOnDisk && !m_levelReader->isLoading())
+		{
+			m_changedOnDisk = false;
+			m_levelReader->loadLevelFileAsync(m_levelReader->getLevelPath());
+			updateStatusBar();
+		}
+		if (event.key.code == sf::Keyboard::T && !m_painting)
+		{
+			setTool(BrushTool((int(m_tool) + 1) % int(BrushTool::COUNT)));
+		}
+		if (event.key.code == sf::Keyboard::R && !event.key.control)
+		{
+			rotateClipboard();
+		}
+
+		//the preview looks from the player marker, it can be placed and turned
+		if (event.key.code == sf::Keyboard::Tab)
+		{
+			m_showPreview = !m_showPreview;
+		}
+		if (event.key.code == sf::Keyboard::P && mouseInEditor)
+		{
+			m_player->m_posX = mapPosition.y;
+			m_player->m_posY = mapPosition.x;
+		}
+		if (event.key.code == sf::Keyboard::Q)
+		{
+			turnPlayer(g_editorPlayerTurnAngle);
+		}
+		if (event.key.code == sf::Keyboard::E)
+		{
+			turnPlayer(-g_editorPlayerTurnAngle);
+		}
 
 		//entity move with arrow keys
 		if (m_editEntities && mouseInEditor)
 		{
-			if (m_entitySelected != -1)
+			if (!m_selectedSprites.empty())
 			{
 				if (event.key.code == sf::Keyboard::Left)
 				{
-					Sprite spr = m_levelReader->getSprites()[m_entitySelected];
-					m_levelReader->moveSprite(m_entitySelected, spr.x, spr.y -= 0.1);
+					moveSelection(0.0, -0.1);
 				}
 				if (event.key.code == sf::Keyboard::Right)
 				{
-					Sprite spr = m_levelReader->getSprites()[m_entitySelected];
-					m_levelReader->moveSprite(m_entitySelected, spr.x, spr.y += 0.1);
+					moveSelection(0.0, 0.1);
 				}
 				if (event.key.code == sf::Keyboard::Up)
 				{
-					Sprite spr = m_levelReader->getSprites()[m_entitySelected];
-					m_levelReader->moveSprite(m_entitySelected, spr.x -= 0.1, spr.y);
+					moveSelection(-0.1, 0.0);
 				}
 				if (event.key.code == sf::Keyboard::Down)
 				{
-					Sprite spr = m_levelReader->getSprites()[m_entitySelected];
-					m_levelReader->moveSprite(m_entitySelected, spr.x += 0.1, spr.y);
+					moveSelection(0.1, 0.0);
 				}
 				if (event.key.code == sf::Keyboard::Delete)
 				{
-					m_levelReader->deleteSprite(m_entitySelected);
-					m_entitySelected = -1;
+					deleteSelection();
 				}
 			}
 		}
 	}
 
+	//finish a box selection, sprites are positioned line first
+	if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left && m_boxSelecting)
+	{
+		m_boxSelecting = false;
+		m_selectedSprites = m_spriteIndex->findInBox(
+			std::min(m_boxStart.y, mapPosition.y), std::min(m_boxStart.x, mapPosition.x),
+			std::max(m_boxStart.y, mapPosition.y), std::max(m_boxStart.x, mapPosition.x));
+	}
+
 	//process mouse click
-	if (event.type == sf::Event::MouseButtonPressed && mouseInEditor)
+	if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button != sf::Mouse::Middle && mouseInEditor)
 	{
 
-		const auto x = mousepPosition.x / m_scale;
-		const auto y = mousepPosition.y / m_scale;
+		const auto x = mapPosition.x;
+		const auto y = mapPosition.y;
 
 		//SPRITE EDITING
 		if (m_editEntities)
@@ -186,94 +474,706 @@ void LevelEditorState::handleInput(const sf::Event & event, const sf::Vector2f&
 
 			if (event.mouseButton.button == sf::Mouse::Left)
 			{
-				if (m_entitySelected != -1)
+				if (!m_selectedSprites.empty())
 				{
-					//move sprite data
-					m_levelReader->moveSprite(m_entitySelected, y, x);
-					m_entitySelected = -1;
+					//the selection keeps its layout, its center goes to the mouse
+					double centerX = 0.0;
+					double centerY = 0.0;
+					for (auto index : m_selectedSprites)
+					{
+						centerX += m_levelReader->getSprites()[index].x;
+						centerY += m_levelReader->getSprites()[index].y;
+					}
+					centerX /= m_selectedSprites.size();
+					centerY /= m_selectedSprites.size();
+
+					moveSelection(y - centerX, x - centerY);
+					m_selectedSprites.clear();
 				}
 				else
 				{
-					const auto spritesSize = m_levelReader->getSprites().size();
-					for (size_t i = 0; i < spritesSize; i++)
+					//sprites cover the tile around their position, an empty spot starts a selection box
+					const int picked = m_spriteIndex->findNearest(y, x, 0.5);
+					if (picked != -1)
+					{
+						m_selectedSprites.push_back(picked);
+					}
+					else
 					{
-						sf::RectangleShape object(sf::Vector2f(m_scale - 2.0f, m_scale - 2.0f));
-						object.setPosition(float(m_levelReader->getSprites()[i].y) * m_scale, float(m_levelReader->getSprites()[i].x) * m_scale);
-						object.setOrigin(m_scale / 2.0f, m_scale / 2.0f);
-						if (object.getGlobalBounds().contains(mousepPosition))
-						{
-							m_entitySelected = i;
-						}
+						m_boxSelecting = true;
+						m_boxStart = mapPosition;
 					}
 				}
 			}
 			else
 			{
-				m_levelReader->createSprite(y, x, m_selectedSprite - 1);
+				createSprite(y, x, m_selectedSprite - 1);
 			}
 
 		}
 		// WALL EDITING
-		else
+		else if (!m_painting)
 		{
-			auto xi = static_cast<int>(x);
-			auto yi = static_cast<int>(y);
+			beginDrag(toTile(mapPosition), event.mouseButton.button);
+		}
+	}
+}
 
-			if (event.mouseButton.button == sf::Mouse::Left)
+int LevelEditorState::getBrushValue(const sf::Mouse::Button button) const
+{
+	//set wall texture with left click, delete walls with right click
+	return button == sf::Mouse::Left ? m_selectedTexture : 0;
+}
+
+void LevelEditorState::beginDrag(const sf::Vector2i& tile, const sf::Mouse::Button button)
+{
+	//fills and pastes happen on the click, the other tools follow the mouse until the button is released
+	if (m_tool == BrushTool::FILL)
+	{
+		std::vector<TileRun> runs;
+		EditorBrush::floodFill(m_levelReader->getLevel(), tile.x, tile.y, getBrushValue(button), runs);
+		applyBrush(runs);
+		return;
+	}
+	if (m_tool == BrushTool::REGION && button != sf::Mouse::Left)
+	{
+		pasteRegion(tile);
+		return;
+	}
+
+	m_painting = true;
+	m_paintButton = button;
+	m_dragStart = tile;
+	m_dragEnd = tile;
+
+	if (m_tool == BrushTool::PEN)
+	{
+		//a stroke is undone as a whole
+		m_journal->beginStep();
+		paintTile(tile.x, tile.y, button);
+	}
+	else if (m_tool == BrushTool::REGION)
+	{
+		m_hasRegion = true;
+	}
+	updateBrushPreview();
+}
+
+void LevelEditorState::continueDrag(const sf::Vector2i& tile, const bool inLevel)
+{
+	if (m_tool == BrushTool::PEN)
+	{
+		if (inLevel)
+		{
+			paintTile(tile.x, tile.y, m_paintButton);
+		}
+	}
+	else if (tile != m_dragEnd)
+	{
+		//shapes and regions follow the mouse outside the level, clamped to its border
+		m_dragEnd = tile;
+		updateBrushPreview();
+	}
+}
+
+void LevelEditorState::endDrag()
+{
+	m_painting = false;
+
+	if (m_tool == BrushTool::PEN)
+	{
+		m_journal->endStep();
+		updateHistoryText();
+	}
+	else if (m_tool != BrushTool::REGION)
+	{
+		std::vector<TileRun> runs;
+		getShape(runs);
+		applyBrush(runs);
+	}
+	updateBrushPreview();
+}
+
+void LevelEditorState::getShape(std::vector<TileRun>& runs) const
+{
+	const int value = getBrushValue(m_paintButton);
+	switch (m_tool)
+	{
+	case BrushTool::LINE:
+		EditorBrush::line(m_dragStart.x, m_dragStart.y, m_dragEnd.x, m_dragEnd.y, value, runs);
+		break;
+	case BrushTool::RECTANGLE:
+	case BrushTool::FILLED_RECTANGLE:
+		EditorBrush::rectangle(m_dragStart.x, m_dragStart.y, m_dragEnd.x, m_dragEnd.y, m_tool == BrushTool::FILLED_RECTANGLE, value, runs);
+		break;
+	default:
+		break;
+	}
+}
+
+void LevelEditorState::applyBrush(const std::vector<TileRun>& runs)
+{
+	//only changed tiles are recorded, split where their previous value changes
+	const auto& level = m_levelReader->getLevel();
+	std::vector<EditJournal::TileEdit> edits;
+	for (auto& run : runs)
+	{
+		const bool borderLine = run.x == 0 || run.x == level.getSizeX() - 1;
+		for (int y = run.y; y < run.y + run.length; y++)
+		{
+			//Do not allow to delete the level outer walls, this breaks the raycaster
+			const bool border = borderLine || y == 0 || y == level.getSizeY() - 1;
+			const int before = level.get(run.x, y);
+			if (before == run.value || (border && run.value == 0))
 			{
-				//set wall texture with left click
-				m_levelReader->changeLevelTile(yi, xi, m_selectedTexture);
+				continue;
 			}
-			else
+
+			if (!edits.empty())
 			{
-				//delete walls with right click			
-				//Do not allow to delete the level outer walls, this breaks the raycaster
-				if (xi == 0 || xi == levelSize - 1)
-				{
-					m_levelReader->changeLevelTile(yi, xi, m_selectedTexture);
-				}
-				else if (yi == 0 || yi == levelSize - 1)
+				auto& last = edits.back();
+				if (last.x == run.x && last.y + last.length == y && last.before == before && last.after == run.value)
 				{
-					m_levelReader->changeLevelTile(yi, xi, m_selectedTexture);
-				}
-				else
-				{
-					m_levelReader->changeLevelTile(yi, xi, 0);
+					last.length++;
+					continue;
 				}
 			}
+			edits.push_back({ run.x, y, 1, before, run.value });
+		}
+	}
+
+	if (edits.empty())
+	{
+		return;
+	}
+
+	m_journal->recordTiles(edits);
+
+	std::vector<TileRun> changes;
+	changes.reserve(edits.size());
+	for (auto& edit : edits)
+	{
+		changes.push_back({ edit.x, edit.y, edit.length, edit.after });
+	}
+	applyTiles(changes);
+	updateHistoryText();
+}
+
+void LevelEditorState::updateBrushPreview()
+{
+	m_brushPreview.clear();
+
+	if (m_tool == BrushTool::REGION && m_hasRegion)
+	{
+		const sf::Vector2i first(std::min(m_dragStart.x, m_dragEnd.x), std::min(m_dragStart.y, m_dragEnd.y));
+		const sf::Vector2i last(std::max(m_dragStart.x, m_dragEnd.x), std::max(m_dragStart.y, m_dragEnd.y));
+		EditorTileLayer::appendQuad(m_brushPreview, sf::FloatRect(float(first.y), float(first.x), float(last.y - first.y + 1), float(last.x - first.x + 1)), sf::Color(0, 128, 255, 60));
+	}
+	else if (m_painting && m_tool != BrushTool::PEN)
+	{
+		std::vector<TileRun> runs;
+		getShape(runs);
+
+		const auto color = m_paintButton == sf::Mouse::Left ? sf::Color(0, 255, 0, 100) : sf::Color(255, 0, 0, 100);
+		for (auto& run : runs)
+		{
+			EditorTileLayer::appendQuad(m_brushPreview, sf::FloatRect(float(run.y), float(run.x), float(run.length), 1.0f), color);
+		}
+	}
+}
+
+void LevelEditorState::copyRegion()
+{
+	if (!m_hasRegion)
+	{
+		return;
+	}
+
+	const sf::Vector2i first(std::min(m_dragStart.x, m_dragEnd.x), std::min(m_dragStart.y, m_dragEnd.y));
+	const sf::Vector2i last(std::max(m_dragStart.x, m_dragEnd.x), std::max(m_dragStart.y, m_dragEnd.y));
+	m_clipboard = std::make_unique<TileRegion>(EditorBrush::copy(m_levelReader->getLevel(), first.x, first.y, last.x, last.y));
+
+	//sprites on the copied tiles come along
+	const auto& sprites = m_levelReader->getSprites();
+	for (auto index : m_spriteIndex->findInBox(first.x, first.y, last.x + 1.0, last.y + 1.0))
+	{
+		auto sprite = sprites[index];
+		if (sprite.x < last.x + 1.0 && sprite.y < last.y + 1.0)
+		{
+			sprite.x -= first.x;
+			sprite.y -= first.y;
+			m_clipboard->sprites.push_back(sprite);
+		}
+	}
+}
+
+void LevelEditorState::pasteRegion(const sf::Vector2i& tile)
+{
+	if (!m_clipboard || m_clipboard->empty())
+	{
+		return;
+	}
+
+	//tiles and sprites are undone together
+	m_journal->beginStep();
+
+	std::vector<TileRun> runs;
+	EditorBrush::paste(*m_clipboard, m_levelReader->getLevel(), tile.x, tile.y, runs);
+	applyBrush(runs);
+
+	const auto& level = m_levelReader->getLevel();
+	for (auto& sprite : m_clipboard->sprites)
+	{
+		const double x = tile.x + sprite.x;
+		const double y = tile.y + sprite.y;
+		if (level.contains(int(x), int(y)))
+		{
+			createSprite(x, y, sprite.texture);
+		}
+	}
+
+	m_journal->endStep();
+	updateHistoryText();
+}
+
+void LevelEditorState::rotateClipboard()
+{
+	if (m_tool == BrushTool::REGION && m_clipboard)
+	{
+		m_clipboard = std::make_unique<TileRegion>(EditorBrush::rotate(*m_clipboard));
+	}
+}
+
+void LevelEditorState::paintTile(const int x, const int y, const sf::Mouse::Button button)
+{
+	const auto& level = m_levelReader->getLevel();
+	if (button == sf::Mouse::Left)
+	{
+		//set wall texture with left click
+		setTile(x, y, m_selectedTexture);
+	}
+	else
+	{
+		//delete walls with right click
+		//Do not allow to delete the level outer walls, this breaks the raycaster
+		if (y == 0 || y == level.getSizeY() - 1)
+		{
+			setTile(x, y, m_selectedTexture);
+		}
+		else if (x == 0 || x == level.getSizeX() - 1)
+		{
+			setTile(x, y, m_selectedTexture);
+		}
+		else
+		{
+			setTile(x, y, 0);
+		}
+	}
+}
+
+void LevelEditorState::fitView()
+{
+	//level lines are drawn as rows, the longer side has to fit
+	const auto& level = m_levelReader->getLevel();
+	m_scale = float(m_windowHeight - 30) / std::max(std::max(level.getSizeX(), level.getSizeY()), 1);
+	m_scale = std::min(std::max(m_scale, g_editorMinTileSize), g_editorMaxTileSize);
+	m_viewOffset = sf::Vector2f(0.0f, 0.0f);
+}
+
+void LevelEditorState::zoom(const float factor, const sf::Vector2f& pixel)
+{
+	//the tile under the mouse stays in place
+	const auto anchor = toMap(pixel);
+	m_scale = std::min(std::max(m_scale * factor, g_editorMinTileSize), g_editorMaxTileSize);
+	m_viewOffset = anchor - pixel / m_scale;
+}
+
+sf::Vector2f LevelEditorState::toMap(const sf::Vector2f& pixel) const
+{
+	return m_viewOffset + pixel / m_scale;
+}
+
+sf::Vector2f LevelEditorState::toScreen(const sf::Vector2f& position) const
+{
+	return (position - m_viewOffset) * m_scale;
+}
+
+sf::FloatRect LevelEditorState::getVisibleArea() const
+{
+	const float mapWidth = float(m_windowWidth - g_editorMenuWidth);
+	return sf::FloatRect(m_viewOffset.x, m_viewOffset.y, mapWidth / m_scale, m_windowHeight / m_scale);
+}
+
+sf::Vector2i LevelEditorState::toTile(const sf::Vector2f& position) const
+{
+	//the screen x axis runs along the level columns
+	const auto& level = m_levelReader->getLevel();
+	const int x = std::min(std::max(int(std::floor(position.y)), 0), level.getSizeX() - 1);
+	const int y = std::min(std::max(int(std::floor(position.x)), 0), level.getSizeY() - 1);
+	return sf::Vector2i(x, y);
+}
+
+sf::View LevelEditorState::getMapView() const
+{
+	//the menu on the right is not part of the map
+	sf::View view(getVisibleArea());
+	view.setViewport(sf::FloatRect(0.0f, 0.0f, float(m_windowWidth - g_editorMenuWidth) / m_windowWidth, 1.0f));
+	return view;
+}
+
+void LevelEditorState::moveSelection(const double dx, const double dy)
+{
+	m_journal->beginStep();
+	for (auto index : m_selectedSprites)
+	{
+		auto sprite = m_levelReader->getSprites()[index];
+		const auto before = sprite;
+		sprite.x += dx;
+		sprite.y += dy;
+
+		m_journal->recordSprite({ EditJournal::SpriteAction::MOVE, index, before, sprite });
+		applySpriteMove(index, before, sprite);
+	}
+	m_journal->endStep();
+	updateHistoryText();
+}
+
+void LevelEditorState::deleteSelection()
+{
+	//the selection is sorted, recorded from the back so each index is valid when replayed one by one
+	m_journal->beginStep();
+	for (auto it = m_selectedSprites.rbegin(); it != m_selectedSprites.rend(); ++it)
+	{
+		const auto sprite = m_levelReader->getSprites()[*it];
+		m_journal->recordSprite({ EditJournal::SpriteAction::REMOVE, *it, sprite, sprite });
+	}
+	applySpriteRemoves(m_selectedSprites);
+	m_journal->endStep();
+	updateHistoryText();
+
+	m_selectedSprites.clear();
+}
+
+void LevelEditorState::createSprite(const double x, const double y, const int texture)
+{
+	Sprite sprite;
+	sprite.x = x;
+	sprite.y = y;
+	sprite.texture = texture;
+
+	const int index = int(m_levelReader->getSprites().size());
+	m_journal->recordSprite({ EditJournal::SpriteAction::CREATE, index, sprite, sprite });
+	applySpriteInsert(index, sprite);
+	updateHistoryText();
+}
+
+void LevelEditorState::setTile(const int x, const int y, const int value)
+{
+	const int before = m_levelReader->getLevel().get(x, y);
+	if (before == value)
+	{
+		return;
+	}
+
+	m_journal->recordTile(x, y, before, value);
+	applyTile(x, y, value);
+}
+
+void LevelEditorState::applyTile(const int x, const int y, const int value)
+{
+	m_unsavedEdits = true;
+	m_levelReader->changeLevelTile(x, y, value);
+	m_tiles->invalidate(x, y);
+	m_preview->invalidateArea(x, y, 1, 1);
+	m_autosaver->recordTiles({ { x, y, 1, value } });
+}
+
+void LevelEditorState::applyTiles(const std::vector<TileRun>& runs)
+{
+	m_unsavedEdits = true;
+	if (runs.empty())
+	{
+		return;
+	}
+
+	//the whole batch is written at once and invalidates the chunks of its bounding box
+	int firstX = INT_MAX;
+	int firstY = INT_MAX;
+	int lastX = INT_MIN;
+	int lastY = INT_MIN;
+	for (auto& run : runs)
+	{
+		firstX = std::min(firstX, run.x);
+		lastX = std::max(lastX, run.x);
+		firstY = std::min(firstY, run.y);
+		lastY = std::max(lastY, run.y + run.length - 1);
+	}
+
+	m_levelReader->changeLevelTiles(runs);
+	m_tiles->invalidate(firstX, firstY, lastX - firstX + 1, lastY - firstY + 1);
+	m_preview->invalidateArea(firstX, firstY, lastX - firstX + 1, lastY - firstY + 1);
+	m_autosaver->recordTiles(runs);
+}
+
+void LevelEditorState::applySpriteInsert(const int index, const Sprite& sprite)
+{
+	m_unsavedEdits = true;
+	m_levelReader->insertSprite(index, sprite);
+	m_spriteIndex->insert(index, sprite.x, sprite.y);
+	m_preview->invalidateSprite(sprite);
+	m_autosaver->recordSpriteInsert(index, sprite);
+}
+
+void LevelEditorState::applySpriteMove(const int index, const Sprite& from, const Sprite& to)
+{
+	m_unsavedEdits = true;
+	m_levelReader->moveSprite(index, to.x, to.y);
+	m_spriteIndex->move(index, from.x, from.y, to.x, to.y);
+	m_preview->invalidateSprite(from);
+	m_preview->invalidateSprite(to);
+	m_autosaver->recordSpriteMove(index, to.x, to.y);
+}
+
+void LevelEditorState::applySpriteRemoves(const std::vector<int>& indices)
+{
+	m_unsavedEdits = true;
+	const auto& sprites = m_levelReader->getSprites();
+	for (auto it = indices.rbegin(); it != indices.rend(); ++it)
+	{
+		m_preview->invalidateSprite(sprites[*it]);
+		m_autosaver->recordSpriteRemove(*it);
+	}
+
+	//one compaction of the sprites and one renumbering of the index for the whole batch
+	m_spriteIndex->remove(indices);
+	m_levelReader->deleteSprites(indices);
+}
+
+void LevelEditorState::applySpriteInserts(const std::vector<int>& indices, const std::vector<Sprite>& sprites)
+{
+	m_unsavedEdits = true;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		m_preview->invalidateSprite(sprites[i]);
+		m_autosaver->recordSpriteInsert(indices[i], sprites[i]);
+	}
+
+	//one merge into the sprites and one renumbering of the index for the whole batch
+	m_levelReader->insertSprites(indices, sprites);
+	m_spriteIndex->insert(indices, sprites);
+}
+
+void LevelEditorState::beginAutosave()
+{
+	//mapped levels share their file, owned ones are copied over the next frames
+	m_autosaver->begin(m_levelReader->getLevel(), m_levelReader->getSprites(), m_levelReader->getLevelPath());
+}
+
+void LevelEditorState::recoverAutosave()
+{
+	m_canRecover = false;
+	m_gui->get(m_recoverButtonId).text.setString(g_editorTxtAutosaveOn);
+
+	TileMap level;
+	std::vector<Sprite> sprites;
+	std::string levelPath;
+	if (!Autosaver::recover(g_autosaveFile, level, sprites, levelPath))
+	{
+		return;
+	}
+
+	resetPlayer();
+	m_levelReader->setLevel(std::move(level), std::move(sprites), levelPath);
+	onLevelLoaded();
+	m_unsavedEdits = true;
+
+	//a custom level is saved under its name again
+	const std::string directory = g_customLevelDirectory;
+	const std::string extension = ".txt";
+	if (levelPath.size() > directory.size() + extension.size() && levelPath.compare(0, directory.size(), directory) == 0 &&
+		levelPath.compare(levelPath.size() - extension.size(), extension.size(), extension) == 0)
+	{
+		m_customLevelName = levelPath.substr(directory.size(), levelPath.size() - directory.size() - extension.size());
+		m_gui->get(m_filenameGuiIndex).text.setString(m_customLevelName);
+	}
+}
+
+void LevelEditorState::undo(const bool backwards)
+{
+	std::vector<EditJournal::TileEdit> tiles;
+	std::vector<EditJournal::SpriteEdit> sprites;
+	if (backwards ? !m_journal->undo(tiles, sprites) : !m_journal->redo(tiles, sprites))
+	{
+		return;
+	}
+
+	//indices of the selection may be gone
+	m_selectedSprites.clear();
+
+	//a tile may be edited more than once in a step, the first edit has to be undone last
+	std::vector<TileRun> runs;
+	runs.reserve(tiles.size());
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		const auto& tile = tiles[backwards ? tiles.size() - 1 - i : i];
+		runs.push_back({ tile.x, tile.y, tile.length, backwards ? tile.before : tile.after });
+	}
+	applyTiles(runs);
+
+	//sprite edits depend on each other's indices, they are reverted in reverse order
+	//runs of inserts with rising indices and removes with falling indices, like those of a
+	//deleted selection, are applied as one batch
+	auto removes = [backwards](const EditJournal::SpriteEdit& edit) { return (edit.action == EditJournal::SpriteAction::CREATE) == backwards; };
+	auto at = [&sprites, backwards](const size_t i) -> const EditJournal::SpriteEdit& { return sprites[backwards ? sprites.size() - 1 - i : i]; };
+
+	std::vector<int> batch;
+	std::vector<Sprite> batchSprites;
+	size_t i = 0;
+	while (i < sprites.size())
+	{
+		const auto& edit = at(i);
+		if (edit.action == EditJournal::SpriteAction::MOVE)
+		{
+			applySpriteMove(edit.index, backwards ? edit.after : edit.before, backwards ? edit.before : edit.after);
+			i++;
+			continue;
+		}
+
+		batch.clear();
+		batchSprites.clear();
+		const bool removing = removes(edit);
+		for (; i < sprites.size(); i++)
+		{
+			const auto& next = at(i);
+			if (next.action == EditJournal::SpriteAction::MOVE || removes(next) != removing ||
+				(!batch.empty() && (removing ? next.index >= batch.back() : next.index <= batch.back())))
+			{
+				break;
+			}
+			batch.push_back(next.index);
+			batchSprites.push_back(backwards ? next.before : next.after);
+		}
+
+		if (removing)
+		{
+			std::reverse(batch.begin(), batch.end());
+			applySpriteRemoves(batch);
+		}
+		else
+		{
+			applySpriteInserts(batch, batchSprites);
 		}
 	}
+
+	updateHistoryText();
+}
+
+void LevelEditorState::updateHistoryText()
+{
+	char memory[32];
+	std::snprintf(memory, sizeof(memory), "%.1f KB", m_journal->getMemoryUsage() / 1024.0);
+
+	m_historyStatus = std::string(g_editorTxtHistory) + ": " + std::to_string(m_journal->getUndoCount()) + " undo, " +
+		std::to_string(m_journal->getRedoCount()) + " redo, " + memory;
+	updateStatusBar();
+}
+
+void LevelEditorState::showLevelPage(const int page)
+{
+	const int pageCount = std::max((int(m_customLevels.size()) + g_editorLevelsPerPage - 1) / g_editorLevelsPerPage, 1);
+	m_levelPage = page % pageCount;
+
+	for (size_t i = 0; i < m_levelButtonIds.size(); i++)
+	{
+		const size_t index = m_levelPage * g_editorLevelsPerPage + i;
+		m_gui->get(m_levelButtonIds[i]).text.setString(index < m_customLevels.size() ? m_customLevels[index] : "");
+	}
+
+	//the visible page is rendered first
+	for (size_t i = m_levelButtonIds.size(); i-- > 0;)
+	{
+		const size_t index = m_levelPage * g_editorLevelsPerPage + i;
+		if (index < m_customLevels.size())
+		{
+			requestPreview(m_customLevels[index], true);
+		}
+	}
+
+	m_gui->get(m_pageButtonId).text.setString(std::string(g_editorTxtNextPage) + " " + std::to_string(m_levelPage + 1) + "/" + std::to_string(pageCount));
+}
+
+void LevelEditorState::requestPreview(const std::string& levelName, const bool priority) const
+{
+	auto entry = m_levelReader->getCatalog().find(levelName);
+	if (entry)
+	{
+		m_thumbnails->request(g_customLevelDirectory + levelName, entry->hash, priority);
+	}
 }
 
 void LevelEditorState::toggleMode()
 {
 	m_editEntities = !m_editEntities;
+	updateStatusBar();
+}
 
-	if (!m_editEntities)
+void LevelEditorState::setTool(const BrushTool tool)
+{
+	m_tool = tool;
+	if (m_tool != BrushTool::REGION)
 	{
-		m_statusBar.setString(g_editorTxtModeWall);
+		m_hasRegion = false;
 	}
-	else
+	m_gui->get(m_toolButtonId).text.setString(std::string(g_editorTxtTool) + ": " + g_editorTxtToolNames[int(m_tool)]);
+	updateBrushPreview();
+	updateStatusBar();
+}
+
+void LevelEditorState::updateStatusBar()
+{
+	std::string mode = g_editorTxtModeWall;
+	if (m_editEntities)
+	{
+		mode = g_editorTxtModeEntity;
+	}
+	else if (m_tool == BrushTool::REGION)
 	{
-		m_statusBar.setString(g_editorTxtModeEntity);
+		mode = g_editorTxtModeRegion;
 	}
+	m_statusBar.setString(mode + "\n" + m_historyStatus + (m_changedOnDisk ? std::string("\n") + g_editorTxtChangedOnDisk : std::string()));
+
+	//bottom left corner of the window, grows upwards
+	const auto bounds = m_statusBar.getLocalBounds();
+	m_statusBar.setOrigin(0.0f, bounds.top + bounds.height);
+	m_statusBar.setPosition(10.0f, float(m_windowHeight) - 10.0f);
 }
 
 void LevelEditorState::resetPlayer() const
 {
-	m_player->m_posX = 22.0;
-	m_player->m_posY = 11.5;
+	m_player->m_posX = g_playerStartX;
+	m_player->m_posY = g_playerStartY;
 	m_player->m_dirX = -1.0;
 	m_player->m_dirY = 0.0;
 	m_player->m_planeX = 0.0;
 	m_player->m_planeY = 0.66;
 }
 
+void LevelEditorState::turnPlayer(const double angle) const
+{
+	const double oldDirX = m_player->m_dirX;
+	m_player->m_dirX = m_player->m_dirX * std::cos(angle) - m_player->m_dirY * std::sin(angle);
+	m_player->m_dirY = oldDirX * std::sin(angle) + m_player->m_dirY * std::cos(angle);
+	const double oldPlaneX = m_player->m_planeX;
+	m_player->m_planeX = m_player->m_planeX * std::cos(angle) - m_player->m_planeY * std::sin(angle);
+	m_player->m_planeY = oldPlaneX * std::sin(angle) + m_player->m_planeY * std::cos(angle);
+}
+
 void LevelEditorState::drawPlayer(sf::RenderWindow & window) const
 {
 
-	const auto posX = float(m_player->m_posY) * m_scale;
-	const auto posY = float(m_player->m_posX) * m_scale;
+	const auto position = toScreen(sf::Vector2f(float(m_player->m_posY), float(m_player->m_posX)));
+	const auto posX = position.x;
+	const auto posY = position.y;
 
 	sf::CircleShape player(g_editorPlayerArrowScale, 3);
 	player.setPosition(posX, posY);
@@ -293,64 +1193,92 @@ void LevelEditorState::drawPlayer(sf::RenderWindow & window) const
 	window.draw(player2);
 }
 
-void LevelEditorState::drawWalls(sf::RenderWindow & window) const
+void LevelEditorState::drawSprites(sf::RenderWindow & window)
 {
-	const auto levelSize = m_levelReader->getLevel().size();
-	for (size_t y = 0; y < levelSize; y++)
+	for (auto& quads : m_spriteQuads)
 	{
-		for (size_t x = 0; x < levelSize; x++)
-		{
-			auto id = m_levelReader->getLevel()[y][x];
-			if (id > 0 && id < 9)
-			{
-				sf::RectangleShape wall(sf::Vector2f(m_scale - 2.0f, m_scale - 2.0f));
-				wall.setPosition(x * m_scale, y * m_scale);
-				wall.setTexture(m_levelReader->getTextureSfml(id - 1));
-				wall.setOutlineThickness(2);
-				if (!m_editEntities)
-				{
-					wall.setOutlineColor(sf::Color(0, 0, 0, 255));
-				}
-				else
-				{
-					wall.setFillColor(sf::Color(255, 255, 255, 100));
-					wall.setOutlineColor(sf::Color(0, 0, 0, 100));
-				}
-				window.draw(wall);
-			}
-		}
+		quads.clear();
 	}
-}
+	m_spriteOutlines.clear();
 
-void LevelEditorState::drawSprites(sf::RenderWindow & window) const
-{
-	const auto spritesSize = m_levelReader->getSprites().size();
-	for (size_t i = 0; i < spritesSize; i++)
+	const auto visible = getVisibleArea();
+	const sf::FloatRect textureRect(0.0f, 0.0f, float(g_textureWidth), float(g_textureHeight));
+	const float inset = g_editorTileOutline;
+
+	const auto& sprites = m_levelReader->getSprites();
+	for (size_t i = 0; i < sprites.size(); i++)
 	{
-		sf::RectangleShape object(sf::Vector2f(m_scale - 2.0f, m_scale - 2.0f));
-		object.setPosition(float(m_levelReader->getSprites()[i].y) * m_scale, float(m_levelReader->getSprites()[i].x) * m_scale);
-		object.setOrigin(m_scale / 2.0f, m_scale / 2.0f);
-		object.setOutlineThickness(2);
+		//sprites are centered on their position
+		const sf::FloatRect bounds(float(sprites[i].y) - 0.5f, float(sprites[i].x) - 0.5f, 1.0f, 1.0f);
+		if (!visible.intersects(bounds) || sprites[i].texture < 0 || sprites[i].texture >= g_textureCount)
+		{
+			continue;
+		}
 
 		if (m_editEntities)
 		{
-			if (i == m_entitySelected)
-			{
-				object.setOutlineColor(sf::Color(0, 255, 0, 255));
-			}
-			else
-			{
-				object.setOutlineColor(sf::Color(255, 255, 255, 128));
-			}
+			const bool selected = std::binary_search(m_selectedSprites.begin(), m_selectedSprites.end(), int(i));
+			const auto outline = selected ? sf::Color(0, 255, 0, 255) : sf::Color(255, 255, 255, 128);
+			EditorTileLayer::appendQuad(m_spriteOutlines, bounds, outline);
 		}
-		else
+
+		const sf::FloatRect inner(bounds.left + inset, bounds.top + inset, bounds.width - 2.0f * inset, bounds.height - 2.0f * inset);
+		EditorTileLayer::appendQuad(m_spriteQuads[sprites[i].texture], inner, sf::Color::White, textureRect);
+	}
+
+	window.draw(m_spriteOutlines);
+	for (int i = 0; i < g_textureCount; i++)
+	{
+		if (m_spriteQuads[i].getVertexCount() > 0)
 		{
-			object.setOutlineColor(sf::Color(255, 255, 255, 0));
+			window.draw(m_spriteQuads[i], m_levelReader->getTextureSfml(i));
 		}
+	}
+}
+
+void LevelEditorState::drawLevelPreview(sf::RenderWindow & window)
+{
+	//previews of the level button under the mouse, nothing until they are rendered
+	const int hovered = m_gui->getHovered();
+	auto slot = std::find(m_levelButtonIds.begin(), m_levelButtonIds.end(), hovered);
+	if (slot == m_levelButtonIds.end())
+	{
+		return;
+	}
 
-		object.setTexture(m_levelReader->getTextureSfml(m_levelReader->getSprites()[i].texture));
-		window.draw(object);
+	const size_t index = m_levelPage * g_editorLevelsPerPage + (slot - m_levelButtonIds.begin());
+	auto entry = index < m_customLevels.size() ? m_levelReader->getCatalog().find(m_customLevels[index]) : nullptr;
+	if (!entry)
+	{
+		return;
+	}
+
+	auto map = m_thumbnails->getMap(entry->hash);
+	auto view = m_thumbnails->getView(entry->hash);
+	if (!map || !view)
+	{
+		return;
 	}
+
+	const float padding = 5.0f;
+	const sf::Vector2f size(float(g_thumbnailMapSize + g_thumbnailViewWidth) + 3.0f * padding, float(std::max(g_thumbnailMapSize, g_thumbnailViewHeight)) + 2.0f * padding);
+	const auto& button = m_gui->get(hovered).background;
+	const sf::Vector2f position(button.getPosition().x - size.x - padding, std::min(button.getPosition().y, m_windowHeight - size.y));
+
+	sf::RectangleShape background(size);
+	background.setPosition(position);
+	background.setFillColor(sf::Color(0, 0, 0, 220));
+	background.setOutlineThickness(1);
+	background.setOutlineColor(sf::Color::White);
+	window.draw(background);
+
+	sf::Sprite mapSprite(*map);
+	mapSprite.setPosition(position.x + padding, position.y + padding);
+	window.draw(mapSprite);
+
+	sf::Sprite viewSprite(*view);
+	viewSprite.setPosition(position.x + 2.0f * padding + g_thumbnailMapSize, position.y + padding);
+	window.draw(viewSprite);
 }
 
 void LevelEditorState::handleInputField(const sf::Event& event)
@@ -387,24 +1315,29 @@ void LevelEditorState::handleMenuCallbacks(const sf::Event & event, Game & game)
 	{
 		toggleMode();
 	}
+	if (m_gui->getPressed(m_toolButtonId) && !m_painting)
+	{
+		setTool(BrushTool((int(m_tool) + 1) % int(BrushTool::COUNT)));
+	}
 	if (m_gui->getPressed(g_editorTxtLoadDefault))
 	{
-
-		resetPlayer();
-
-		m_levelReader->loadDefaultLevel();
+		m_levelReader->loadDefaultLevelAsync();
+		m_resetPlayerOnLoad = true;
 	}
-	for (auto& cl : m_customLevels)
+	for (size_t i = 0; i < m_levelButtonIds.size(); i++)
 	{
-		if (m_gui->getPressed(cl))
+		const size_t index = m_levelPage * g_editorLevelsPerPage + i;
+		if (m_gui->getPressed(m_levelButtonIds[i]) && index < m_customLevels.size())
 		{
-
-			resetPlayer();
-
-			m_levelReader->loadCustomLevel(cl);
+			m_levelReader->loadCustomLevelAsync(m_customLevels[index]);
+			m_resetPlayerOnLoad = true;
 		}
 	}
-	if (m_gui->getPressed(m_customLevelName))
+	if (m_gui->getPressed(m_pageButtonId))
+	{
+		showLevelPage(m_levelPage + 1);
+	}
+	if (m_gui->getPressed(m_filenameGuiIndex))
 	{
 		m_customLevelName = "";
 		m_gui->get(m_filenameGuiIndex).text.setString(m_customLevelName);
@@ -412,8 +1345,17 @@ void LevelEditorState::handleMenuCallbacks(const sf::Event & event, Game & game)
 	}
 	if (m_gui->getPressed(g_editorTxtSave) && m_customLevelName.size() > 0 && m_customLevelName != "<enter filename>")
 	{
-		m_levelReader->saveCustomLevel(m_customLevelName + ".txt");
-		game.changeState(GameStateName::LEVEL_EDITOR);
+		//the editor keeps its view and history, the level list follows once the file is written
+		m_levelReader->saveCustomLevelAsync(m_customLevelName + ".txt");
+		m_unsavedEdits = false;
+		m_changedOnDisk = false;
+		m_canRecover = false;
+		m_gui->get(m_recoverButtonId).text.setString(g_editorTxtAutosaveOn);
+		updateStatusBar();
+	}
+	if (m_gui->getPressed(m_recoverButtonId) && m_canRecover && !m_levelReader->isLoading())
+	{
+		recoverAutosave();
 	}
 	if (m_gui->getPressed(g_editorTxtQuit))
 	{
@@ -8,16 +8,42 @@ struct Player;
 class Game;
 class LevelReaderWriter;
 class LevelEditorGui;
+class ProgressBar;
+class ThumbnailGenerator;
+class EditorTileLayer;
+class SpriteIndex;
+class EditJournal;
+class EditorPreview;
+class Autosaver;
+struct Sprite;
+struct TileRun;
+struct TileRegion;
+
+// wall tools, the order of the names in g_editorTxtToolNames
+enum class BrushTool
+{
+	PEN,
+	LINE,
+	RECTANGLE,
+	FILLED_RECTANGLE,
+	FILL,
+	REGION,
+	COUNT
+};
 
 class LevelEditorState : public GameState
 {
 public:
 	LevelEditorState(const int w, const int h, std::shared_ptr<Player> player, std::shared_ptr<LevelReaderWriter> levelReader);
-	virtual ~LevelEditorState() = default;
+	virtual ~LevelEditorState();
 
 	void update(const float ft) override;
 	void draw(sf::RenderWindow& window) override;
 	void handleInput(const sf::Event& event, const sf::Vector2f& mousePosition, Game& game) override;
+	void onLevelLoaded() override;
+	void onCustomLevelsChanged() override;
+	bool hasUnsavedEdits() const override;
+	void onLevelChangedOnDisk() override;
 
 private:
 
@@ -25,8 +51,13 @@ private:
 	const int m_windowHeight;
 	std::shared_ptr<Player> m_player;
 	std::shared_ptr<LevelReaderWriter> m_levelReader;
+	std::shared_ptr<const sf::Font> m_font;
 
+	//pixels per tile and the level position at the top left corner of the map, in tiles
 	float m_scale;
+	sf::Vector2f m_viewOffset;
+	bool m_panning = false;
+	sf::Vector2f m_panOrigin;
 
 	bool m_filenameMode = false;
 	int m_filenameGuiIndex;
@@ -34,22 +65,116 @@ private:
 	int m_textureButtonId;
 	int m_selectedSprite = 11;
 	int m_spriteButtonId;
+	BrushTool m_tool = BrushTool::PEN;
+	int m_toolButtonId;
 	bool m_editEntities = false;
-	int m_entitySelected = -1;
+	//sorted sprite indices
+	std::vector<int> m_selectedSprites;
+	bool m_boxSelecting = false;
+	sf::Vector2f m_boxStart;
 
 	sf::Text m_statusBar;
+	//second line of the status bar
+	std::string m_historyStatus;
 	sf::Vector2f m_mousePos;
 	std::string m_customLevelName = "<enter filename>";
 	std::vector<std::string> m_customLevels;
+	std::vector<int> m_levelButtonIds;
+	int m_pageButtonId;
+	int m_levelPage = 0;
 
 	std::unique_ptr<LevelEditorGui> m_gui;
+	std::unique_ptr<ProgressBar> m_loadingBar;
+	std::unique_ptr<ThumbnailGenerator> m_thumbnails;
+	std::unique_ptr<EditorTileLayer> m_tiles;
+	std::unique_ptr<SpriteIndex> m_spriteIndex;
+	std::unique_ptr<EditJournal> m_journal;
+	std::unique_ptr<EditorPreview> m_preview;
+	bool m_showPreview = true;
+	sf::Text m_previewText;
+
+	//edits are handed to the autosave thread every few seconds
+	std::shared_ptr<Autosaver> m_autosaver;
+	float m_autosaveTime = 0.0f;
+	//a log of an earlier session can be recovered until the first edit replaces it
+	bool m_canRecover = false;
+	//edits since the level was loaded or saved, an outside change of its file waits for F5
+	bool m_unsavedEdits = false;
+	bool m_changedOnDisk = false;
+	int m_recoverButtonId;
+
+	//mouse button of the wall tool drag in progress, its first and current tile as line and column
+	bool m_painting = false;
+	//the start pose is applied once the level being loaded is swapped in
+	bool m_resetPlayerOnLoad = false;
+	sf::Mouse::Button m_paintButton = sf::Mouse::Left;
+	sf::Vector2i m_dragStart;
+	sf::Vector2i m_dragEnd;
+
+	//shape being dragged or the selected region, in tile units
+	sf::VertexArray m_brushPreview{ sf::Quads };
+	bool m_hasRegion = false;
+	std::unique_ptr<TileRegion> m_clipboard;
+
+	//sprites are batched by texture, rebuilt each frame from the visible ones
+	std::vector<sf::VertexArray> m_spriteQuads;
+	sf::VertexArray m_spriteOutlines{ sf::Quads };
 
 	void toggleMode();
+	void setTool(const BrushTool tool);
+	void updateStatusBar();
+	void fitView();
+	void zoom(const float factor, const sf::Vector2f& pixel);
+	sf::Vector2f toMap(const sf::Vector2f& pixel) const;
+	sf::Vector2f toScreen(const sf::Vector2f& position) const;
+	// level area shown in the map, in tiles
+	sf::FloatRect getVisibleArea() const;
+	sf::View getMapView() const;
+	// level line and column under the map position, clamped to the level
+	sf::Vector2i toTile(const sf::Vector2f& position) const;
+	// edits recorded in the journal
+	void paintTile(const int x, const int y, const sf::Mouse::Button button);
+	void setTile(const int x, const int y, const int value);
+	void createSprite(const double x, const double y, const int texture);
+	void moveSelection(const double dx, const double dy);
+	void deleteSelection();
+
+	// wall tools, the tiles of a shape are applied and recorded as one batch
+	int getBrushValue(const sf::Mouse::Button button) const;
+	void beginDrag(const sf::Vector2i& tile, const sf::Mouse::Button button);
+	void continueDrag(const sf::Vector2i& tile, const bool inLevel);
+	void endDrag();
+	void getShape(std::vector<TileRun>& runs) const;
+	void applyBrush(const std::vector<TileRun>& runs);
+	void updateBrushPreview();
+	void copyRegion();
+	void pasteRegion(const sf::Vector2i& tile);
+	void rotateClipboard();
+
+	// edits applied without recording, used by undo and redo
+	void applyTile(const int x, const int y, const int value);
+	void applyTiles(const std::vector<TileRun>& runs);
+	void applySpriteInsert(const int index, const Sprite& sprite);
+	void applySpriteMove(const int index, const Sprite& from, const Sprite& to);
+	// sorted indices, removed together instead of one by one
+	void applySpriteRemoves(const std::vector<int>& indices);
+	// sorted final indices, inserted together instead of one by one
+	void applySpriteInserts(const std::vector<int>& indices, const std::vector<Sprite>& sprites);
+
+	void beginAutosave();
+	void recoverAutosave();
+
+	// reverts the last step, or applies the last reverted step again
+	void undo(const bool backwards);
+	void updateHistoryText();
+	void showLevelPage(const int page);
+	void requestPreview(const std::string& levelName, const bool priority) const;
 	void resetPlayer() const;
+	void turnPlayer(const double angle) const;
 
 	void drawPlayer(sf::RenderWindow& window) const;
-	void drawWalls(sf::RenderWindow& window) const;
-	void drawSprites(sf::RenderWindow& window) const;
+	void drawSprites(sf::RenderWindow& window);
+	void drawLevelPreview(sf::RenderWindow& window);
 
 	void handleInputField(const sf::Event& event);
 	void handleMenuCallbacks(const sf::Event& event, Game & game);
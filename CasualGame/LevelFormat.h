@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary level file layout:
+// [BinaryLevelHeader][sizeX * sizeY int32 tiles, line by line][spriteCount BinarySprite]
+// The tile array is used in place from the memory mapped file,
+// the checksum covers everything after the header.
+//
+// Chunked levels store the tiles as chunkSize * chunkSize blocks instead,
+// ordered by chunk line then chunk column, each block line by line and padded with 0 at the level edges.
+// Their chunks are paged in on demand by TileChunkStore.
+
+static const char g_binaryLevelMagic[4] = { 'C', 'G', 'L', 'V' };
+static const std::uint32_t g_binaryLevelVersion = 1;
+static const std::uint32_t g_chunkedLevelVersion = 2;
+//larger chunks are rejected as corrupt
+static const std::uint32_t g_maxLevelChunkSize = 1 << 16;
+
+struct BinaryLevelHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t sizeX;
+	std::uint32_t sizeY;
+	std::uint64_t spriteCount;
+	std::uint64_t tileOffset;
+	std::uint64_t spriteOffset;
+	std::uint32_t checksum;
+	std::uint32_t chunkSize; //0 for line by line tiles
+};
+
+struct BinarySprite
+{
+	double x;
+	double y;
+	std::int32_t texture;
+	std::int32_t reserved;
+};
+
+static_assert(sizeof(BinaryLevelHeader) == 48, "binary level header layout changed");
+static_assert(sizeof(BinarySprite) == 24, "binary level sprite layout changed");
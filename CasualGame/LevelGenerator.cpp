@@ -0,0 +1,240 @@
+#include "LevelGenerator.h"
+
+#include "LevelReaderWriter.h"
+#include "RandomGenerator.h"
+#include "Sprite.h"
+#include "Config.h"
+
+#include <algorithm>
+
+LevelGenerator::LevelGenerator(const Settings& settings) :
+	m_settings(settings)
+{
+	m_settings.width = std::min(std::max(m_settings.width, 3), g_generatorMaxSize);
+	m_settings.height = std::min(std::max(m_settings.height, 3), g_generatorMaxSize);
+	m_settings.spriteCount = std::min(std::max(m_settings.spriteCount, -1), g_generatorMaxSprites);
+	m_settings.wallDensity = std::min(std::max(m_settings.wallDensity, 0.0f), 1.0f);
+}
+
+void LevelGenerator::generate()
+{
+	RandomGenerator random(m_settings.seed);
+
+	m_sprites.clear();
+	m_level = TileMap(m_settings.height, m_settings.width);
+
+	//outer walls, the raycaster needs a closed level
+	for (int x = 0; x < m_settings.height; x++)
+	{
+		for (int y = 0; y < m_settings.width; y++)
+		{
+			if (x == 0 || y == 0 || x == m_settings.height - 1 || y == m_settings.width - 1)
+			{
+				m_level.set(x, y, random.randomInt(1, 8));
+			}
+		}
+	}
+
+	const bool defaultSprites = m_settings.spriteCount < 0;
+	const int spriteCount = defaultSprites ? 0 : m_settings.spriteCount;
+
+	switch (m_settings.type)
+	{
+	case LevelType::MAZE:
+		generateMaze(random);
+		placeSprites(random, spriteCount, -1);
+		break;
+	case LevelType::ARENA:
+		generateArena(random);
+		placeSprites(random, spriteCount, -1);
+		break;
+	case LevelType::PILLAR_FOREST:
+		generatePillarForest(random);
+		placeSprites(random, spriteCount, 11);
+		break;
+	case LevelType::SPRITE_FLOOD:
+		//open floor, every free tile is available for sprites
+		placeSprites(random, defaultSprites ? g_generatorMaxSprites : spriteCount, -1);
+		break;
+	default:
+		break;
+	}
+}
+
+void LevelGenerator::save(const std::string& path) const
+{
+	LevelReaderWriter::writeLevelFile(path, m_level, m_sprites);
+}
+
+bool LevelGenerator::parseType(const std::string& name, LevelType& type)
+{
+	if (name == "maze") type = LevelType::MAZE;
+	else if (name == "arena") type = LevelType::ARENA;
+	else if (name == "pillars") type = LevelType::PILLAR_FOREST;
+	else if (name == "sprites") type = LevelType::SPRITE_FLOOD;
+	else return false;
+	return true;
+}
+
+// iterative depth first maze on the odd tiles, the even tiles are walls between them
+void LevelGenerator::generateMaze(RandomGenerator& random)
+{
+	const int height = m_settings.height;
+	const int width = m_settings.width;
+
+	for (int x = 1; x < height - 1; x++)
+	{
+		for (int y = 1; y < width - 1; y++)
+		{
+			m_level.set(x, y, random.randomInt(1, 8));
+		}
+	}
+
+	const int cellsX = (height - 1) / 2;
+	const int cellsY = (width - 1) / 2;
+	if (cellsX == 0 || cellsY == 0)
+	{
+		return;
+	}
+
+	std::vector<char> visited(cellsX * cellsY, 0);
+	std::vector<int> stack;
+	stack.reserve(cellsX * cellsY);
+
+	stack.push_back(0);
+	visited[0] = 1;
+	m_level.set(1, 1, 0);
+
+	const int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+
+	while (!stack.empty())
+	{
+		const int cell = stack.back();
+		const int cx = cell / cellsY;
+		const int cy = cell % cellsY;
+
+		int candidates[4];
+		int candidateCount = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			const int nx = cx + offsets[i][0];
+			const int ny = cy + offsets[i][1];
+			if (nx >= 0 && ny >= 0 && nx < cellsX && ny < cellsY && !visited[nx * cellsY + ny])
+			{
+				candidates[candidateCount++] = i;
+			}
+		}
+
+		if (candidateCount == 0)
+		{
+			stack.pop_back();
+			continue;
+		}
+
+		const int direction = candidates[random.randomInt(0, candidateCount - 1)];
+		const int nx = cx + offsets[direction][0];
+		const int ny = cy + offsets[direction][1];
+
+		//carve the wall between the cells and the new cell
+		m_level.set(cx * 2 + 1 + offsets[direction][0], cy * 2 + 1 + offsets[direction][1], 0);
+		m_level.set(nx * 2 + 1, ny * 2 + 1, 0);
+
+		visited[nx * cellsY + ny] = 1;
+		stack.push_back(nx * cellsY + ny);
+	}
+
+	//knock out dividing walls to add loops
+	if (m_settings.wallDensity < 1.0f)
+	{
+		const float removeChance = 1.0f - m_settings.wallDensity;
+		for (int x = 1; x < cellsX * 2; x++)
+		{
+			for (int y = 1; y < cellsY * 2; y++)
+			{
+				//dividing walls have exactly one odd coordinate
+				if ((x % 2) != (y % 2) && m_level.get(x, y) > 0 && random.randomChance(removeChance))
+				{
+					m_level.set(x, y, 0);
+				}
+			}
+		}
+	}
+
+	clearPlayerStart();
+}
+
+void LevelGenerator::generateArena(RandomGenerator& random)
+{
+	for (int x = 1; x < m_settings.height - 1; x++)
+	{
+		for (int y = 1; y < m_settings.width - 1; y++)
+		{
+			if (random.randomChance(m_settings.wallDensity))
+			{
+				m_level.set(x, y, random.randomInt(1, 8));
+			}
+		}
+	}
+
+	clearPlayerStart();
+}
+
+void LevelGenerator::generatePillarForest(RandomGenerator& random)
+{
+	//pillars on a regular grid, the density decides how many grid points are used
+	for (int x = 2; x < m_settings.height - 2; x += 3)
+	{
+		for (int y = 2; y < m_settings.width - 2; y += 3)
+		{
+			if (random.randomChance(m_settings.wallDensity))
+			{
+				m_level.set(x, y, random.randomInt(1, 8));
+			}
+		}
+	}
+
+	clearPlayerStart();
+}
+
+// texture -1 picks a random sprite texture
+void LevelGenerator::placeSprites(RandomGenerator& random, const int count, const int texture)
+{
+	m_sprites.reserve(count);
+
+	//give up on levels without enough room
+	const long long maxAttempts = static_cast<long long>(count) * 8;
+	for (long long attempt = 0; attempt < maxAttempts && static_cast<int>(m_sprites.size()) < count; attempt++)
+	{
+		const int x = random.randomInt(1, m_settings.height - 2);
+		const int y = random.randomInt(1, m_settings.width - 2);
+		if (m_level.get(x, y) != 0)
+		{
+			continue;
+		}
+
+		Sprite sprite;
+		sprite.x = x + random.randomFloat(0.25f, 0.75f);
+		sprite.y = y + random.randomFloat(0.25f, 0.75f);
+		sprite.texture = texture >= 0 ? texture : random.randomInt(10, 12);
+		m_sprites.push_back(sprite);
+	}
+}
+
+// the game always starts the player at the same position, levels too small to contain it
+// get the inner tile closest to it cleared instead
+void LevelGenerator::clearPlayerStart()
+{
+	const int startX = std::min(std::max(static_cast<int>(g_playerStartX), 1), m_settings.height - 2);
+	const int startY = std::min(std::max(static_cast<int>(g_playerStartY), 1), m_settings.width - 2);
+
+	for (int x = startX - 1; x <= startX + 1; x++)
+	{
+		for (int y = startY - 1; y <= startY + 1; y++)
+		{
+			if (x > 0 && y > 0 && x < m_settings.height - 1 && y < m_settings.width - 1)
+			{
+				m_level.set(x, y, 0);
+			}
+		}
+	}
+}
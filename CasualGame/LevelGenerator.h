@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "TileMap.h"
+
+struct Sprite;
+class RandomGenerator;
+
+enum class LevelType
+{
+	MAZE,
+	ARENA,
+	PILLAR_FOREST,
+	SPRITE_FLOOD
+};
+
+// Generates large levels for stress tests and benchmarks.
+// The output only depends on the settings, the same seed always produces the same level.
+class LevelGenerator
+{
+public:
+
+	struct Settings
+	{
+		LevelType type = LevelType::ARENA;
+		int width = 64;
+		int height = 64;
+		// fraction of possible inner walls that are placed, for mazes the fraction of dividing walls kept
+		float wallDensity = 0.1f;
+		// negative leaves the count to the type, only sprite floods get sprites then
+		int spriteCount = -1;
+		unsigned int seed = 0;
+	};
+
+	explicit LevelGenerator(const Settings& settings);
+	virtual ~LevelGenerator() = default;
+
+	void generate();
+	void save(const std::string& path) const;
+
+	const TileMap& getLevel() const { return m_level; }
+	const std::vector<Sprite>& getSprites() const { return m_sprites; }
+
+	static bool parseType(const std::string& name, LevelType& type);
+
+private:
+
+	Settings m_settings;
+
+	TileMap m_level;
+	std::vector<Sprite> m_sprites;
+
+	void generateMaze(RandomGenerator& random);
+	void generateArena(RandomGenerator& random);
+	void generatePillarForest(RandomGenerator& random);
+	void placeSprites(RandomGenerator& random, const int count, const int texture);
+	void clearPlayerStart();
+};
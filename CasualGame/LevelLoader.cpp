@@ -0,0 +1,31 @@
+#include "LevelLoader.h"
+
+#include "LevelReaderWriter.h"
+#include "Sprite.h"
+
+LevelLoader::LevelLoader(const std::string& path) :
+	m_path(path)
+{
+	m_thread = std::thread(&LevelLoader::run, this);
+}
+
+LevelLoader::~LevelLoader()
+{
+	m_cancelled = true;
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void LevelLoader::run()
+{
+	m_succeeded = LevelReaderWriter::readLevelFile(m_path, m_level, m_sprites, [this](const float progress)
+	{
+		m_progress.store(progress, std::memory_order_relaxed);
+		return !m_cancelled.load(std::memory_order_relaxed);
+	});
+
+	m_progress.store(1.0f, std::memory_order_relaxed);
+	m_finished.store(true, std::memory_order_release);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TileMap.h"
+
+struct Sprite;
+
+// Reads a level file on a worker thread into a staging level.
+// The result is only touched by the owner once isFinished() returns true,
+// destroying an unfinished loader cancels it.
+class LevelLoader
+{
+public:
+	explicit LevelLoader(const std::string& path);
+	virtual ~LevelLoader();
+
+	LevelLoader(const LevelLoader&) = delete;
+	LevelLoader& operator=(const LevelLoader&) = delete;
+
+	const std::string& getPath() const { return m_path; }
+	float getProgress() const { return m_progress.load(std::memory_order_relaxed); }
+	bool isFinished() const { return m_finished.load(std::memory_order_acquire); }
+
+	// valid once finished
+	bool hasSucceeded() const { return m_succeeded; }
+	TileMap& getLevel() { return m_level; }
+	std::vector<Sprite>& getSprites() { return m_sprites; }
+
+private:
+
+	std::string m_path;
+
+	TileMap m_level;
+	std::vector<Sprite> m_sprites;
+	bool m_succeeded = false;
+
+	std::atomic<float> m_progress{ 0.0f };
+	std::atomic<bool> m_finished{ false };
+	std::atomic<bool> m_cancelled{ false };
+
+	std::thread m_thread;
+
+	void run();
+};
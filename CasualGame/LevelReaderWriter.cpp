@@ -2,56 +2,144 @@
 
 #include <fstream>
 #include <vector>
-#include <sstream>
-#include <filesystem>
 
+#include "Autosaver.h"
 #include "Config.h"
+#include "LevelCatalog.h"
+#include "LevelLoader.h"
 #include "Sprite.h"
+#include "LevelFormat.h"
+#include "MappedFile.h"
+#include "ResourcePack.h"
+#include "TextLevelParser.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <thread>
+
+namespace
+{
+	//checksums of the files writeLevelFile() wrote, on any thread
+	struct WrittenFiles
+	{
+		std::mutex mutex;
+		std::map<std::string, sf::Uint32> checksums;
+	};
+
+	WrittenFiles& getWrittenFiles()
+	{
+		static WrittenFiles files;
+		return files;
+	}
+
+	bool fileChecksum(const std::string& path, sf::Uint32& checksum)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+
+		checksum = Utils::checksum(nullptr, 0);
+		std::vector<char> block(1 << 16);
+		while (file.read(block.data(), block.size()) || file.gcount() > 0)
+		{
+			checksum = Utils::checksum(block.data(), size_t(file.gcount()), checksum);
+		}
+		return true;
+	}
 
-namespace fs = std::tr2::sys;
+	// whether count elements of elementBytes starting at offset end inside the file, divides so a corrupt header cannot wrap
+	bool fitsInFile(const std::uint64_t offset, const std::uint64_t count, const std::uint64_t elementBytes, const std::uint64_t size)
+	{
+		return offset <= size && count <= (size - offset) / elementBytes;
+	}
+
+	// the tile map indexes with int
+	bool validLevelSize(const BinaryLevelHeader& header)
+	{
+		return header.sizeX <= INT_MAX && header.sizeY <= INT_MAX;
+	}
+}
 
 LevelReaderWriter::LevelReaderWriter()
 {
+	const auto start = std::chrono::steady_clock::now();
+
+	readLevelFile(g_defaultLevelFile, m_level, m_sprites);
+	m_levelPath = g_defaultLevelFile;
 
-	loadLevel(g_defaultLevelFile, m_level, m_sprites);
+	//only levels changed since the last run are read
+	m_catalog = std::make_unique<LevelCatalog>(g_customLevelDirectory, g_levelCatalogFile);
+	m_catalog->load();
+	m_catalog->refresh();
+	if (m_catalog->isModified())
+	{
+		m_catalog->save();
+	}
 
 	//texture generator 
 	//generateTextures();
 
-	//load textures
+	//textures are loaded on first use, only the ones of the level are needed now
 	m_texture.resize(g_textureCount);
 	m_sfmlTextures.resize(g_textureCount);
+	updateResidentTextures();
 
-	// load all textures
-	for (auto i = 0; i < g_textureCount; i++)
-	{
-		loadTexture(i, g_textureFiles[i]);
+	const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Level reader ready in " << elapsed << " ms" << std::endl;
+}
 
-		sf::Image image;
-		image.loadFromFile(g_textureFiles[i]);
-		image.createMaskFromColor(sf::Color::Black);
 
-		m_sfmlTextures[i].loadFromImage(image);
-	}
+LevelReaderWriter::~LevelReaderWriter() = default;
 
-	//swap texture X/Y
-	//only works with square textures
-	for (size_t i = 0; i < g_textureCount; i++)
-		for (size_t x = 0; x < g_textureWidth; x++)
-			for (size_t y = 0; y < x; y++)
-				std::swap(m_texture[i][g_textureWidth * y + x], m_texture[i][g_textureWidth * x + y]);
+void LevelReaderWriter::changeLevelTile(const int x, const int y, const int value)
+{
+	requireTexture(value - 1);
+	m_level.set(x, y, value);
+	m_revision++;
 }
 
+void LevelReaderWriter::changeLevelTiles(const std::vector<TileRun>& runs)
+{
+	for (auto& run : runs)
+	{
+		requireTexture(run.value - 1);
+		m_level.fill(run);
+	}
+	m_revision++;
+}
 
-void LevelReaderWriter::changeLevelTile(const int x, const int y, const int value)
+void LevelReaderWriter::setLevel(TileMap level, std::vector<Sprite> sprites, const std::string& path)
 {
-	m_level[x][y] = value;
+	m_level = std::move(level);
+	m_sprites = std::move(sprites);
+	if (!path.empty())
+	{
+		m_levelPath = path;
+	}
+	m_revision++;
+	updateResidentTextures();
+}
+
+const sf::Texture* LevelReaderWriter::getTextureSfml(const int i)
+{
+	requireTexture(i);
+	return &m_sfmlTextures[i];
 }
 
 void LevelReaderWriter::moveSprite(const int index, const double x, const double y)
 {
 	m_sprites[index].x = x;
 	m_sprites[index].y = y;
+	m_revision++;
 }
 
 void LevelReaderWriter::createSprite(double x, double y, int texture)
@@ -60,145 +148,642 @@ void LevelReaderWriter::createSprite(double x, double y, int texture)
 	spr.x = x;
 	spr.y = y;
 	spr.texture = texture;
+	requireTexture(texture);
 	m_sprites.push_back(spr);
+	m_revision++;
+}
+
+void LevelReaderWriter::insertSprite(const int index, const Sprite& sprite)
+{
+	requireTexture(sprite.texture);
+	m_sprites.insert(m_sprites.begin() + index, sprite);
+	m_revision++;
+}
+
+void LevelReaderWriter::insertSprites(const std::vector<int>& indices, const std::vector<Sprite>& sprites)
+{
+	//filled from the back so every sprite is moved once
+	const size_t oldSize = m_sprites.size();
+	m_sprites.resize(oldSize + sprites.size());
+
+	size_t source = oldSize;
+	size_t inserted = sprites.size();
+	for (size_t target = m_sprites.size(); target-- > 0;)
+	{
+		if (inserted > 0 && size_t(indices[inserted - 1]) == target)
+		{
+			inserted--;
+			requireTexture(sprites[inserted].texture);
+			m_sprites[target] = sprites[inserted];
+		}
+		else
+		{
+			m_sprites[target] = m_sprites[--source];
+		}
+	}
+	m_revision++;
 }
 
 void LevelReaderWriter::deleteSprite(const int index)
 {
 	m_sprites.erase(m_sprites.begin() + index);
+	m_revision++;
+}
+
+void LevelReaderWriter::deleteSprites(const std::vector<int>& indices)
+{
+	size_t next = 0;
+	size_t kept = 0;
+	for (size_t i = 0; i < m_sprites.size(); i++)
+	{
+		if (next < indices.size() && size_t(indices[next]) == i)
+		{
+			next++;
+			continue;
+		}
+		m_sprites[kept++] = m_sprites[i];
+	}
+	m_sprites.resize(kept);
+	m_revision++;
 }
 
 void LevelReaderWriter::loadDefaultLevel()
 {
+	loadLevelFile(g_defaultLevelFile);
+}
+
+void LevelReaderWriter::loadCustomLevel(const std::string& levelName)
+{
+	loadLevelFile(g_customLevelDirectory + levelName);
+}
+
+void LevelReaderWriter::loadLevelFile(const std::string& path)
+{
+	//a synchronous load replaces any pending one
+	m_loader.reset();
+
 	m_level.clear();
 	m_sprites.clear();
 
-	std::vector<std::vector<int> >().swap(m_level);
 	std::vector<Sprite>().swap(m_sprites);
 
-	loadLevel(g_defaultLevelFile, m_level, m_sprites);
+	readLevelFile(path, m_level, m_sprites);
+	m_levelPath = path;
+	m_revision++;
+	updateResidentTextures();
 }
 
-void LevelReaderWriter::loadCustomLevel(const std::string& levelName)
+void LevelReaderWriter::loadDefaultLevelAsync()
 {
-	m_level.clear();
-	m_sprites.clear();
+	loadLevelFileAsync(g_defaultLevelFile);
+}
 
-	std::vector<std::vector<int> >().swap(m_level);
-	std::vector<Sprite>().swap(m_sprites);
+void LevelReaderWriter::loadCustomLevelAsync(const std::string& levelName)
+{
+	loadLevelFileAsync(g_customLevelDirectory + levelName);
+}
 
-	loadLevel(g_customLevelDirectory + levelName, m_level, m_sprites);
+void LevelReaderWriter::loadLevelFileAsync(const std::string& path)
+{
+	//cancels a pending load first
+	m_loader.reset();
+	m_loader = std::make_unique<LevelLoader>(path);
+}
+
+float LevelReaderWriter::getLoadProgress() const
+{
+	return m_loader ? m_loader->getProgress() : 1.0f;
+}
+
+bool LevelReaderWriter::publishLoadedLevel()
+{
+	if (!m_loader || !m_loader->isFinished())
+	{
+		return false;
+	}
+
+	const bool succeeded = m_loader->hasSucceeded();
+	if (succeeded)
+	{
+		m_level = std::move(m_loader->getLevel());
+		m_sprites = std::move(m_loader->getSprites());
+		m_levelPath = m_loader->getPath();
+		m_revision++;
+		updateResidentTextures();
+	}
+	m_loader.reset();
+
+	return succeeded;
 }
 
 void LevelReaderWriter::saveCustomLevel(const std::string & levelName)
 {
+	saveLevelFile(g_customLevelDirectory + levelName);
 
-	//warning! overwrites the file if exists
-	std::fstream file(g_customLevelDirectory + levelName, std::ios::out);
+	m_catalog->update(levelName);
+	m_catalog->save();
+}
 
-	//write walls
-	for (size_t i = 0; i < m_level.size(); ++i)
+void LevelReaderWriter::saveCustomLevelAsync(const std::string& levelName)
+{
+	const std::string path = g_customLevelDirectory + levelName;
+	auto onSaved = [this, levelName](const bool saved)
 	{
-		for (size_t j = 0; j < m_level[i].size(); ++j)
+		LevelCatalogEntry entry;
+		if (!saved || !LevelCatalog::readEntry(g_customLevelDirectory, levelName, entry))
 		{
-			file << m_level[i][j] << ",";
+			return;
 		}
-		file << "\n";
+
+		std::lock_guard<std::mutex> lock(m_savedMutex);
+		m_savedLevels.push_back(std::move(entry));
+	};
+
+	auto autosaver = getAutosaver();
+	if (!autosaver->save(path, onSaved))
+	{
+		//paged levels are not held by the autosaver, the worker streams a store of its own
+		TileMap level = m_level;
+		if (m_level.isPaged())
+		{
+			if (m_level.getChunkStore()->getPath() == path)
+			{
+				std::cout << "Cannot overwrite the paged level file in use: " << path << std::endl;
+				return;
+			}
+
+			auto store = m_level.getChunkStore()->snapshot();
+			if (!store)
+			{
+				std::cout << "Could not open the paged level file again: " << m_level.getChunkStore()->getPath() << std::endl;
+				return;
+			}
+			level.page(std::move(store));
+		}
+		autosaver->save(path, std::move(level), m_sprites, onSaved);
 	}
-	file << "\n";
 
-	//write sprites
-	for (auto& spr : m_sprites)
+	//the level stays in use, now as the saved file
+	m_levelPath = path;
+}
+
+bool LevelReaderWriter::publishSavedLevels()
+{
+	std::vector<LevelCatalogEntry> saved;
 	{
-		file << spr.x << "," << spr.y << "," << spr.texture << "," << "\n";
+		std::lock_guard<std::mutex> lock(m_savedMutex);
+		saved.swap(m_savedLevels);
 	}
-	file << "\n";
-	file.close();
+	if (saved.empty())
+	{
+		return false;
+	}
+
+	for (auto& entry : saved)
+	{
+		m_catalog->set(entry.name, &entry);
+	}
+	m_catalog->save();
+	return true;
 }
 
-std::vector<std::string> LevelReaderWriter::getCustomLevels() const
+std::shared_ptr<Autosaver> LevelReaderWriter::getAutosaver()
 {
+	if (!m_autosaver)
+	{
+		m_autosaver = std::make_shared<Autosaver>(g_autosaveFile);
+	}
+	return m_autosaver;
+}
 
-	auto dpath = fs::path(g_customLevelDirectory);
+void LevelReaderWriter::saveLevelFile(const std::string& path)
+{
+	//a paged level keeps reading its file
+	if (m_level.isPaged() && m_level.getChunkStore()->getPath() == path)
+	{
+		std::cout << "Cannot overwrite the paged level file in use: " << path << std::endl;
+		return;
+	}
+
+	//a mapped level file cannot be overwritten while it is in use
+	if (!m_level.isPaged())
+	{
+		m_level.detach();
+	}
+
+	writeLevelFile(path, m_level, m_sprites);
+}
+
+std::vector<std::string> LevelReaderWriter::getCustomLevels() const
+{
 	std::vector<std::string> entries;
+	entries.reserve(m_catalog->getEntries().size());
+	for (auto& entry : m_catalog->getEntries())
+	{
+		entries.push_back(entry.name);
+	}
+	return entries;
+}
+
+bool LevelReaderWriter::readLevelFile(const std::string& path, TileMap& level, std::vector<Sprite>& sprites, const LevelLoadProgress& progress)
+{
+	//binary levels are mapped or paged, there is nothing to report in between
+	if (isBinaryLevelFile(path))
+	{
+		return readBinaryLevel(path, level, sprites);
+	}
+	return readTextLevel(path, level, sprites, progress);
+}
+
+bool LevelReaderWriter::writeLevelFile(const std::string& path, const TileMap& level, const std::vector<Sprite>& sprites)
+{
+	//written next to the target and renamed over it, a crash or a full disk never leaves half a level
+	const auto temporaryPath = Utils::temporaryPath(path);
+	const bool written = isBinaryLevelFile(path) ? writeBinaryLevel(temporaryPath, level, sprites) : writeTextLevel(temporaryPath, level, sprites);
+	if (!written || !Utils::replaceFile(temporaryPath, path))
+	{
+		std::remove(temporaryPath.c_str());
+		std::cout << "Could not write level file: " << path << std::endl;
+		return false;
+	}
 
-	if (!fs::is_directory(dpath)) return entries;
+	//the hot reloader sees the write like any other change
+	sf::Uint32 checksum;
+	if (fileChecksum(path, checksum))
+	{
+		auto& written = getWrittenFiles();
+		std::lock_guard<std::mutex> lock(written.mutex);
+		written.checksums[path] = checksum;
+	}
+	return true;
+}
 
-	for (auto it = fs::directory_iterator(dpath); it != fs::directory_iterator(); ++it)
+bool LevelReaderWriter::isOwnWrite(const std::string& path)
+{
+	sf::Uint32 stored;
 	{
-		if (!fs::is_directory(it->path()))
+		auto& written = getWrittenFiles();
+		std::lock_guard<std::mutex> lock(written.mutex);
+		auto it = written.checksums.find(path);
+		if (it == written.checksums.end())
 		{
-			entries.emplace_back();
-			std::string path = it->path().string();
-			path.erase(0, std::string(g_customLevelDirectory).size());
-			entries.back() = path;
+			return false;
 		}
+		stored = it->second;
 	}
 
-	return entries;
+	sf::Uint32 checksum;
+	return fileChecksum(path, checksum) && checksum == stored;
 }
 
-void LevelReaderWriter::loadLevel(const std::string& path, std::vector<std::vector<int> >& level, std::vector<Sprite>& sprites) const
+bool LevelReaderWriter::convertLevelFile(const std::string& sourcePath, const std::string& destinationPath)
 {
-	std::ifstream file(path);
+	TileMap level;
+	std::vector<Sprite> sprites;
+	if (!readLevelFile(sourcePath, level, sprites))
+	{
+		return false;
+	}
+
+	//release the source mapping before writing, paged levels are streamed
+	if (!level.isPaged())
+	{
+		level.detach();
+	}
+	return writeLevelFile(destinationPath, level, sprites);
+}
+
+bool LevelReaderWriter::isBinaryLevelFile(const std::string& path)
+{
+	const std::string extension(g_binaryLevelExtension);
+	return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool LevelReaderWriter::readTextLevel(const std::string& path, TileMap& level, std::vector<Sprite>& sprites, const LevelLoadProgress& progress)
+{
+	//shipped levels are parsed straight from the resource pack
+	const char* data;
+	size_t size;
+	MappedFile file;
+	if (!ResourcePack::get().findFile(path, data, size))
+	{
+		if (!file.open(path))
+		{
+			std::cout << "Could not open level file: " << path << std::endl;
+			return false;
+		}
+		data = reinterpret_cast<const char*>(file.getData());
+		size = file.getSize();
+	}
+
+	TextLevelParser parser(data, data + size);
+	parser.setProgressCallback(progress);
+	if (!parser.parse(level, sprites))
+	{
+		if (parser.isCancelled())
+		{
+			return false;
+		}
+		std::cout << path << ":" << parser.getErrorLine() << ":" << parser.getErrorColumn() << ": " << parser.getError() << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool LevelReaderWriter::readBinaryLevel(const std::string& path, TileMap& level, std::vector<Sprite>& sprites)
+{
+	//chunked levels can be larger than the address space, only their header is read here
+	std::ifstream stream(path, std::ios::in | std::ios::binary);
+	if (!stream.is_open())
+	{
+		std::cout << "Could not open level file: " << path << std::endl;
+		return false;
+	}
 
-	//load walls
-	std::string line;
-	while (std::getline(file, line))
+	BinaryLevelHeader header;
+	if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
 	{
-		if (!file.good())
-			break;
+		std::cout << "Level file is truncated: " << path << std::endl;
+		return false;
+	}
+
+	if (std::memcmp(header.magic, g_binaryLevelMagic, sizeof(header.magic)) != 0 ||
+		(header.version != g_binaryLevelVersion && header.version != g_chunkedLevelVersion))
+	{
+		std::cout << "Unsupported level file: " << path << std::endl;
+		return false;
+	}
+
+	if (header.version == g_chunkedLevelVersion)
+	{
+		return readChunkedLevel(path, stream, header, level, sprites);
+	}
+	stream.close();
+
+	auto file = std::make_shared<MappedFile>();
+	if (!file->open(path))
+	{
+		std::cout << "Could not open level file: " << path << std::endl;
+		return false;
+	}
+
+	const unsigned char* data = file->getData();
+	const size_t size = file->getSize();
 
-		if (line.size() == 0)
-			break;
+	//the product of two 32 bit sizes cannot wrap
+	const std::uint64_t tileCount = std::uint64_t(header.sizeX) * header.sizeY;
+	if (!validLevelSize(header) ||
+		header.tileOffset % alignof(std::int32_t) != 0 ||
+		!fitsInFile(header.tileOffset, tileCount, sizeof(std::int32_t), size) ||
+		!fitsInFile(header.spriteOffset, header.spriteCount, sizeof(BinarySprite), size))
+	{
+		std::cout << "Level file is corrupted: " << path << std::endl;
+		return false;
+	}
+
+	//hashing touches every page, only done when requested
+	if (g_verifyLevelChecksum &&
+		Utils::checksum(data + sizeof(header), size - sizeof(header)) != header.checksum)
+	{
+		std::cout << "Level file checksum mismatch: " << path << std::endl;
+		return false;
+	}
 
-		std::stringstream iss(line);
-		std::string val;
+	//tiles are used in place, the map keeps the file mapped
+	level.attach(file, reinterpret_cast<const std::int32_t*>(data + header.tileOffset), int(header.sizeX), int(header.sizeY));
 
-		std::vector<int> rowVec;
+	sprites.resize(static_cast<size_t>(header.spriteCount));
+	for (size_t i = 0; i < sprites.size(); i++)
+	{
+		BinarySprite spr;
+		std::memcpy(&spr, data + header.spriteOffset + i * sizeof(BinarySprite), sizeof(spr));
+		sprites[i].x = spr.x;
+		sprites[i].y = spr.y;
+		sprites[i].texture = spr.texture;
+	}
+
+	return true;
+}
+
+bool LevelReaderWriter::readChunkedLevel(const std::string& path, std::ifstream& stream, const BinaryLevelHeader& header, TileMap& level, std::vector<Sprite>& sprites)
+{
+	stream.seekg(0, std::ios::end);
+	const std::uint64_t size = static_cast<std::uint64_t>(stream.tellg());
 
-		while (std::getline(iss, val, ','))
+	const std::uint64_t chunkSize = header.chunkSize;
+	if (!validLevelSize(header) || chunkSize == 0 || chunkSize > g_maxLevelChunkSize || (chunkSize & (chunkSize - 1)) != 0)
+	{
+		std::cout << "Level file is corrupted: " << path << std::endl;
+		return false;
+	}
+
+	//sizes below INT_MAX and a bounded chunk size keep these products from wrapping
+	const std::uint64_t chunksX = (header.sizeX + chunkSize - 1) / chunkSize;
+	const std::uint64_t chunksY = (header.sizeY + chunkSize - 1) / chunkSize;
+	const std::uint64_t chunkBytes = chunkSize * chunkSize * sizeof(std::int32_t);
+	if (!fitsInFile(header.tileOffset, chunksX * chunksY, chunkBytes, size) ||
+		!fitsInFile(header.spriteOffset, header.spriteCount, sizeof(BinarySprite), size))
+	{
+		std::cout << "Level file is corrupted: " << path << std::endl;
+		return false;
+	}
+
+	//hashing reads the whole file, only done when requested
+	if (g_verifyLevelChecksum)
+	{
+		std::vector<char> block(1 << 20);
+		auto checksum = Utils::checksum(nullptr, 0);
+		stream.seekg(sizeof(header));
+		while (stream.read(block.data(), block.size()) || stream.gcount() > 0)
 		{
-			if (!iss.good())
-				break;
+			checksum = Utils::checksum(block.data(), static_cast<size_t>(stream.gcount()), checksum);
+		}
+		stream.clear();
 
-			auto converted = 0;
-			std::stringstream convertor(val);
-			convertor >> converted;
-			rowVec.push_back(converted);
+		if (checksum != header.checksum)
+		{
+			std::cout << "Level file checksum mismatch: " << path << std::endl;
+			return false;
 		}
+	}
 
-		level.push_back(rowVec);
+	std::vector<BinarySprite> binarySprites(static_cast<size_t>(header.spriteCount));
+	stream.seekg(static_cast<std::streamoff>(header.spriteOffset));
+	if (!binarySprites.empty() && !stream.read(reinterpret_cast<char*>(binarySprites.data()), binarySprites.size() * sizeof(BinarySprite)))
+	{
+		std::cout << "Level file is truncated: " << path << std::endl;
+		return false;
 	}
 
-	//load sprites
-	while (std::getline(file, line))
+	sprites.resize(binarySprites.size());
+	for (size_t i = 0; i < sprites.size(); i++)
+	{
+		sprites[i].x = binarySprites[i].x;
+		sprites[i].y = binarySprites[i].y;
+		sprites[i].texture = binarySprites[i].texture;
+	}
+
+	//tiles stay on disk until they are read
+	auto store = std::make_shared<TileChunkStore>(g_levelChunkBudget);
+	if (!store->open(path, int(header.sizeX), int(header.sizeY), int(chunkSize), header.tileOffset))
+	{
+		std::cout << "Could not open level file: " << path << std::endl;
+		return false;
+	}
+	level.page(store);
+
+	return true;
+}
+
+bool LevelReaderWriter::writeTextLevel(const std::string& path, const TileMap& level, const std::vector<Sprite>& sprites)
+{
+
+	//warning! overwrites the file if exists
+	std::fstream file(path, std::ios::out);
+	if (!file.is_open())
 	{
-		if (!file.good())
-			break;
+		return false;
+	}
 
-		std::stringstream iss(line);
+	//write walls
+	for (int i = 0; i < level.getSizeX(); ++i)
+	{
+		for (int j = 0; j < level.getSizeY(); ++j)
+		{
+			file << level.get(i, j) << ",";
+		}
+		file << "\n";
 
-		Sprite spr;
-		for (auto col = 0; col < 3; col++)
+		if ((i + 1) % g_levelChunkSize == 0)
 		{
-			std::string val;
-			std::getline(iss, val, ',');
-			if (!iss.good())
-				break;
+			level.trim();
+		}
+	}
+	file << "\n";
+
+	//write sprites
+	for (auto& spr : sprites)
+	{
+		file << spr.x << "," << spr.y << "," << spr.texture << "," << "\n";
+	}
+	file << "\n";
+	file.close();
+	return !file.fail();
+}
 
-			std::stringstream convertor(val);
+bool LevelReaderWriter::writeBinaryLevel(const std::string& path, const TileMap& level, const std::vector<Sprite>& sprites)
+{
+	const size_t tileCount = static_cast<size_t>(level.getSizeX()) * level.getSizeY();
+	if (level.isPaged() || static_cast<long long>(tileCount) >= g_pagedLevelMinimumTiles)
+	{
+		return writeChunkedLevel(path, level, sprites);
+	}
 
-			switch (col)
+	//header and tiles followed by the sprite table, both 8 byte aligned
+	std::vector<unsigned char> payload(tileCount * sizeof(std::int32_t) + sprites.size() * sizeof(BinarySprite));
+	for (int x = 0; x < level.getSizeX(); x++)
+	{
+		std::memcpy(&payload[static_cast<size_t>(x) * level.getSizeY() * sizeof(std::int32_t)], level.getLine(x), level.getSizeY() * sizeof(std::int32_t));
+	}
+
+	const size_t spriteStart = (tileCount * sizeof(std::int32_t) + 7) / 8 * 8;
+	payload.resize(spriteStart + sprites.size() * sizeof(BinarySprite), 0);
+	for (size_t i = 0; i < sprites.size(); i++)
+	{
+		BinarySprite spr;
+		spr.x = sprites[i].x;
+		spr.y = sprites[i].y;
+		spr.texture = sprites[i].texture;
+		spr.reserved = 0;
+		std::memcpy(&payload[spriteStart + i * sizeof(BinarySprite)], &spr, sizeof(spr));
+	}
+
+	BinaryLevelHeader header;
+	std::memcpy(header.magic, g_binaryLevelMagic, sizeof(header.magic));
+	header.version = g_binaryLevelVersion;
+	header.sizeX = std::uint32_t(level.getSizeX());
+	header.sizeY = std::uint32_t(level.getSizeY());
+	header.spriteCount = sprites.size();
+	header.tileOffset = sizeof(header);
+	header.spriteOffset = sizeof(header) + spriteStart;
+	header.checksum = Utils::checksum(payload.data(), payload.size());
+	header.chunkSize = 0;
+
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+	return file.good();
+}
+
+// streams the level chunk by chunk, the tiles are never held in one buffer
+bool LevelReaderWriter::writeChunkedLevel(const std::string& path, const TileMap& level, const std::vector<Sprite>& sprites)
+{
+	const int chunkSize = g_levelChunkSize;
+	const int chunksX = (level.getSizeX() + chunkSize - 1) / chunkSize;
+	const int chunksY = (level.getSizeY() + chunkSize - 1) / chunkSize;
+	const size_t chunkBytes = static_cast<size_t>(chunkSize) * chunkSize * sizeof(std::int32_t);
+
+	BinaryLevelHeader header;
+	std::memcpy(header.magic, g_binaryLevelMagic, sizeof(header.magic));
+	header.version = g_chunkedLevelVersion;
+	header.sizeX = std::uint32_t(level.getSizeX());
+	header.sizeY = std::uint32_t(level.getSizeY());
+	header.spriteCount = sprites.size();
+	header.tileOffset = sizeof(header);
+	header.spriteOffset = sizeof(header) + std::uint64_t(chunksX) * chunksY * chunkBytes;
+	header.checksum = 0;
+	header.chunkSize = std::uint32_t(chunkSize);
+
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	//the header is rewritten with the checksum at the end
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	auto checksum = Utils::checksum(nullptr, 0);
+
+	std::vector<std::int32_t> line(level.getSizeY());
+	std::vector<std::int32_t> chunkLine(static_cast<size_t>(chunksY) * chunkSize * chunkSize, 0);
+	for (int cx = 0; cx < chunksX; cx++)
+	{
+		//one line of chunks at a time, padded with empty tiles at the edges
+		std::fill(chunkLine.begin(), chunkLine.end(), 0);
+		for (int lx = 0; lx < chunkSize && cx * chunkSize + lx < level.getSizeX(); lx++)
+		{
+			level.copyLine(cx * chunkSize + lx, line.data());
+			for (int y = 0; y < level.getSizeY(); y++)
 			{
-			case 0: convertor >> spr.x; break;
-			case 1: convertor >> spr.y; break;
-			case 2: convertor >> spr.texture; break;
-			default: break;
+				chunkLine[(static_cast<size_t>(y / chunkSize) * chunkSize + lx) * chunkSize + y % chunkSize] = line[y];
 			}
 		}
-		sprites.push_back(spr);
+		level.trim();
+
+		file.write(reinterpret_cast<const char*>(chunkLine.data()), chunkLine.size() * sizeof(std::int32_t));
+		checksum = Utils::checksum(chunkLine.data(), chunkLine.size() * sizeof(std::int32_t), checksum);
 	}
+
+	for (auto& sprite : sprites)
+	{
+		BinarySprite spr;
+		spr.x = sprite.x;
+		spr.y = sprite.y;
+		spr.texture = sprite.texture;
+		spr.reserved = 0;
+		file.write(reinterpret_cast<const char*>(&spr), sizeof(spr));
+		checksum = Utils::checksum(&spr, sizeof(spr), checksum);
+	}
+
+	header.checksum = checksum;
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	return file.good();
 }
 
 // generates some textures for testing
@@ -229,15 +814,191 @@ void LevelReaderWriter::generateTextures()
 void LevelReaderWriter::loadTexture(int index, const std::string& fileName)
 {
 	sf::Image image;
-	image.loadFromFile(fileName);
-	const sf::Uint8* imagePtr = image.getPixelsPtr();
+	decodeTexture(fileName, image, m_texture[index]);
+	image.createMaskFromColor(sf::Color::Black);
+	m_sfmlTextures[index].loadFromImage(image);
+}
+
+bool LevelReaderWriter::reloadTexture(const int index, const sf::Image& image)
+{
+	if (index < 0 || index >= int(m_texture.size()) ||
+		image.getSize().x != unsigned(g_textureWidth) || image.getSize().y != unsigned(g_textureHeight))
+	{
+		return false;
+	}
+
+	//textures not in use are decoded from the new file once they are needed
+	if (!isTextureResident(index))
+	{
+		return true;
+	}
+
+	toTexels(image, m_texture[index]);
+
+	sf::Image masked = image;
+	masked.createMaskFromColor(sf::Color::Black);
+	return m_sfmlTextures[index].loadFromImage(masked);
+}
+
+void LevelReaderWriter::requireTexture(const int index)
+{
+	if (index >= 0 && index < int(m_texture.size()) && !isTextureResident(index))
+	{
+		loadTextures({ index });
+	}
+}
+
+void LevelReaderWriter::loadAllTextures()
+{
+	std::vector<int> missing;
+	for (int i = 0; i < int(m_texture.size()); i++)
+	{
+		if (!isTextureResident(i))
+		{
+			missing.push_back(i);
+		}
+	}
+	loadTextures(missing);
+}
+
+void LevelReaderWriter::updateResidentTextures()
+{
+	const auto used = getUsedTextures();
+
+	std::vector<int> missing;
+	for (int i = 0; i < int(m_texture.size()); i++)
+	{
+		if (used[i] && !isTextureResident(i))
+		{
+			missing.push_back(i);
+		}
+		else if (!used[i] && isTextureResident(i))
+		{
+			//sf::Texture objects stay in place, the editor keeps pointers to them
+			std::vector<sf::Uint32>().swap(m_texture[i]);
+			m_sfmlTextures[i] = sf::Texture();
+		}
+	}
+	loadTextures(missing);
+}
+
+// decodes the files in parallel, the SFML textures are created on the calling thread
+void LevelReaderWriter::loadTextures(const std::vector<int>& indices)
+{
+	if (indices.empty())
+	{
+		return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<sf::Image> images(indices.size());
+	std::vector<std::vector<sf::Uint32> > texels(indices.size());
+
+	std::atomic<size_t> next(0);
+	auto decode = [&]()
+	{
+		for (size_t i = next++; i < indices.size(); i = next++)
+		{
+			decodeTexture(g_textureFiles[indices[i]], images[i], texels[i]);
+		}
+	};
+
+	const size_t threadCount = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), indices.size());
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < threadCount; i++)
+	{
+		workers.emplace_back(decode);
+	}
+	decode();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		m_texture[indices[i]] = std::move(texels[i]);
+		images[i].createMaskFromColor(sf::Color::Black);
+		m_sfmlTextures[indices[i]].loadFromImage(images[i]);
+	}
+
+	const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Loaded " << indices.size() << " textures in " << elapsed << " ms on " << threadCount << " threads" << std::endl;
+}
 
-	std::vector<sf::Uint32> texData;
-	for (int i = 0; i < (g_textureHeight * g_textureWidth * 4); i += 4)
+// the floor, the ceiling and every texture the walls and sprites of the level refer to
+std::vector<bool> LevelReaderWriter::getUsedTextures() const
+{
+	std::vector<bool> used(m_texture.size(), false);
+	used[8] = true;
+	used[9] = true;
+
+	for (auto& sprite : m_sprites)
 	{
-		texData.push_back(
-			imagePtr[i + 3] << 24 | imagePtr[i + 2] << 16 | imagePtr[i + 1] << 8 | imagePtr[i]);
+		if (sprite.texture >= 0 && sprite.texture < int(used.size()))
+		{
+			used[sprite.texture] = true;
+		}
 	}
 
-	m_texture[index] = texData;
+	//the tiles of a paged level are mostly on disk, any wall texture may be needed
+	if (m_level.isPaged())
+	{
+		std::fill(used.begin(), used.begin() + 8, true);
+		return used;
+	}
+
+	for (int x = 0; x < m_level.getSizeX(); x++)
+	{
+		for (int y = 0; y < m_level.getSizeY(); y++)
+		{
+			const int id = m_level.get(x, y);
+			if (id > 0 && id <= int(used.size()))
+			{
+				used[id - 1] = true;
+			}
+		}
+	}
+
+	return used;
+}
+
+// a single decode gives the image for SFML and the transposed texels of the raycaster
+bool LevelReaderWriter::decodeTexture(const std::string& fileName, sf::Image& image, std::vector<sf::Uint32>& texels)
+{
+	//packed textures are already decoded and transposed
+	ResourcePack::Image packed;
+	if (ResourcePack::get().findImage(fileName, packed) && packed.texels)
+	{
+		image.create(packed.width, packed.height, packed.pixels);
+		texels.assign(packed.texels, packed.texels + g_textureWidth * g_textureHeight);
+		return true;
+	}
+
+	const bool loaded = image.loadFromFile(fileName) && image.getSize().x == unsigned(g_textureWidth) && image.getSize().y == unsigned(g_textureHeight);
+	if (!loaded)
+	{
+		std::cout << "Texture " << fileName << " is missing or not " << g_textureWidth << "x" << g_textureHeight << std::endl;
+		image.create(g_textureWidth, g_textureHeight, sf::Color::Black);
+	}
+
+	toTexels(image, texels);
+	return loaded;
+}
+
+// columns are contiguous so the raycaster walks down a wall stripe linearly
+void LevelReaderWriter::toTexels(const sf::Image& image, std::vector<sf::Uint32>& texels)
+{
+	texels.resize(g_textureWidth * g_textureHeight);
+
+	const sf::Uint8* imagePtr = image.getPixelsPtr();
+	for (int y = 0; y < g_textureHeight; y++)
+	{
+		for (int x = 0; x < g_textureWidth; x++)
+		{
+			const sf::Uint8* pixel = imagePtr + (g_textureWidth * y + x) * 4;
+			texels[g_textureHeight * x + y] = pixel[3] << 24 | pixel[2] << 16 | pixel[1] << 8 | pixel[0];
+		}
+	}
 }
@@ -1,43 +1,136 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+
+#include "LevelCatalog.h"
+#include "TileMap.h"
 
 struct Sprite;
+struct BinaryLevelHeader;
+class LevelLoader;
+class Autosaver;
+
+// called with the loaded fraction of a level, returning false cancels loading
+typedef std::function<bool(float)> LevelLoadProgress;
 
 class LevelReaderWriter
 {
 public:
 	LevelReaderWriter();
-	virtual ~LevelReaderWriter() = default;
+	virtual ~LevelReaderWriter();
 
-	const std::vector<std::vector<int> >& getLevel() const { return m_level; }
+	const TileMap& getLevel() const { return m_level; }
+	// file of the level in use, kept when the level is edited
+	const std::string& getLevelPath() const { return m_levelPath; }
 	const std::vector<Sprite>& getSprites() const { return m_sprites; };
+	// changes whenever the tiles or the sprites change
+	unsigned int getRevision() const { return m_revision; }
 
 	const std::vector<std::vector<sf::Uint32> >& getTextures() const { return m_texture; };
 	const std::vector<sf::Uint32>& getTexture(const int index) const { return m_texture[index]; };
 
 	void changeLevelTile(const int x, const int y, const int value);
+	// one revision for the whole batch
+	void changeLevelTiles(const std::vector<TileRun>& runs);
+	// a non-empty path replaces the file the level is from
+	void setLevel(TileMap level, std::vector<Sprite> sprites, const std::string& path = std::string());
 
-	const sf::Texture* getTextureSfml(const int i) const { return &m_sfmlTextures[i]; };
+	// loads the texture if it is not resident, the pointer stays valid
+	const sf::Texture* getTextureSfml(const int i);
 
 	void moveSprite(const int index, const double x, const double y);
 	void createSprite(double x, double y, int texture);
+	// puts a sprite back at its old index, the sprites from index on move up by one
+	void insertSprite(const int index, const Sprite& sprite);
+	// puts sprites back at their sorted final indices with one pass over the vector
+	void insertSprites(const std::vector<int>& indices, const std::vector<Sprite>& sprites);
 	void deleteSprite(const int index);
+	// removes the sprites at the sorted indices with one pass over the vector
+	void deleteSprites(const std::vector<int>& indices);
 
 	void loadDefaultLevel();
 	void loadCustomLevel(const std::string& levelName);
+	void loadLevelFile(const std::string& path);
+
+	// reads the level on a worker thread, the current level stays in use until publishLoadedLevel()
+	void loadDefaultLevelAsync();
+	void loadCustomLevelAsync(const std::string& levelName);
+	void loadLevelFileAsync(const std::string& path);
+	bool isLoading() const { return m_loader != nullptr; }
+	float getLoadProgress() const;
+
+	// swaps in a finished asynchronous load, call between frames.
+	// returns true if the level changed
+	bool publishLoadedLevel();
+
 	void saveCustomLevel(const std::string& levelName);
+	// written by the autosave worker when it holds the level, otherwise right away
+	void saveCustomLevelAsync(const std::string& levelName);
+	// adds the levels saved in the background to the catalog, call between frames.
+	// returns true if the catalog changed
+	bool publishSavedLevels();
+	void saveLevelFile(const std::string& path);
 	std::vector<std::string> getCustomLevels() const;
+	const LevelCatalog& getCatalog() const { return *m_catalog; }
+	LevelCatalog& getCatalog() { return *m_catalog; }
+
+	// crash recovery of the level editor, outlives the editor so leaving it never waits for the disk
+	std::shared_ptr<Autosaver> getAutosaver();
+
+	// the format is chosen by the file extension, g_binaryLevelExtension or text
+	static bool readLevelFile(const std::string& path, TileMap& level, std::vector<Sprite>& sprites, const LevelLoadProgress& progress = nullptr);
+	static bool writeLevelFile(const std::string& path, const TileMap& level, const std::vector<Sprite>& sprites);
+	// the file still holds what writeLevelFile() last wrote to it, from any thread
+	static bool isOwnWrite(const std::string& path);
+	static bool convertLevelFile(const std::string& sourcePath, const std::string& destinationPath);
+	static bool isBinaryLevelFile(const std::string& path);
+
+	// loads texture data from a file
+	void loadTexture(const int index, const std::string& fileName);
+	// replaces a texture slot with an image of the texture size, call between frames
+	bool reloadTexture(const int index, const sf::Image& image);
+
+	// only the textures used by the level are resident, the others are empty until required
+	bool isTextureResident(const int index) const { return !m_texture[index].empty(); }
+	void requireTexture(const int index);
+	void loadAllTextures();
+
+	// raycaster layout of an image of the texture size, transposed so wall columns are contiguous
+	static void toTexels(const sf::Image& image, std::vector<sf::Uint32>& texels);
 
 private:
 
-	std::vector<std::vector<int> >m_level;
+	TileMap m_level;
+	std::string m_levelPath;
 	std::vector<Sprite> m_sprites;
+	unsigned int m_revision = 0;
 	std::vector<std::vector<sf::Uint32> > m_texture;
 	std::vector<sf::Texture> m_sfmlTextures;
 
-	void loadLevel(const std::string& path, std::vector<std::vector<int> >& level, std::vector<Sprite>& sprites) const;
+	std::unique_ptr<LevelLoader> m_loader;
+	std::unique_ptr<LevelCatalog> m_catalog;
+
+	//written by the autosave worker
+	std::mutex m_savedMutex;
+	std::vector<LevelCatalogEntry> m_savedLevels;
+	//declared last, its worker finishes before the members it reports to are gone
+	std::shared_ptr<Autosaver> m_autosaver;
+
+	static bool readTextLevel(const std::string& path, TileMap& level, std::vector<Sprite>& sprites, const LevelLoadProgress& progress);
+	static bool readBinaryLevel(const std::string& path, TileMap& level, std::vector<Sprite>& sprites);
+	static bool readChunkedLevel(const std::string& path, std::ifstream& stream, const BinaryLevelHeader& header, TileMap& level, std::vector<Sprite>& sprites);
+	static bool writeTextLevel(const std::string& path, const TileMap& level, const std::vector<Sprite>& sprites);
+	static bool writeBinaryLevel(const std::string& path, const TileMap& level, const std::vector<Sprite>& sprites);
+	static bool writeChunkedLevel(const std::string& path, const TileMap& level, const std::vector<Sprite>& sprites);
 	void generateTextures();
-	void loadTexture(const int index, const std::string& fileName);
+
+	void updateResidentTextures();
+	void loadTextures(const std::vector<int>& indices);
+	std::vector<bool> getUsedTextures() const;
+	static bool decodeTexture(const std::string& fileName, sf::Image& image, std::vector<sf::Uint32>& texels);
 };
 
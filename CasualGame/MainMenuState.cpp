@@ -1,20 +1,25 @@
 #include "MainMenuState.h"
 
 #include "Game.h"
+#include "ParticleField.h"
 #include "RandomGenerator.h"
+#include "ResourceCache.h"
 #include "Config.h"
 
+#include <algorithm>
+
 RandomGenerator MainMenuState::gen = RandomGenerator();
 
 MainMenuState::MainMenuState(const int w, const int h) :
 	m_windowWidth(w),
-	m_windowHeight(h)
+	m_windowHeight(h),
+	m_font(ResourceCache::get().getFont(g_fontFile))
 {
 
 	// Game Title
 	sf::Color textColor = sf::Color::White;
 
-	m_titleText.setFont(g_fontLoader->getFont());
+	m_titleText.setFont(*m_font);
 	m_titleText.setString(g_mainTxtTitle);
 	m_titleText.setCharacterSize(50);
 	m_titleText.setPosition(m_windowWidth / 2.0f, 200);
@@ -24,7 +29,7 @@ MainMenuState::MainMenuState(const int w, const int h) :
 	// Menu Items
 	// Start Game
 	sf::Text startGame;
-	startGame.setFont(g_fontLoader->getFont());
+	startGame.setFont(*m_font);
 	startGame.setString(g_mainTxtStartGame);
 	startGame.setCharacterSize(30);
 	startGame.setPosition(m_windowWidth / 2.0f, 300);
@@ -35,7 +40,7 @@ MainMenuState::MainMenuState(const int w, const int h) :
 
 	// Restart Game
 	sf::Text restartGame;
-	restartGame.setFont(g_fontLoader->getFont());
+	restartGame.setFont(*m_font);
 	restartGame.setString(g_mainTxtRestartGame);
 	restartGame.setCharacterSize(30);
 	restartGame.setPosition(m_windowWidth / 2.0f, 350);
@@ -46,7 +51,7 @@ MainMenuState::MainMenuState(const int w, const int h) :
 
 	// Level Editor 
 	sf::Text levelEditor;
-	levelEditor.setFont(g_fontLoader->getFont());
+	levelEditor.setFont(*m_font);
 	levelEditor.setString(g_mainTxtLevelEditor);
 	levelEditor.setCharacterSize(30);
 	levelEditor.setPosition(m_windowWidth / 2.0f, 400);
@@ -57,7 +62,7 @@ MainMenuState::MainMenuState(const int w, const int h) :
 
 	//Toggle Fullscreen
 	sf::Text switchFullscreen;
-	switchFullscreen.setFont(g_fontLoader->getFont());
+	switchFullscreen.setFont(*m_font);
 	switchFullscreen.setString(g_mainTxtToggleFullscreen);
 	switchFullscreen.setCharacterSize(30);
 	switchFullscreen.setPosition(m_windowWidth / 2.0f, 450);
@@ -68,7 +73,7 @@ MainMenuState::MainMenuState(const int w, const int h) :
 
 	//Quit Game
 	sf::Text quitGame;
-	quitGame.setFont(g_fontLoader->getFont());
+	quitGame.setFont(*m_font);
 	quitGame.setString(g_mainTxtQuit);
 	quitGame.setCharacterSize(30);
 	quitGame.setPosition(m_windowWidth / 2.0f, 500);
@@ -83,26 +88,23 @@ MainMenuState::MainMenuState(const int w, const int h) :
 		m_bgColors.emplace_back(0, 0, 0, 150);
 	}
 
-	// followers vector
-	for (int i = 0; i < 200; ++i)
+	// followers
+	m_followers = std::make_unique<ParticleField>(sf::Vector2f(m_windowWidth / 2.0f, m_windowHeight / 2.0f), g_menuParticleSize, sf::Color::White);
+	m_followers->reserve(g_menuParticleCount);
+	for (int i = 0; i < g_menuParticleCount; ++i)
 	{
-		sf::CircleShape circle(1.5f);
-		circle.setFillColor(sf::Color::White);
-		circle.setPosition(gen.randomFloat(0.0f, static_cast<float>(m_windowWidth)), gen.randomFloat(0.0f, static_cast<float>(m_windowWidth)));
-		m_followers.push_back(circle);
+		m_followers->add(sf::Vector2f(gen.randomFloat(0.0f, static_cast<float>(m_windowWidth)), gen.randomFloat(0.0f, static_cast<float>(m_windowWidth))));
 	}
 
 }
 
+MainMenuState::~MainMenuState() = default;
+
 void MainMenuState::update(const float ft)
 {
 
-	sf::Transform rotation;
-	rotation.rotate(0.01f, m_windowWidth / 2.0f, m_windowHeight / 2.0f);
-	for (size_t i = 0; i < m_followers.size(); ++i)
-	{
-		m_followers[i].setPosition(rotation.transformPoint(m_followers[i].getPosition()));
-	}
+	//the particles are moved once per drawn frame
+	m_followers->rotate(g_menuParticleSpeed * ft);
 
 	const int colorMax = 100;
 
@@ -110,7 +112,7 @@ void MainMenuState::update(const float ft)
 	for (size_t i = 0; i < m_bgColors.size(); ++i)
 	{
 
-		if (gen.randomInt(0, 100) < 10)
+		if (gen.randomChance(std::min(0.1f * ft, 1.0f)))
 		{
 			m_bgColors[i].r += gen.randomInt(-2, 2);
 			m_bgColors[i].g += gen.randomInt(-2, 2);
@@ -133,10 +135,8 @@ void MainMenuState::draw(sf::RenderWindow& window)
 	window.clear();
 
 	//draw followers 
-	for (const auto follower : m_followers)
-	{
-		window.draw(follower);
-	}
+	m_followers->update();
+	window.draw(*m_followers);
 
 	//bg rectangle
 	sf::Vertex bgRect[] = {
@@ -1,15 +1,18 @@
 #pragma once
 
+#include <memory>
+
 #include "GameState.h"
 
 class Game;
 class RandomGenerator;
+class ParticleField;
 
 class MainMenuState : public GameState
 {
 public:
 	MainMenuState(const int w, const int h);
-	virtual ~MainMenuState() = default;
+	virtual ~MainMenuState();
 
 	void update(const float ft) override;
 	void draw(sf::RenderWindow& window) override;
@@ -21,6 +24,7 @@ private:
 
 	const int m_windowWidth;
 	const int m_windowHeight;
+	std::shared_ptr<const sf::Font> m_font;
 
 	std::vector<sf::Text> m_menuItems;
 	sf::Text m_titleText;
@@ -30,7 +34,7 @@ private:
 	unsigned int m_mouseOverIndex = 0;
 
 	std::vector<sf::Color> m_bgColors;
-	std::vector<sf::CircleShape> m_followers;
+	std::unique_ptr<ParticleField> m_followers;
 
 };
 
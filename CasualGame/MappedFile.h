@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read only memory mapping of a whole file
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	virtual ~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	const unsigned char* getData() const { return m_data; }
+	size_t getSize() const { return m_size; }
+	bool isOpen() const { return m_data != nullptr; }
+
+private:
+
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+};
@@ -0,0 +1,188 @@
+#include "Minimap.h"
+
+#include "HudCompositor.h"
+#include "TileMap.h"
+#include "Sprite.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <cmath>
+
+Minimap::Minimap(const sf::Vector2f& size, const float scale) :
+	m_size(size),
+	m_scale(scale)
+{
+	// Minimap player arrow
+	m_player.setPointCount(7);
+	m_player.setPoint(0, sf::Vector2f(0, 0));
+	m_player.setPoint(1, sf::Vector2f(10, 10));
+	m_player.setPoint(2, sf::Vector2f(5, 10));
+	m_player.setPoint(3, sf::Vector2f(5, 15));
+	m_player.setPoint(4, sf::Vector2f(-5, 15));
+	m_player.setPoint(5, sf::Vector2f(-5, 10));
+	m_player.setPoint(6, sf::Vector2f(-10, 10));
+}
+
+void Minimap::rebuild(const TileMap& level)
+{
+	m_sizeX = level.getSizeX();
+	m_sizeY = level.getSizeY();
+	m_mapSize = sf::Vector2f(m_sizeY * m_scale, m_sizeX * m_scale);
+
+	//paged levels are too large to be flagged at once, their window follows the player
+	m_paged = level.isPaged();
+	m_hasWalls = false;
+	m_window = sf::IntRect();
+	std::vector<sf::Uint8>().swap(m_walls);
+	if (!m_paged && !level.empty())
+	{
+		readWalls(level, sf::IntRect(0, 0, m_sizeY, m_sizeX));
+	}
+}
+
+void Minimap::updatePagedWalls(const TileMap& level)
+{
+	if (!m_paged || level.getSizeX() != m_sizeX || level.getSizeY() != m_sizeY)
+	{
+		return;
+	}
+
+	const auto area = getVisibleArea();
+	const sf::IntRect visible(int(area.left / m_scale), int(area.top / m_scale),
+		int(std::ceil((area.left + area.width) / m_scale)) - int(area.left / m_scale),
+		int(std::ceil((area.top + area.height) / m_scale)) - int(area.top / m_scale));
+	if (m_hasWalls && visible.left >= m_window.left && visible.top >= m_window.top &&
+		visible.left + visible.width <= m_window.left + m_window.width && visible.top + visible.height <= m_window.top + m_window.height)
+	{
+		return;
+	}
+
+	//half a view of margin on every side, so the window is read again only every few steps
+	const int marginY = visible.width / 2 + 1;
+	const int marginX = visible.height / 2 + 1;
+	const int left = std::max(visible.left - marginY, 0);
+	const int top = std::max(visible.top - marginX, 0);
+	const int right = std::min(visible.left + visible.width + marginY, m_sizeY);
+	const int bottom = std::min(visible.top + visible.height + marginX, m_sizeX);
+	readWalls(level, sf::IntRect(left, top, right - left, bottom - top));
+}
+
+void Minimap::readWalls(const TileMap& level, const sf::IntRect& window)
+{
+	m_window = window;
+	m_walls.assign(static_cast<size_t>(window.width) * window.height, 0);
+	std::vector<std::int32_t> line(m_sizeY);
+	for (int x = 0; x < window.height; x++)
+	{
+		auto walls = m_walls.data() + static_cast<size_t>(x) * window.width;
+		if (window.width == m_sizeY)
+		{
+			level.copyLine(window.top + x, line.data());
+			for (int y = 0; y < window.width; y++)
+			{
+				walls[y] = line[y] > 0 && line[y] < 9;
+			}
+			continue;
+		}
+
+		//the window is a few dozen tiles around the player, its chunks are mostly resident already
+		for (int y = 0; y < window.width; y++)
+		{
+			const int tile = level.get(window.top + x, window.left + y);
+			walls[y] = tile > 0 && tile < 9;
+		}
+	}
+	m_hasWalls = !m_walls.empty();
+}
+
+void Minimap::updateEntities(const std::vector<Sprite>& sprites)
+{
+	//only grows or shrinks by the sprites added or removed
+	m_entities.resize(sprites.size());
+	for (size_t i = 0; i < sprites.size(); i++)
+	{
+		m_entities[i] = sf::Vector2f(float(sprites[i].y) * m_scale, float(sprites[i].x) * m_scale);
+	}
+}
+
+void Minimap::setPlayer(const double x, const double y, const float rotation)
+{
+	m_player.setPosition(float(y) * m_scale, float(x) * m_scale);
+	m_player.setRotation(rotation);
+}
+
+sf::FloatRect Minimap::getVisibleArea() const
+{
+	//the visible part is centered on the player and stays inside the level
+	const sf::Vector2f size(std::min(m_size.x, m_mapSize.x), std::min(m_size.y, m_mapSize.y));
+	const auto player = m_player.getPosition();
+	const float left = std::floor(std::max(0.0f, std::min(player.x - size.x / 2.0f, m_mapSize.x - size.x)));
+	const float top = std::floor(std::max(0.0f, std::min(player.y - size.y / 2.0f, m_mapSize.y - size.y)));
+	return sf::FloatRect(left, top, size.x, size.y);
+}
+
+void Minimap::composite(HudCompositor& hud) const
+{
+	const auto area = getVisibleArea();
+	const sf::Vector2f size(area.width, area.height);
+	if (size.x <= 0.0f || size.y <= 0.0f)
+	{
+		return;
+	}
+
+	const float left = area.left;
+	const float top = area.top;
+	hud.setClip(sf::IntRect(0, 0, int(size.x), int(size.y)));
+
+	const sf::Uint8 alpha = sf::Uint8(g_playMinimapTransparency);
+	hud.blendRect(sf::FloatRect(0.0f, 0.0f, size.x, size.y), sf::Color(150, 150, 150, alpha));
+
+	//walls of a tile line are blended as runs
+	if (m_hasWalls)
+	{
+		//a paged window lags one frame behind the player, tiles outside it are left open
+		const sf::Color wallColor(0, 0, 0, alpha);
+		const int firstX = std::max(int(top / m_scale), m_window.top);
+		const int lastX = std::min(int(std::ceil((top + size.y) / m_scale)), m_window.top + m_window.height);
+		const int firstY = std::max(int(left / m_scale), m_window.left);
+		const int lastY = std::min(int(std::ceil((left + size.x) / m_scale)), m_window.left + m_window.width);
+		for (int x = firstX; x < lastX; x++)
+		{
+			const auto walls = m_walls.data() + static_cast<size_t>(x - m_window.top) * m_window.width - m_window.left;
+			for (int y = firstY; y < lastY; y++)
+			{
+				if (!walls[y])
+				{
+					continue;
+				}
+
+				const int start = y;
+				while (y + 1 < lastY && walls[y + 1])
+				{
+					y++;
+				}
+				hud.blendRect(sf::FloatRect(start * m_scale - left, x * m_scale - top, (y - start + 1) * m_scale, m_scale), wallColor);
+			}
+		}
+	}
+
+	const float half = m_scale / 4.0f;
+	const sf::Color entityColor(0, 0, 255, alpha);
+	for (auto& entity : m_entities)
+	{
+		if (entity.x + half >= left && entity.x - half <= left + size.x && entity.y + half >= top && entity.y - half <= top + size.y)
+		{
+			hud.blendRect(sf::FloatRect(entity.x - half - left, entity.y - half - top, 2.0f * half, 2.0f * half), entityColor);
+		}
+	}
+
+	std::vector<sf::Vector2f> arrow(m_player.getPointCount());
+	const auto& transform = m_player.getTransform();
+	for (size_t i = 0; i < arrow.size(); i++)
+	{
+		arrow[i] = transform.transformPoint(m_player.getPoint(i)) - sf::Vector2f(left, top);
+	}
+	hud.blendPolygon(arrow, sf::Color(255, 255, 255, alpha));
+
+	hud.resetClip();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+class TileMap;
+class HudCompositor;
+struct Sprite;
+
+// Top down map in the corner of the play view, level lines are drawn as rows.
+// The walls are flagged once per level, one byte per tile, and blended into the frame
+// as runs of wall tiles. Entity positions are rewritten in place when sprites change.
+// A level larger than the minimap area scrolls with the player.
+// Paged levels only flag the tiles around the visible part, refreshed once the view leaves them.
+class Minimap
+{
+public:
+	// size is the largest screen area the minimap covers, scale the pixels per tile
+	Minimap(const sf::Vector2f& size, const float scale);
+	virtual ~Minimap() = default;
+
+	// the level was replaced or its tiles changed
+	void rebuild(const TileMap& level);
+	// reads the walls of a paged level around the visible part when it moved out of them,
+	// call between frames after setPlayer()
+	void updatePagedWalls(const TileMap& level);
+	void updateEntities(const std::vector<Sprite>& sprites);
+	// level position of the player and the rotation of its arrow in degrees
+	void setPlayer(const double x, const double y, const float rotation);
+
+	// blends the visible part into the top left corner of the HUD's frame
+	void composite(HudCompositor& hud) const;
+
+private:
+
+	sf::Vector2f m_size;
+	float m_scale;
+	int m_sizeX = 0;
+	int m_sizeY = 0;
+	//whole level in pixels
+	sf::Vector2f m_mapSize;
+
+	bool m_hasWalls = false;
+	bool m_paged = false;
+	//flags of the tiles in the window, left and width are columns, top and height lines
+	std::vector<sf::Uint8> m_walls;
+	sf::IntRect m_window;
+	//in pixels of the whole map
+	std::vector<sf::Vector2f> m_entities;
+	sf::ConvexShape m_player;
+
+	// part of the map shown, in pixels of the whole map
+	sf::FloatRect getVisibleArea() const;
+	void readWalls(const TileMap& level, const sf::IntRect& window);
+};
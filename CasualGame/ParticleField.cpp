@@ -0,0 +1,89 @@
+#include "ParticleField.h"
+
+#include <cmath>
+
+ParticleField::ParticleField(const sf::Vector2f& center, const float size, const sf::Color& color) :
+	m_center(center),
+	m_halfSize(size / 2.0f),
+	m_color(color)
+{
+	//Empty
+}
+
+void ParticleField::reserve(const size_t count)
+{
+	m_offsetX.reserve(count);
+	m_offsetY.reserve(count);
+	m_x.reserve(count);
+	m_y.reserve(count);
+}
+
+void ParticleField::add(const sf::Vector2f& position)
+{
+	//stored as the offset it had before any rotation
+	const float radians = -m_angle * 0.0174532925f;
+	const float c = std::cos(radians);
+	const float s = std::sin(radians);
+	const float dx = position.x - m_center.x;
+	const float dy = position.y - m_center.y;
+	m_offsetX.push_back(dx * c - dy * s);
+	m_offsetY.push_back(dx * s + dy * c);
+	m_x.push_back(position.x);
+	m_y.push_back(position.y);
+
+	//colors never change, only the positions are written again
+	for (int corner = 0; corner < 4; corner++)
+	{
+		m_vertices.append(sf::Vertex(position, m_color));
+	}
+	m_dirty = true;
+}
+
+void ParticleField::rotate(const float angle)
+{
+	//wrapped so the angle keeps its precision however long the menu stays open
+	m_angle = std::fmod(m_angle + angle, 360.0f);
+	m_dirty = true;
+}
+
+void ParticleField::update()
+{
+	if (!m_dirty)
+	{
+		return;
+	}
+	m_dirty = false;
+
+	const float radians = m_angle * 0.0174532925f;
+	const float c = std::cos(radians);
+	const float s = std::sin(radians);
+	const float centerX = m_center.x;
+	const float centerY = m_center.y;
+
+	//rotated from the unchanging offsets, so no error accumulates between frames
+	const size_t count = m_offsetX.size();
+	const float* offsetX = m_offsetX.data();
+	const float* offsetY = m_offsetY.data();
+	float* x = m_x.data();
+	float* y = m_y.data();
+	for (size_t i = 0; i < count; i++)
+	{
+		x[i] = centerX + offsetX[i] * c - offsetY[i] * s;
+		y[i] = centerY + offsetX[i] * s + offsetY[i] * c;
+	}
+
+	const float half = m_halfSize;
+	for (size_t i = 0; i < count; i++)
+	{
+		auto quad = &m_vertices[i * 4];
+		quad[0].position = sf::Vector2f(x[i] - half, y[i] - half);
+		quad[1].position = sf::Vector2f(x[i] + half, y[i] - half);
+		quad[2].position = sf::Vector2f(x[i] + half, y[i] + half);
+		quad[3].position = sf::Vector2f(x[i] - half, y[i] + half);
+	}
+}
+
+void ParticleField::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	target.draw(m_vertices, states);
+}
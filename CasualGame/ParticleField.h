@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+// Particles circling a center point, drawn as square quads of one vertex array.
+// Offsets from the center are kept in one array per coordinate and never change,
+// rotate() only advances the angle. update() rotates every particle in a loop the
+// compiler vectorizes and writes the quads, once per drawn frame instead of per step.
+class ParticleField : public sf::Drawable
+{
+public:
+	ParticleField(const sf::Vector2f& center, const float size, const sf::Color& color);
+	virtual ~ParticleField() = default;
+
+	void reserve(const size_t count);
+	// position at the current angle
+	void add(const sf::Vector2f& position);
+	size_t size() const { return m_offsetX.size(); }
+
+	// degrees around the center
+	void rotate(const float angle);
+	// positions the quads for the current angle, does nothing if it did not change
+	void update();
+
+private:
+
+	sf::Vector2f m_center;
+	float m_halfSize;
+	sf::Color m_color;
+
+	float m_angle = 0.0f;
+	bool m_dirty = true;
+
+	std::vector<float> m_offsetX;
+	std::vector<float> m_offsetY;
+	//rotated positions
+	std::vector<float> m_x;
+	std::vector<float> m_y;
+
+	sf::VertexArray m_vertices{ sf::Quads };
+
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
@@ -7,63 +7,62 @@
 #include "GLRenderer.h"
 #include "GLRaycaster.h"
 #include "Clickable.h"
+#include "Minimap.h"
 #include "PlayerInputManager.h"
+#include "ResourceCache.h"
 #include "Utils.h"
 #include "Config.h"
 
+#include <algorithm>
+
 PlayState::PlayState(const int w, const int h, std::shared_ptr<Player> player, std::shared_ptr<LevelReaderWriter> levelReader) :
 	m_player(move(player)),
-	m_levelReader(move(levelReader))
+	m_levelReader(move(levelReader)),
+	m_font(ResourceCache::get().getFont(g_fontFile)),
+	m_loadingBar(sf::Vector2f(w / 4.0f, h / 2.0f), sf::Vector2f(w / 2.0f, 20.0f), g_txtLoadingLevel)
 {
 
-	m_levelSize = m_levelReader->getLevel().size();
+	m_previousPose = *m_player;
+	m_renderPose = std::make_shared<Player>(*m_player);
+
 	m_spriteSize = m_levelReader->getSprites().size();
 
 	m_inputManager = std::make_unique<PlayerInputManager>();
 
 	m_glRaycaster = std::make_unique<GLRaycaster>();
-	m_glRaycaster->initialize(w, h, m_player, m_levelReader);
+	m_glRaycaster->initialize(w, h, m_renderPose, m_levelReader);
 
-	//Fps display
-	m_fpsDisplay.setFont(g_fontLoader->getFont());
-	m_fpsDisplay.setString("fps");
-	m_fpsDisplay.setCharacterSize(32);
-	m_fpsDisplay.setPosition(float(w) - 10.0f, 0.0f);
-	m_fpsDisplay.setFillColor(sf::Color::Yellow);
+	m_hud = std::make_unique<HudCompositor>(m_font);
+
+	//Fps display, right aligned
+	m_fpsText = m_hud->addText(32, sf::Color::Yellow);
+	m_fpsPosition = sf::Vector2i(w - 10, 0);
 
 	//Health display
-	m_playerHealthDisplay.setFont(g_fontLoader->getFont());
-	m_playerHealthDisplay.setString("health");
-	m_playerHealthDisplay.setCharacterSize(40);
-	m_playerHealthDisplay.setPosition(10.0f, float(h) - m_playerHealthDisplay.getGlobalBounds().height * 3);
-	m_playerHealthDisplay.setFillColor(sf::Color::White);
-
-	//Gun display
-	//idle texture
-	sf::Image gunImg;
-	gunImg.loadFromFile(g_gunSprite);
-	gunImg.createMaskFromColor(sf::Color::Black);
-	m_textureGun.loadFromImage(gunImg);
-
-	//fire texture
-	sf::Image gunImgFire;
-	gunImgFire.loadFromFile(g_gunSprite_fire);
-	gunImgFire.createMaskFromColor(sf::Color::Black);
-	m_textureGun_fire.loadFromImage(gunImgFire);
-
-	//set gun size, position and texture
-	m_gunDisplay.setSize({ float(g_textureWidth * 2), float(g_textureHeight * 2) });
-	m_gunDisplay.setPosition({ float(w / 2 - g_textureWidth), float(h - g_textureHeight * 2 + 30) });
-	m_gunDisplay.setTexture(&m_textureGun);
+	m_healthText = m_hud->addText(40, sf::Color::White);
+	m_hud->setText(m_healthText, "health");
+	m_healthPosition = sf::Vector2i(10, h - m_hud->getTextBounds(m_healthText).height * 3);
+
+	//Gun display, scaled to twice the texture size once
+	m_gun = HudCompositor::rasterize(*ResourceCache::get().getImage(g_gunSprite), g_textureWidth * 2, g_textureHeight * 2, sf::Color::Black);
+	m_gunFire = HudCompositor::rasterize(*ResourceCache::get().getImage(g_gunSprite_fire), g_textureWidth * 2, g_textureHeight * 2, sf::Color::Black);
+	m_gunPosition = sf::Vector2f(float(w / 2 - g_textureWidth), float(h - g_textureHeight * 2 + 30));
 
 	//crosshair
-	m_crosshair.setRadius(2.0f);
-	m_crosshair.setPosition({ float(w / 2) - 1.0f, float(h / 2) - 1.0f });
-	m_crosshair.setFillColor(sf::Color::White);
+	m_crosshair = HudCompositor::rasterizeCircle(2.0f, sf::Color::White);
+	m_crosshairPosition = sf::Vector2f(float(w / 2) - 1.0f, float(h / 2) - 1.0f);
 
+	//levels larger than the window scroll with the player
+	m_minimap = std::make_unique<Minimap>(sf::Vector2f(float(std::min(g_playMinimapWidth, w)), float(std::min(g_playMinimapHeight, h))), g_playMinimapScale);
 	generateMinimap();
 }
 
+PlayState::~PlayState()
+{
+	//Game destroys play states while the window and its context are still open
+	m_glRaycaster->cleanup();
+}
+
 void PlayState::update(const float ft)
 {
 	double fts = static_cast<double>(ft / 1000.0f);
@@ -78,149 +77,187 @@ void PlayState::update(const float ft)
 		outline.setDestructible(false);
 	}
 
-	//update health each frame
-	m_playerHealthDisplay.setString("+ " + std::to_string(m_player->m_health));
+	//the world is frozen until a pending level is swapped in
+	if (m_levelReader->isLoading())
+	{
+		m_loadingBar.setProgress(m_levelReader->getLoadProgress());
+		m_previousPose = *m_player;
+		return;
+	}
+
+	//update health only when it changes
+	if (m_displayedHealth != m_player->m_health)
+	{
+		m_displayedHealth = m_player->m_health;
+		m_hud->setText(m_healthText, "+ " + std::to_string(m_displayedHealth));
+	}
 
 	//update player movement
+	m_previousPose = *m_player;
 	m_inputManager->updatePlayerMovement(fts, m_player, m_levelReader->getLevel());
 
-	//update player position on minimap
-	float angle = std::atan2f(float(m_player->m_dirX), float(m_player->m_dirY));
-	m_minimapPlayer.setPosition(float(m_player->m_posY) * g_playMinimapScale, float(m_player->m_posX) * g_playMinimapScale);
-	m_minimapPlayer.setRotation((angle * 57.2957795f) + 90);
+	//page in the level ahead of the player, nothing reads tiles between frames
+	if (auto chunks = m_levelReader->getLevel().getChunkStore())
+	{
+		chunks->prefetch(m_player->m_posX, m_player->m_posY, m_player->m_dirX, m_player->m_dirY, g_levelPrefetchDistance);
+		chunks->trim();
+	}
 
 	//wobble gun
 	if (m_inputManager->isMoving())
 	{
 		auto wobbleSpeed = fts * 10.0f;
-		auto newGunPos = m_gunDisplay.getPosition();
 		float DeltaHeight = static_cast<float>(sin(m_runningTime + wobbleSpeed) - sin(m_runningTime));
-		newGunPos.y += DeltaHeight * 15.0f;
+		m_gunPosition.y += DeltaHeight * 15.0f;
 		m_runningTime += wobbleSpeed;
-		m_gunDisplay.setPosition(newGunPos);
 	}
 
 	//reset gun texture
 	if (!m_inputManager->isShooting())
 	{
-		m_gunDisplay.setTexture(&m_textureGun);
+		m_gunFiring = false;
 	}
 
 }
 
-void PlayState::draw(sf::RenderWindow& window)
+void PlayState::interpolate(const float alpha)
 {
-	m_glRaycaster->draw();
-
-	window.pushGLStates();
+	const double a = alpha;
+	const double b = 1.0 - a;
 
-	//draw minimap
-	drawMinimap(window);
+	m_renderPose->m_posX = m_previousPose.m_posX * b + m_player->m_posX * a;
+	m_renderPose->m_posY = m_previousPose.m_posY * b + m_player->m_posY * a;
 
-	//draw Gui elements
-	drawGui(window);
+	//blend the camera vectors and restore their length
+	double dirX = m_previousPose.m_dirX * b + m_player->m_dirX * a;
+	double dirY = m_previousPose.m_dirY * b + m_player->m_dirY * a;
+	double planeX = m_previousPose.m_planeX * b + m_player->m_planeX * a;
+	double planeY = m_previousPose.m_planeY * b + m_player->m_planeY * a;
 
-	window.popGLStates();
+	const double dirLength = std::sqrt(dirX * dirX + dirY * dirY);
+	const double planeLength = std::sqrt(planeX * planeX + planeY * planeY);
+	if (dirLength > 0.0 && planeLength > 0.0)
+	{
+		const double dirScale = std::sqrt(m_player->m_dirX * m_player->m_dirX + m_player->m_dirY * m_player->m_dirY) / dirLength;
+		const double planeScale = std::sqrt(m_player->m_planeX * m_player->m_planeX + m_player->m_planeY * m_player->m_planeY) / planeLength;
+		dirX *= dirScale;
+		dirY *= dirScale;
+		planeX *= planeScale;
+		planeY *= planeScale;
+	}
+	else
+	{
+		dirX = m_player->m_dirX;
+		dirY = m_player->m_dirY;
+		planeX = m_player->m_planeX;
+		planeY = m_player->m_planeY;
+	}
 
-	m_glRaycaster->bindGlBuffers();
+	m_renderPose->m_dirX = dirX;
+	m_renderPose->m_dirY = dirY;
+	m_renderPose->m_planeX = planeX;
+	m_renderPose->m_planeY = planeY;
+	m_renderPose->m_health = m_player->m_health;
 
-	window.display();
+	//update player position on minimap
+	float angle = std::atan2f(float(m_renderPose->m_dirX), float(m_renderPose->m_dirY));
+	m_minimap->setPlayer(m_renderPose->m_posX, m_renderPose->m_posY, (angle * 57.2957795f) + 90);
 }
 
-void PlayState::generateMinimap()
+void PlayState::draw(sf::RenderWindow& window)
 {
-	// Minimap player arrow
-	// resize it to 5 points
-	m_minimapPlayer.setPointCount(7);
-
-	// define the points
-	m_minimapPlayer.setPoint(0, sf::Vector2f(0, 0));
-	m_minimapPlayer.setPoint(1, sf::Vector2f(10, 10));
-	m_minimapPlayer.setPoint(2, sf::Vector2f(5, 10));
-	m_minimapPlayer.setPoint(3, sf::Vector2f(5, 15));
-	m_minimapPlayer.setPoint(4, sf::Vector2f(-5, 15));
-	m_minimapPlayer.setPoint(5, sf::Vector2f(-5, 10));
-	m_minimapPlayer.setPoint(6, sf::Vector2f(-10, 10));
-
-	m_minimapPlayer.setFillColor(sf::Color(255, 255, 255, g_playMinimapTransparency));
-
-	auto levelSize = m_levelReader->getLevel().size();
-
-	//Minimap background
-	m_minimapBackground.setSize(sf::Vector2f(levelSize * g_playMinimapScale, levelSize * g_playMinimapScale));
-	m_minimapBackground.setPosition(0, 0);
-	m_minimapBackground.setFillColor(sf::Color(150, 150, 150, g_playMinimapTransparency));
-
-	// Minimap walls
-	for (size_t y = 0; y < levelSize; y++)
+	m_glRaycaster->render();
+
+	//minimap and Gui elements are blended into the frame, it is drawn with one upload
+	auto& buffer = m_glRaycaster->getBuffer();
+	m_hud->begin(buffer.data(), m_glRaycaster->getWidth(), m_glRaycaster->getHeight());
+	m_minimap->updatePagedWalls(m_levelReader->getLevel());
+	m_minimap->composite(*m_hud);
+	drawGui();
+
+	m_glRaycaster->draw();
+
+	//the loading bar is the only SFML drawing left, the raycaster's GL state is released around it
+	if (m_levelReader->isLoading())
 	{
-		for (size_t x = 0; x < levelSize; x++)
-		{
-			if (m_levelReader->getLevel()[y][x] > 0 && m_levelReader->getLevel()[y][x] < 9)
-			{
-				sf::RectangleShape wall(sf::Vector2f(g_playMinimapScale, g_playMinimapScale));
-				wall.setPosition(x * g_playMinimapScale, y * g_playMinimapScale);
-				wall.setFillColor(sf::Color(0, 0, 0, g_playMinimapTransparency));
-				m_minimapWallBuffer.push_back(wall);
-			}
-		}
+		m_glRaycaster->unbindGlBuffers();
+		window.pushGLStates();
+		window.draw(m_loadingBar);
+		window.popGLStates();
+		m_glRaycaster->bindGlBuffers();
 	}
 
-	updateMinimapEntities();
+	window.display();
 }
 
-void PlayState::updateMinimapEntities()
+void PlayState::onLevelLoaded()
 {
-	// Clear
-	std::vector<sf::CircleShape>().swap(m_minimapEntityBuffer);
+	m_spriteSize = m_levelReader->getSprites().size();
+	m_previousPose = *m_player;
+	*m_renderPose = *m_player;
+
+	generateMinimap();
+}
 
-	// Entities on minimap
-	auto spriteSize = m_levelReader->getSprites().size();
-	for (size_t i = 0; i < spriteSize; i++)
+void PlayState::onShadersChanged(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	m_glRaycaster->reloadShaders(vertexSource, fragmentSource);
+
+	//reloading binds the program, the running state draws with SFML
+	if (m_suspended)
 	{
-		auto sprite = m_levelReader->getSprites()[i];
-		sf::CircleShape object(g_playMinimapScale / 4.0f);
-		object.setPosition(
-			float(sprite.y) * g_playMinimapScale,
-			float(sprite.x) * g_playMinimapScale);
-		object.setOrigin(g_playMinimapScale / 2.0f, g_playMinimapScale / 2.0f);
-		object.setFillColor(sf::Color(0, 0, 255, g_playMinimapTransparency));
-		m_minimapEntityBuffer.push_back(object);
+		m_glRaycaster->unbindGlBuffers();
 	}
 }
 
-//Render minimap
-void PlayState::drawMinimap(sf::RenderWindow& window) const
+void PlayState::onSuspend()
 {
+	//the GL objects stay alive, only the bindings are released for the other state
+	m_glRaycaster->unbindGlBuffers();
+	m_suspended = true;
+}
 
-	//minimap background
-	window.draw(m_minimapBackground);
+void PlayState::onResume()
+{
+	m_suspended = false;
+	m_glRaycaster->bindGlBuffers();
+
+	//keys held when leaving would keep the player moving
+	m_inputManager = std::make_unique<PlayerInputManager>();
+	m_gunFiring = false;
 
-	//draw walls
-	for (auto wall : m_minimapWallBuffer)
+	//the editor or a restart may have changed the level meanwhile
+	if (m_levelReader->getRevision() != m_levelRevision)
 	{
-		window.draw(wall);
+		onLevelLoaded();
 	}
-
-	//draw entities
-	for (auto entity : m_minimapEntityBuffer)
+	else
 	{
-		window.draw(entity);
+		m_previousPose = *m_player;
+		*m_renderPose = *m_player;
 	}
+}
+
+void PlayState::generateMinimap()
+{
+	m_levelRevision = m_levelReader->getRevision();
 
-	// Render Player on minimap
-	window.draw(m_minimapPlayer);
+	m_minimap->rebuild(m_levelReader->getLevel());
+	m_minimap->updateEntities(m_levelReader->getSprites());
 }
 
-void PlayState::drawGui(sf::RenderWindow& window)
+void PlayState::drawGui()
 {
 
 	//draw hud clickable items
 	for (auto& outline : m_glRaycaster->getClickables())
 	{
-		if (outline.containsVector(m_crosshair.getPosition()))
+		if (outline.containsVector(m_crosshairPosition))
 		{
-			outline.draw(window);
+			if (outline.isVisible())
+			{
+				m_hud->blendOutline(outline.getBounds(), 1, sf::Color::White);
+			}
 			break;
 		}
 	}
@@ -230,28 +267,32 @@ void PlayState::drawGui(sf::RenderWindow& window)
 	}
 
 	//draw gun
-	window.draw(m_gunDisplay);
+	m_hud->blend(m_gunFiring ? m_gunFire : m_gun, int(std::floor(m_gunPosition.x)), int(std::floor(m_gunPosition.y)));
 
 	//draw fps display
-	window.draw(m_fpsDisplay);
+	const auto fpsBounds = m_hud->getTextBounds(m_fpsText);
+	m_hud->blendText(m_fpsText, m_fpsPosition.x - fpsBounds.left - fpsBounds.width, m_fpsPosition.y);
 
 	//draw player health
-	window.draw(m_playerHealthDisplay);
+	m_hud->blendText(m_healthText, m_healthPosition.x, m_healthPosition.y);
 
 	//draw crosshair
-	window.draw(m_crosshair);
+	m_hud->blend(m_crosshair, int(m_crosshairPosition.x), int(m_crosshairPosition.y));
 }
 
 void PlayState::handleInput(const sf::Event & event, const sf::Vector2f& mousePosition, Game & game)
 {
 	//update fps from game
-	m_fpsDisplay.setString(std::to_string(game.getFps()));
-	m_fpsDisplay.setOrigin(m_fpsDisplay.getGlobalBounds().width, 0.0f);
+	//the text is only rasterized again when the value changed
+	if (m_displayedFps != game.getFps())
+	{
+		m_displayedFps = game.getFps();
+		m_hud->setText(m_fpsText, std::to_string(m_displayedFps));
+	}
 
-	//escape to quit to main menu
+	//escape to quit to main menu, Game keeps this state suspended
 	if (event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::Escape)
 	{
-		m_glRaycaster->cleanup();
 		game.changeState(GameStateName::MAINMENU);
 		return;
 	}
@@ -262,7 +303,7 @@ void PlayState::handleInput(const sf::Event & event, const sf::Vector2f& mousePo
 	//im shooting
 	if (m_inputManager->isShooting())
 	{
-		m_gunDisplay.setTexture(&m_textureGun_fire);
+		m_gunFiring = true;
 
 		destroyAimedAtSprite();
 	}
@@ -274,7 +315,7 @@ void PlayState::destroyAimedAtSprite()
 
 	for (size_t i = 0; i < clickables.size(); i++)
 	{
-		if (clickables[i].getDestructible() && clickables[i].containsVector(m_crosshair.getPosition()))
+		if (clickables[i].getDestructible() && clickables[i].containsVector(m_crosshairPosition))
 		{
 			clickables[i].setDestructible(false);
 			clickables[i].setVisible(false);
@@ -282,6 +323,10 @@ void PlayState::destroyAimedAtSprite()
 			{
 				m_levelReader->deleteSprite(clickables[i].getSpriteIndex());
 				clickables[i].setSpriteIndex(-1);
+
+				//only the entities changed, the walls of the minimap stay
+				m_minimap->updateEntities(m_levelReader->getSprites());
+				m_levelRevision = m_levelReader->getRevision();
 			}
 			return;
 		}
@@ -295,7 +340,7 @@ void PlayState::moveAimedAtSprite(const double fts)
 
 	for (size_t i = 0; i < clickables.size(); i++)
 	{
-		if (clickables[i].getDestructible() && clickables[i].containsVector(m_crosshair.getPosition()))
+		if (clickables[i].getDestructible() && clickables[i].containsVector(m_crosshairPosition))
 		{
 			if (clickables[i].getSpriteIndex() != -1)
 			{
@@ -3,53 +3,71 @@
 #include <memory>
 
 #include "GameState.h"
+#include "HudCompositor.h"
+#include "Player.h"
+#include "ProgressBar.h"
 
-struct Player;
 class PlayerInputManager;
 class GLRaycaster;
 class LevelReaderWriter;
+class Minimap;
 
 class PlayState : public GameState
 {
 public:
 	PlayState(const int w, const int h, std::shared_ptr<Player> player, std::shared_ptr<LevelReaderWriter> levelReader);
-	virtual ~PlayState() = default;
+	virtual ~PlayState();
 
 	void update(const float ft) override;
+	void interpolate(const float alpha) override;
+	void onLevelLoaded() override;
+	void onShadersChanged(const std::string& vertexSource, const std::string& fragmentSource) override;
+	bool canSuspend() const override { return true; }
+	void onSuspend() override;
+	void onResume() override;
 	void draw(sf::RenderWindow& window) override;
 	void handleInput(const sf::Event& event, const sf::Vector2f& mousePosition, Game& game) override;
 
 private:
 
-	size_t m_levelSize;
 	size_t m_spriteSize;
 
 	std::shared_ptr<Player> m_player;
 	std::shared_ptr<LevelReaderWriter> m_levelReader;
+	std::shared_ptr<const sf::Font> m_font;
+
+	//player pose before the last simulation step and the interpolated pose used for rendering
+	Player m_previousPose;
+	std::shared_ptr<Player> m_renderPose;
 
 	std::unique_ptr<PlayerInputManager> m_inputManager;
 	std::unique_ptr<GLRaycaster> m_glRaycaster;
 
 	double m_runningTime = 0.0;
+	bool m_suspended = false;
+	//revision of the level the minimap and the sprite count were built from
+	unsigned int m_levelRevision = 0;
+	int m_displayedHealth = -1;
+
+	//Gui, blended into the raycaster's frame
+	std::unique_ptr<HudCompositor> m_hud;
+	int m_fpsText;
+	int m_healthText;
+	int m_displayedFps = -1;
+	sf::Vector2i m_fpsPosition;
+	sf::Vector2i m_healthPosition;
+	HudCompositor::Layer m_gun;
+	HudCompositor::Layer m_gunFire;
+	bool m_gunFiring = false;
+	sf::Vector2f m_gunPosition;
+	HudCompositor::Layer m_crosshair;
+	sf::Vector2f m_crosshairPosition;
+	ProgressBar m_loadingBar;
 
-	//Gui	
-	sf::Text m_fpsDisplay;
-	sf::Text m_playerHealthDisplay;
-	sf::RectangleShape m_gunDisplay;
-	sf::CircleShape m_crosshair;
-	sf::Texture m_textureGun;
-	sf::Texture m_textureGun_fire;
-
-	//Minimap
-	std::vector<sf::RectangleShape> m_minimapWallBuffer;
-	std::vector<sf::CircleShape> m_minimapEntityBuffer;
-	sf::RectangleShape m_minimapBackground;
-	sf::ConvexShape m_minimapPlayer;
+	std::unique_ptr<Minimap> m_minimap;
 	
 	void generateMinimap();
-	void updateMinimapEntities();
-	void drawMinimap(sf::RenderWindow& window) const;
-	void drawGui(sf::RenderWindow& window);
+	void drawGui();
 
 	void destroyAimedAtSprite();
 	void moveAimedAtSprite(const double fts);
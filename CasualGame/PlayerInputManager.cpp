@@ -2,6 +2,7 @@
 
 #include "Game.h"
 #include "Player.h"
+#include "TileMap.h"
 #include "Config.h"
 
 #include <cmath>
@@ -70,7 +71,7 @@ void PlayerInputManager::handleInput(const sf::Event& event, const sf::Vector2f&
 	}
 }
 
-void PlayerInputManager::updatePlayerMovement(const double fts, std::shared_ptr<Player> m_player, const std::vector<std::vector<int> >& m_levelRef)
+void PlayerInputManager::updatePlayerMovement(const double fts, std::shared_ptr<Player> m_player, const TileMap& m_levelRef)
 {
 	calculateShotTime(fts);
 
@@ -103,16 +104,16 @@ void PlayerInputManager::updatePlayerMovement(const double fts, std::shared_ptr<
 		}
 		if (m_forward)
 		{
-			if (m_levelRef[int(m_player->m_posX + m_player->m_dirX * moveSpeed)][int(m_player->m_posY)] == 0)
+			if (m_levelRef.get(int(m_player->m_posX + m_player->m_dirX * moveSpeed), int(m_player->m_posY)) == 0)
 				m_player->m_posX += m_player->m_dirX * moveSpeed;
-			if (m_levelRef[int(m_player->m_posX)][int(m_player->m_posY + m_player->m_dirY * moveSpeed)] == 0)
+			if (m_levelRef.get(int(m_player->m_posX), int(m_player->m_posY + m_player->m_dirY * moveSpeed)) == 0)
 				m_player->m_posY += m_player->m_dirY * moveSpeed;
 		}
 		if (m_backward)
 		{
-			if (m_levelRef[int(m_player->m_posX - m_player->m_dirX * moveSpeed)][int(m_player->m_posY)] == 0)
+			if (m_levelRef.get(int(m_player->m_posX - m_player->m_dirX * moveSpeed), int(m_player->m_posY)) == 0)
 				m_player->m_posX -= m_player->m_dirX * moveSpeed;
-			if (m_levelRef[int(m_player->m_posX)][int(m_player->m_posY - m_player->m_dirY * moveSpeed)] == 0)
+			if (m_levelRef.get(int(m_player->m_posX), int(m_player->m_posY - m_player->m_dirY * moveSpeed)) == 0)
 				m_player->m_posY -= m_player->m_dirY * moveSpeed;
 		}
 		if (m_stepLeft)
@@ -121,9 +122,9 @@ void PlayerInputManager::updatePlayerMovement(const double fts, std::shared_ptr<
 			auto dirX = -m_player->m_dirY;
 			auto dirY = m_player->m_dirX;
 
-			if (m_levelRef[int(m_player->m_posX + dirX * moveSpeed)][int(m_player->m_posY)] == 0)
+			if (m_levelRef.get(int(m_player->m_posX + dirX * moveSpeed), int(m_player->m_posY)) == 0)
 				m_player->m_posX += dirX * moveSpeed;
-			if (m_levelRef[int(m_player->m_posX)][int(m_player->m_posY + dirY * moveSpeed)] == 0)
+			if (m_levelRef.get(int(m_player->m_posX), int(m_player->m_posY + dirY * moveSpeed)) == 0)
 				m_player->m_posY += dirY * moveSpeed;
 		}
 		if (m_stepRight)
@@ -132,9 +133,9 @@ void PlayerInputManager::updatePlayerMovement(const double fts, std::shared_ptr<
 			auto dirX = m_player->m_dirY;
 			auto dirY = -m_player->m_dirX;
 
-			if (m_levelRef[int(m_player->m_posX + dirX * moveSpeed)][int(m_player->m_posY)] == 0)
+			if (m_levelRef.get(int(m_player->m_posX + dirX * moveSpeed), int(m_player->m_posY)) == 0)
 				m_player->m_posX += dirX * moveSpeed;
-			if (m_levelRef[int(m_player->m_posX)][int(m_player->m_posY + dirY * moveSpeed)] == 0)
+			if (m_levelRef.get(int(m_player->m_posX), int(m_player->m_posY + dirY * moveSpeed)) == 0)
 				m_player->m_posY += dirY * moveSpeed;
 		}
 
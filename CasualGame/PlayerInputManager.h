@@ -4,6 +4,7 @@
 #include <memory>
 
 class Game;
+class TileMap;
 struct Player;
 
 class PlayerInputManager
@@ -13,7 +14,7 @@ public:
 	virtual ~PlayerInputManager() = default;
 
 	void handleInput(const sf::Event& event, const sf::Vector2f& mousePosition, Game& game);
-	void updatePlayerMovement(const double fts, std::shared_ptr<Player> m_player, const std::vector<std::vector<int> >& m_levelRef);
+	void updatePlayerMovement(const double fts, std::shared_ptr<Player> m_player, const TileMap& m_levelRef);
 
 	bool isShooting() const { return m_shooting; };
 	bool isMoving() const { return m_forward || m_backward || m_left || m_right || m_stepLeft || m_stepRight; }
@@ -0,0 +1,39 @@
+#include "ProgressBar.h"
+
+#include "ResourceCache.h"
+#include "Config.h"
+
+#include <algorithm>
+
+ProgressBar::ProgressBar(const sf::Vector2f& position, const sf::Vector2f& size, const std::string& label) :
+	m_size(size),
+	m_font(ResourceCache::get().getFont(g_fontFile))
+{
+	m_background.setPosition(position);
+	m_background.setSize(size);
+	m_background.setFillColor(sf::Color(0, 0, 0, 160));
+	m_background.setOutlineThickness(2.0f);
+	m_background.setOutlineColor(sf::Color::White);
+
+	m_fill.setPosition(position);
+	m_fill.setSize(sf::Vector2f(0.0f, size.y));
+	m_fill.setFillColor(sf::Color(255, 255, 255, 200));
+
+	m_label.setFont(*m_font);
+	m_label.setString(label);
+	m_label.setCharacterSize(24);
+	m_label.setFillColor(sf::Color::White);
+	m_label.setPosition(position.x, position.y - m_label.getGlobalBounds().height * 2.0f);
+}
+
+void ProgressBar::setProgress(const float progress)
+{
+	m_fill.setSize(sf::Vector2f(m_size.x * std::min(std::max(progress, 0.0f), 1.0f), m_size.y));
+}
+
+void ProgressBar::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	target.draw(m_background, states);
+	target.draw(m_fill, states);
+	target.draw(m_label, states);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+
+// Labeled bar showing the progress of a background task
+class ProgressBar : public sf::Drawable
+{
+public:
+	ProgressBar(const sf::Vector2f& position, const sf::Vector2f& size, const std::string& label);
+	virtual ~ProgressBar() = default;
+
+	// fraction between 0 and 1
+	void setProgress(const float progress);
+
+private:
+	sf::RectangleShape m_background;
+	sf::RectangleShape m_fill;
+	sf::Text m_label;
+	sf::Vector2f m_size;
+	std::shared_ptr<const sf::Font> m_font;
+
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
@@ -6,6 +6,8 @@ class RandomGenerator
 {
 public:
 	RandomGenerator() = default;
+	// fixed seed, produces the same sequence on every run
+	explicit RandomGenerator(const unsigned int seed) : gen(seed) {}
 	virtual ~RandomGenerator(void) = default;
 
 	bool randomChance(float chance);
@@ -0,0 +1,293 @@
+#include "RenderVerifier.h"
+
+#include "GLRaycaster.h"
+#include "LevelReaderWriter.h"
+#include "Player.h"
+#include "Sprite.h"
+#include "Utils.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::tr2::sys;
+
+namespace
+{
+	bool endsWith(const std::string& text, const std::string& suffix)
+	{
+		return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	//the levels directories also hold the sprite lists of the shipped levels, the catalog and unfinished saves
+	bool isLevelFile(const std::string& path)
+	{
+		return endsWith(path, ".txt") && !endsWith(path, "_sprites.txt") && path != g_levelCatalogFile && !Utils::isTemporaryFile(path);
+	}
+}
+
+RenderVerifier::RenderVerifier(const std::string& referenceDirectory, const std::string& outputDirectory) :
+	m_referenceDirectory(referenceDirectory),
+	m_outputDirectory(outputDirectory)
+{
+	m_levelReader = std::make_shared<LevelReaderWriter>();
+	m_player = std::make_shared<Player>();
+}
+
+bool RenderVerifier::run()
+{
+	m_passed = 0;
+	m_failed = 0;
+	m_missing = 0;
+
+	fs::create_directories(fs::path(m_referenceDirectory));
+	fs::create_directories(fs::path(m_outputDirectory));
+
+	for (auto& path : getLevelFiles())
+	{
+		auto name = fs::path(path).stem().string();
+		if (path.find(g_customLevelDirectory) != std::string::npos)
+		{
+			name = "custom_" + name;
+		}
+		verifyLevel(path, name);
+	}
+
+	//a run that compared nothing proves nothing
+	if (m_passed + m_failed == 0)
+	{
+		std::cout << "FAIL no level was rendered" << std::endl;
+		m_failed++;
+	}
+
+	std::cout << "Render verification: " << m_passed << " passed, " << m_failed << " failed" << std::endl;
+	if (m_missing > 0)
+	{
+		std::cout << m_missing << " of the failed frames have no reference image in " << m_referenceDirectory
+			<< ", run with --generate-render-references on a known good build to create them" << std::endl;
+	}
+	return m_failed == 0;
+}
+
+std::vector<std::string> RenderVerifier::getLevelFiles() const
+{
+	std::vector<std::string> files;
+
+	for (auto& directory : { std::string(g_levelDirectory), std::string(g_customLevelDirectory) })
+	{
+		auto dpath = fs::path(directory);
+		if (!fs::is_directory(dpath)) continue;
+
+		for (auto it = fs::directory_iterator(dpath); it != fs::directory_iterator(); ++it)
+		{
+			const auto path = directory + it->path().filename().string();
+			if (!fs::is_directory(it->path()) && isLevelFile(path))
+			{
+				files.push_back(path);
+			}
+		}
+	}
+
+	//directory order is not guaranteed
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+std::vector<RenderVerifier::Pose> RenderVerifier::getPoses() const
+{
+	std::vector<Pose> poses;
+	auto& level = m_levelReader->getLevel();
+
+	//collect the inner empty tiles
+	std::vector<std::pair<int, int> > emptyTiles;
+	for (int x = 1; x + 1 < level.getSizeX(); x++)
+	{
+		for (int y = 1; y + 1 < level.getSizeY(); y++)
+		{
+			if (level.get(x, y) == 0)
+			{
+				emptyTiles.emplace_back(x, y);
+			}
+		}
+	}
+
+	if (emptyTiles.empty())
+	{
+		return poses;
+	}
+
+	//three spread out positions, four headings each
+	for (auto fraction : { 0.25, 0.5, 0.75 })
+	{
+		auto& tile = emptyTiles[static_cast<size_t>(fraction * (emptyTiles.size() - 1))];
+		for (auto angle : { 0.0, 1.6, 3.2, 4.8 })
+		{
+			poses.push_back({ tile.first + 0.5, tile.second + 0.5, angle });
+		}
+	}
+
+	return poses;
+}
+
+void RenderVerifier::setPose(const Pose& pose) const
+{
+	//rotate the default camera
+	const double cosA = std::cos(pose.angle);
+	const double sinA = std::sin(pose.angle);
+
+	m_player->m_posX = pose.posX;
+	m_player->m_posY = pose.posY;
+	m_player->m_dirX = -1.0 * cosA;
+	m_player->m_dirY = -1.0 * sinA;
+	m_player->m_planeX = -0.66 * sinA;
+	m_player->m_planeY = 0.66 * cosA;
+}
+
+std::vector<unsigned char> RenderVerifier::renderFrame(const int threadCount) const
+{
+	GLRaycaster raycaster;
+	raycaster.initialize(g_renderVerifyWidth, g_renderVerifyHeight, m_player, m_levelReader, true);
+	raycaster.setThreadCount(threadCount);
+	raycaster.render();
+	return raycaster.getBuffer();
+}
+
+void RenderVerifier::verifyLevel(const std::string& path, const std::string& name)
+{
+	TileMap level;
+	std::vector<Sprite> sprites;
+	if (!LevelReaderWriter::readLevelFile(path, level, sprites) || level.empty())
+	{
+		std::cout << "FAIL " << name << ": the level could not be loaded" << std::endl;
+		m_failed++;
+		return;
+	}
+	m_levelReader->setLevel(std::move(level), std::move(sprites), path);
+
+	const int maxThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 4);
+
+	auto poses = getPoses();
+	if (poses.empty())
+	{
+		std::cout << "FAIL " << name << ": the level has no empty tile to render from" << std::endl;
+		m_failed++;
+		return;
+	}
+
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		setPose(poses[i]);
+
+		const auto imageName = name + "_" + std::to_string(i);
+		const auto frame = renderFrame(1);
+
+		//the multithreaded renderer has to produce the same frame
+		auto deterministic = true;
+		for (int threads = 2; threads <= maxThreads; threads *= 2)
+		{
+			if (renderFrame(threads) != frame)
+			{
+				std::cout << "FAIL " << imageName << ": output differs with " << threads << " threads" << std::endl;
+				deterministic = false;
+			}
+		}
+
+		if (m_updateReferences)
+		{
+			toImage(frame).saveToFile(m_referenceDirectory + imageName + ".png");
+		}
+
+		if (deterministic && (m_updateReferences || compareWithReference(frame, imageName)))
+		{
+			m_passed++;
+		}
+		else
+		{
+			m_failed++;
+		}
+	}
+}
+
+bool RenderVerifier::compareWithReference(const std::vector<unsigned char>& frame, const std::string& imageName)
+{
+	sf::Image reference;
+	if (!fs::exists(fs::path(m_referenceDirectory + imageName + ".png")))
+	{
+		std::cout << "FAIL " << imageName << ": missing reference image" << std::endl;
+		m_missing++;
+		toImage(frame).saveToFile(m_outputDirectory + imageName + "_actual.png");
+		return false;
+	}
+	if (!reference.loadFromFile(m_referenceDirectory + imageName + ".png"))
+	{
+		std::cout << "FAIL " << imageName << ": unreadable reference image" << std::endl;
+		toImage(frame).saveToFile(m_outputDirectory + imageName + "_actual.png");
+		return false;
+	}
+
+	if (reference.getSize().x != unsigned(g_renderVerifyWidth) || reference.getSize().y != unsigned(g_renderVerifyHeight))
+	{
+		std::cout << "FAIL " << imageName << ": reference has a different size" << std::endl;
+		return false;
+	}
+
+	const sf::Uint8* referencePixels = reference.getPixelsPtr();
+	const size_t pixelCount = g_renderVerifyWidth * g_renderVerifyHeight;
+
+	//mismatching pixels are red on top of the darkened reference
+	sf::Image diff;
+	diff.create(g_renderVerifyWidth, g_renderVerifyHeight);
+
+	size_t mismatches = 0;
+	int maxDifference = 0;
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		int difference = 0;
+		for (size_t c = 0; c < 3; c++)
+		{
+			difference = std::max(difference, std::abs(int(frame[i * 3 + c]) - int(referencePixels[i * 4 + c])));
+		}
+		maxDifference = std::max(maxDifference, difference);
+
+		const unsigned x = unsigned(i % g_renderVerifyWidth);
+		const unsigned y = unsigned(i / g_renderVerifyWidth);
+		if (difference > m_tolerance)
+		{
+			mismatches++;
+			diff.setPixel(x, y, sf::Color::Red);
+		}
+		else
+		{
+			diff.setPixel(x, y, sf::Color(referencePixels[i * 4] / 4, referencePixels[i * 4 + 1] / 4, referencePixels[i * 4 + 2] / 4));
+		}
+	}
+
+	if (mismatches == 0)
+	{
+		return true;
+	}
+
+	std::cout << "FAIL " << imageName << ": " << mismatches << " pixels differ, max channel difference " << maxDifference << std::endl;
+	toImage(frame).saveToFile(m_outputDirectory + imageName + "_actual.png");
+	diff.saveToFile(m_outputDirectory + imageName + "_diff.png");
+	return false;
+}
+
+sf::Image RenderVerifier::toImage(const std::vector<unsigned char>& frame)
+{
+	std::vector<sf::Uint8> pixels(g_renderVerifyWidth * g_renderVerifyHeight * 4);
+	for (size_t i = 0; i < pixels.size() / 4; i++)
+	{
+		pixels[i * 4] = frame[i * 3];
+		pixels[i * 4 + 1] = frame[i * 3 + 1];
+		pixels[i * 4 + 2] = frame[i * 3 + 2];
+		pixels[i * 4 + 3] = 255;
+	}
+
+	sf::Image image;
+	image.create(g_renderVerifyWidth, g_renderVerifyHeight, &pixels[0]);
+	return image;
+}
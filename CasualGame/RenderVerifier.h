@@ -0,0 +1,60 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+class LevelReaderWriter;
+struct Player;
+
+// Renders fixed camera poses of every shipped level with the software raycaster,
+// without a window, and compares the frames against stored reference images.
+// Used to validate raycaster optimizations, run with --verify-render.
+// The reference images are not shipped, --generate-render-references writes them from a known good build.
+class RenderVerifier
+{
+public:
+	RenderVerifier(const std::string& referenceDirectory, const std::string& outputDirectory);
+	virtual ~RenderVerifier() = default;
+
+	// maximum allowed difference per color channel, 0 requires an exact match
+	void setTolerance(const int tolerance) { m_tolerance = tolerance; }
+
+	// writes the rendered frames as new reference images instead of comparing
+	void setUpdateReferences(const bool update) { m_updateReferences = update; }
+
+	// returns true when all frames match and multithreaded output is deterministic
+	bool run();
+
+private:
+
+	struct Pose
+	{
+		double posX;
+		double posY;
+		double angle;
+	};
+
+	std::string m_referenceDirectory;
+	std::string m_outputDirectory;
+	int m_tolerance = 0;
+	bool m_updateReferences = false;
+
+	int m_passed = 0;
+	int m_failed = 0;
+	int m_missing = 0;
+
+	std::shared_ptr<LevelReaderWriter> m_levelReader;
+	std::shared_ptr<Player> m_player;
+
+	std::vector<std::string> getLevelFiles() const;
+	std::vector<Pose> getPoses() const;
+	void setPose(const Pose& pose) const;
+
+	std::vector<unsigned char> renderFrame(const int threadCount) const;
+	void verifyLevel(const std::string& path, const std::string& name);
+	bool compareWithReference(const std::vector<unsigned char>& frame, const std::string& imageName);
+
+	static sf::Image toImage(const std::vector<unsigned char>& frame);
+};
@@ -0,0 +1,286 @@
+#include "ResourceCache.h"
+
+#include "ResourcePack.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	size_t fileSize(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+		return file.is_open() ? static_cast<size_t>(file.tellg()) : 0;
+	}
+
+	std::pair<std::shared_ptr<const sf::Font>, size_t> loadFont(const std::string& path)
+	{
+		auto font = std::make_shared<sf::Font>();
+		size_t size = 0;
+
+		//SFML reads the glyphs from the memory while drawing, the pack stays mapped until exit
+		const char* data;
+		if (ResourcePack::get().findFile(path, data, size))
+		{
+			font->loadFromMemory(data, size);
+		}
+		else
+		{
+			font->loadFromFile(path);
+			size = fileSize(path);
+		}
+		return std::make_pair(std::shared_ptr<const sf::Font>(std::move(font)), size);
+	}
+
+	std::pair<std::shared_ptr<const sf::Image>, size_t> loadImage(const std::string& path)
+	{
+		auto image = std::make_shared<sf::Image>();
+		ResourcePack::loadImage(path, *image);
+		const size_t size = size_t(image->getSize().x) * image->getSize().y * 4;
+		return std::make_pair(std::shared_ptr<const sf::Image>(std::move(image)), size);
+	}
+
+	template <typename Slots>
+	void waitForLoads(const Slots& slots)
+	{
+		for (auto& slot : slots)
+		{
+			slot.second.resource.wait();
+		}
+	}
+}
+
+ResourceCache& ResourceCache::get()
+{
+	static ResourceCache cache;
+	return cache;
+}
+
+template <typename T, typename Loader>
+std::shared_ptr<T> ResourceCache::acquire(std::map<std::string, Slot<T>>& slots, const std::string& key, const char* kind, const bool async, Loader load)
+{
+	std::shared_future<std::shared_ptr<T>> resource;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		auto it = slots.find(key);
+		if (it != slots.end())
+		{
+			if (!async)
+			{
+				it->second.stats.requests++;
+			}
+			resource = it->second.resource;
+		}
+		else
+		{
+			//map nodes do not move, the loader updates its slot after the lock was released
+			auto& slot = slots[key];
+			slot.stats.kind = kind;
+			slot.stats.requests = async ? 0 : 1;
+
+			auto stats = &slot.stats;
+			auto task = [this, stats, key, load]()
+			{
+				const auto start = Clock::now();
+
+				//waiters must not hang on a promise that is never set
+				std::pair<std::shared_ptr<T>, size_t> loaded;
+				try
+				{
+					loaded = load();
+				}
+				catch (const std::exception& e)
+				{
+					std::cout << "Could not load " << key << ": " << e.what() << std::endl;
+					loaded = std::make_pair(std::make_shared<typename std::remove_const<T>::type>(), size_t(0));
+				}
+
+				const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				stats->loads++;
+				stats->bytes = loaded.second;
+				stats->loadMs = ms;
+				return std::shared_ptr<T>(std::move(loaded.first));
+			};
+
+			if (async)
+			{
+				slot.resource = std::async(std::launch::async, task).share();
+				return nullptr;
+			}
+
+			//loaded on this thread, other threads asking meanwhile wait for the promise
+			std::promise<std::shared_ptr<T>> promise;
+			slot.resource = promise.get_future().share();
+			resource = slot.resource;
+
+			lock.unlock();
+			promise.set_value(task());
+		}
+	}
+
+	return async ? nullptr : resource.get();
+}
+
+std::shared_ptr<const sf::Font> ResourceCache::getFont(const std::string& path)
+{
+	return acquire(m_fonts, path, "font", false, [path]() { return loadFont(path); });
+}
+
+std::shared_ptr<const sf::Image> ResourceCache::getImage(const std::string& path)
+{
+	return acquire(m_images, path, "image", false, [path]() { return loadImage(path); });
+}
+
+std::shared_ptr<const sf::Texture> ResourceCache::getTexture(const std::string& path, const sf::Color& mask)
+{
+	std::string key = path;
+	if (mask != sf::Color::Transparent)
+	{
+		std::ostringstream suffix;
+		suffix << "#" << std::hex << std::setw(8) << std::setfill('0') << mask.toInteger();
+		key += suffix.str();
+	}
+
+	return acquire(m_textures, key, "texture", false, [this, path, mask]()
+	{
+		auto image = getImage(path);
+		auto texture = std::make_shared<sf::Texture>();
+
+		if (mask != sf::Color::Transparent)
+		{
+			sf::Image masked = *image;
+			masked.createMaskFromColor(mask);
+			texture->loadFromImage(masked);
+		}
+		else
+		{
+			texture->loadFromImage(*image);
+		}
+
+		const size_t size = size_t(texture->getSize().x) * texture->getSize().y * 4;
+		return std::make_pair(std::shared_ptr<const sf::Texture>(std::move(texture)), size);
+	});
+}
+
+std::shared_ptr<sf::Shader> ResourceCache::getShader(const std::string& path, const sf::Shader::Type type)
+{
+	return acquire(m_shaders, path, "shader", false, [path, type]()
+	{
+		auto shader = std::make_shared<sf::Shader>();
+		const auto source = ResourcePack::readText(path);
+		if (source.empty() || !shader->loadFromMemory(source, type))
+		{
+			std::cout << "An error occured while loading the following shader:" << path << std::endl;
+		}
+		return std::make_pair(std::move(shader), source.size());
+	});
+}
+
+template <typename T>
+void ResourceCache::evictSlots(std::map<std::string, Slot<T>>& slots)
+{
+	for (auto it = slots.begin(); it != slots.end();)
+	{
+		//loads still running write their slot when they finish
+		const auto& slot = it->second;
+		const bool unused = slot.stats.requests > 0 &&
+			slot.resource.wait_for(std::chrono::seconds(0)) == std::future_status::ready &&
+			slot.resource.get().use_count() == 1;
+		it = unused ? slots.erase(it) : std::next(it);
+	}
+}
+
+void ResourceCache::evictUnused()
+{
+	//resources are destroyed under the lock, none of them calls back into the cache
+	std::lock_guard<std::mutex> lock(m_mutex);
+	evictSlots(m_fonts);
+	evictSlots(m_images);
+	evictSlots(m_textures);
+	evictSlots(m_shaders);
+}
+
+void ResourceCache::clear()
+{
+	std::map<std::string, Slot<const sf::Font>> fonts;
+	std::map<std::string, Slot<const sf::Image>> images;
+	std::map<std::string, Slot<const sf::Texture>> textures;
+	std::map<std::string, Slot<sf::Shader>> shaders;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		fonts.swap(m_fonts);
+		images.swap(m_images);
+		textures.swap(m_textures);
+		shaders.swap(m_shaders);
+	}
+
+	//running loads take the lock to update their slot, they finish before the slots go away
+	waitForLoads(fonts);
+	waitForLoads(images);
+	waitForLoads(textures);
+	waitForLoads(shaders);
+}
+
+void ResourceCache::prefetchFont(const std::string& path)
+{
+	acquire(m_fonts, path, "font", true, [path]() { return loadFont(path); });
+}
+
+void ResourceCache::prefetchImage(const std::string& path)
+{
+	acquire(m_images, path, "image", true, [path]() { return loadImage(path); });
+}
+
+template <typename T>
+void ResourceCache::reportSlots(std::ostream& out, const std::map<std::string, Slot<T>>& slots, Stats& total) const
+{
+	for (auto& slot : slots)
+	{
+		const auto& stats = slot.second.stats;
+
+		//the cache holds one reference itself, prefetches still running have no users yet
+		long users = 0;
+		if (slot.second.resource.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			users = slot.second.resource.get().use_count() - 1;
+		}
+
+		out << std::left << std::setw(8) << stats.kind << std::right
+			<< std::setw(6) << stats.loads << std::setw(9) << stats.requests << std::setw(6) << users
+			<< std::setw(11) << stats.bytes << std::setw(9) << std::fixed << std::setprecision(1) << stats.loadMs
+			<< "  " << slot.first << std::endl;
+
+		total.loads += stats.loads;
+		total.requests += stats.requests;
+		total.bytes += stats.bytes;
+		total.loadMs += stats.loadMs;
+	}
+}
+
+void ResourceCache::report(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	out << "Resources:" << std::endl;
+	out << "kind     loads requests users      bytes  load ms  path" << std::endl;
+
+	Stats total;
+	reportSlots(out, m_fonts, total);
+	reportSlots(out, m_images, total);
+	reportSlots(out, m_textures, total);
+	reportSlots(out, m_shaders, total);
+
+	out << "total " << std::setw(8) << total.loads << std::setw(9) << total.requests << std::setw(6) << ""
+		<< std::setw(11) << total.bytes << std::setw(9) << std::fixed << std::setprecision(1) << total.loadMs << std::endl;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Shared fonts, images, textures and shaders of the game, each loaded once while anything uses it.
+// Callers keep the returned handle for as long as they use the resource, the cache releases
+// its own reference in evictUnused() once no caller holds one, which the game does when states or levels change.
+// Thread safe, a resource requested while it is loading on another thread is waited for.
+// A loader that fails leaves an empty resource, it is logged and never thrown to the caller.
+class ResourceCache
+{
+public:
+
+	static ResourceCache& get();
+
+	ResourceCache() = default;
+	virtual ~ResourceCache() = default;
+
+	ResourceCache(const ResourceCache&) = delete;
+	ResourceCache& operator=(const ResourceCache&) = delete;
+
+	std::shared_ptr<const sf::Font> getFont(const std::string& path);
+	std::shared_ptr<const sf::Image> getImage(const std::string& path);
+
+	// needs an active OpenGL context, pixels of the mask color become transparent
+	std::shared_ptr<const sf::Texture> getTexture(const std::string& path, const sf::Color& mask = sf::Color::Transparent);
+	std::shared_ptr<sf::Shader> getShader(const std::string& path, const sf::Shader::Type type);
+
+	// decodes on worker threads, textures created later from these images only upload
+	void prefetchFont(const std::string& path);
+	void prefetchImage(const std::string& path);
+
+	// drops the resources nobody else holds, prefetched ones are kept until they were requested once
+	void evictUnused();
+	// drops every resource, called before the OpenGL context goes away
+	void clear();
+
+	// loads, requests, users and bytes of every resource
+	void report(std::ostream& out) const;
+
+private:
+
+	struct Stats
+	{
+		std::string kind;
+		int loads = 0;
+		int requests = 0;
+		size_t bytes = 0;
+		double loadMs = 0.0;
+	};
+
+	template <typename T>
+	struct Slot
+	{
+		std::shared_future<std::shared_ptr<T>> resource;
+		Stats stats;
+	};
+
+	mutable std::mutex m_mutex;
+	std::map<std::string, Slot<const sf::Font>> m_fonts;
+	std::map<std::string, Slot<const sf::Image>> m_images;
+	std::map<std::string, Slot<const sf::Texture>> m_textures;
+	std::map<std::string, Slot<sf::Shader>> m_shaders;
+
+	template <typename T, typename Loader>
+	std::shared_ptr<T> acquire(std::map<std::string, Slot<T>>& slots, const std::string& key, const char* kind, const bool async, Loader load);
+
+	template <typename T>
+	void evictSlots(std::map<std::string, Slot<T>>& slots);
+
+	template <typename T>
+	void reportSlots(std::ostream& out, const std::map<std::string, Slot<T>>& slots, Stats& total) const;
+};
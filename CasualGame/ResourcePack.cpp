@@ -0,0 +1,296 @@
+#include "ResourcePack.h"
+
+#include "ResourcePackFormat.h"
+#include "LevelReaderWriter.h"
+#include "Utils.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace fs = std::tr2::sys;
+
+namespace
+{
+	const std::uint64_t payloadAlignment = 16;
+
+	void pad(std::ofstream& file, const std::uint64_t alignment)
+	{
+		static const char zeros[16] = {};
+		const auto position = static_cast<std::uint64_t>(file.tellp());
+		file.write(zeros, static_cast<std::streamsize>((alignment - position % alignment) % alignment));
+	}
+
+	bool startsWith(const std::string& path, const std::string& prefix)
+	{
+		return path.compare(0, prefix.size(), prefix) == 0;
+	}
+}
+
+const ResourcePack& ResourcePack::get()
+{
+	static ResourcePack pack;
+	static const bool opened = g_useResourcePack && pack.open(g_resourcePackFile);
+	(void)opened;
+	return pack;
+}
+
+bool ResourcePack::open(const std::string& path)
+{
+	m_index.clear();
+
+	//without a pack every asset is read from its loose file
+	if (!fs::exists(fs::path(path)) || !m_file.open(path))
+	{
+		return false;
+	}
+	m_modified = static_cast<long long>(fs::last_write_time(fs::path(path)).time_since_epoch().count());
+
+	const auto data = m_file.getData();
+	const auto size = static_cast<std::uint64_t>(m_file.getSize());
+
+	ResourcePackHeader header;
+	if (size < sizeof(header))
+	{
+		std::cout << "Resource pack is truncated: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+
+	if (std::memcmp(header.magic, g_resourcePackMagic, sizeof(header.magic)) != 0 || header.version != g_resourcePackVersion ||
+		header.entryOffset % alignof(ResourcePackEntry) != 0 || header.entryOffset > size ||
+		(size - header.entryOffset) / sizeof(ResourcePackEntry) < header.entryCount)
+	{
+		std::cout << "Unsupported resource pack: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	auto entries = reinterpret_cast<const ResourcePackEntry*>(data + header.entryOffset);
+	if (Utils::checksum(entries, header.entryCount * sizeof(ResourcePackEntry)) != header.checksum)
+	{
+		std::cout << "Resource pack is corrupt: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	for (std::uint32_t i = 0; i < header.entryCount; i++)
+	{
+		const auto& entry = entries[i];
+		const auto pixelBytes = std::uint64_t(entry.width) * entry.height * 4;
+		const bool valid = std::memchr(entry.path, '\0', sizeof(entry.path)) != nullptr &&
+			entry.offset <= size && entry.size <= size - entry.offset &&
+			(entry.type != ResourcePackType::IMAGE || entry.size == pixelBytes) &&
+			(entry.texelOffset == 0 || (entry.texelOffset % 4 == 0 && entry.texelOffset <= size && pixelBytes <= size - entry.texelOffset));
+		if (!valid)
+		{
+			std::cout << "Resource pack is corrupt: " << path << std::endl;
+			m_index.clear();
+			m_file.close();
+			return false;
+		}
+		m_index[entry.path] = &entry;
+	}
+
+	std::cout << "Resource pack " << path << ": " << m_index.size() << " entries" << std::endl;
+	return true;
+}
+
+bool ResourcePack::findFile(const std::string& path, const char*& data, size_t& size) const
+{
+	auto entry = find(path);
+	if (!entry)
+	{
+		return false;
+	}
+
+	data = reinterpret_cast<const char*>(m_file.getData() + entry->offset);
+	size = static_cast<size_t>(entry->size);
+	return true;
+}
+
+bool ResourcePack::findImage(const std::string& path, Image& image) const
+{
+	auto found = find(path);
+	if (!found || found->type != ResourcePackType::IMAGE)
+	{
+		return false;
+	}
+
+	const auto& entry = *found;
+	image.width = entry.width;
+	image.height = entry.height;
+	image.pixels = m_file.getData() + entry.offset;
+	image.texels = entry.texelOffset != 0 ? reinterpret_cast<const sf::Uint32*>(m_file.getData() + entry.texelOffset) : nullptr;
+	return true;
+}
+
+void ResourcePack::markChanged(const std::string& path) const
+{
+	if (m_index.find(path) != m_index.end())
+	{
+		std::lock_guard<std::mutex> lock(m_changedMutex);
+		m_changed.insert(path);
+	}
+}
+
+const ResourcePackEntry* ResourcePack::find(const std::string& path) const
+{
+	auto it = m_index.find(path);
+	if (it == m_index.end())
+	{
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(m_changedMutex);
+	if (m_changed.count(path) != 0)
+	{
+		return nullptr;
+	}
+
+	//a pack left over from an older build must not hide edited files, checked once per path
+	if (m_checked.insert(path).second && isLooseFileNewer(path))
+	{
+		std::cout << "Loose file is newer than the resource pack: " << path << std::endl;
+		m_changed.insert(path);
+		return nullptr;
+	}
+	return it->second;
+}
+
+bool ResourcePack::isLooseFileNewer(const std::string& path) const
+{
+	const fs::path loose(path);
+	return fs::exists(loose) && static_cast<long long>(fs::last_write_time(loose).time_since_epoch().count()) > m_modified;
+}
+
+bool ResourcePack::loadImage(const std::string& path, sf::Image& image)
+{
+	Image packed;
+	if (get().findImage(path, packed))
+	{
+		image.create(packed.width, packed.height, packed.pixels);
+		return true;
+	}
+	return image.loadFromFile(path);
+}
+
+std::string ResourcePack::readText(const std::string& path)
+{
+	const char* data;
+	size_t size;
+	if (get().findFile(path, data, size))
+	{
+		return std::string(data, size);
+	}
+	return Utils::readFile(path);
+}
+
+bool ResourcePack::build(const std::string& directory, const std::string& packPath)
+{
+	//user content and files the game writes stay loose
+	const std::string skipped[] = { g_customLevelDirectory, g_thumbnailDirectory, g_autosaveDirectory, g_levelCatalogFile, g_renderReferenceDirectory };
+
+	std::vector<std::string> paths;
+	for (auto it = fs::recursive_directory_iterator(fs::path(directory)); it != fs::recursive_directory_iterator(); ++it)
+	{
+		if (fs::is_directory(it->path()))
+		{
+			continue;
+		}
+
+		auto path = it->path().string();
+		std::replace(path.begin(), path.end(), '\\', '/');
+
+		//paged levels are read from their own file
+		const bool skip = LevelReaderWriter::isBinaryLevelFile(path) ||
+			std::any_of(std::begin(skipped), std::end(skipped), [&path](const std::string& prefix) { return startsWith(path, prefix); });
+		if (!skip)
+		{
+			paths.push_back(path);
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+
+	std::ofstream file(packPath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write resource pack: " << packPath << std::endl;
+		return false;
+	}
+
+	ResourcePackHeader header = {};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	std::vector<ResourcePackEntry> entries;
+	for (auto& path : paths)
+	{
+		ResourcePackEntry entry = {};
+		if (path.size() >= sizeof(entry.path))
+		{
+			std::cout << "Path too long for the resource pack, kept loose: " << path << std::endl;
+			continue;
+		}
+		std::memcpy(entry.path, path.c_str(), path.size());
+
+		pad(file, payloadAlignment);
+		entry.offset = static_cast<std::uint64_t>(file.tellp());
+
+		sf::Image image;
+		if (fs::path(path).extension().string() == ".png" && image.loadFromFile(path))
+		{
+			//decoded once here instead of on every start
+			entry.type = ResourcePackType::IMAGE;
+			entry.width = image.getSize().x;
+			entry.height = image.getSize().y;
+			entry.size = std::uint64_t(entry.width) * entry.height * 4;
+			file.write(reinterpret_cast<const char*>(image.getPixelsPtr()), static_cast<std::streamsize>(entry.size));
+
+			if (entry.width == unsigned(g_textureWidth) && entry.height == unsigned(g_textureHeight))
+			{
+				std::vector<sf::Uint32> texels;
+				LevelReaderWriter::toTexels(image, texels);
+
+				pad(file, payloadAlignment);
+				entry.texelOffset = static_cast<std::uint64_t>(file.tellp());
+				file.write(reinterpret_cast<const char*>(texels.data()), static_cast<std::streamsize>(texels.size() * sizeof(sf::Uint32)));
+			}
+		}
+		else
+		{
+			std::ifstream source(path, std::ios::in | std::ios::binary);
+			std::vector<char> bytes((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+			entry.type = ResourcePackType::FILE;
+			entry.size = bytes.size();
+			file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		}
+
+		entries.push_back(entry);
+	}
+
+	pad(file, payloadAlignment);
+	header.entryOffset = static_cast<std::uint64_t>(file.tellp());
+	file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(ResourcePackEntry)));
+
+	std::memcpy(header.magic, g_resourcePackMagic, sizeof(header.magic));
+	header.version = g_resourcePackVersion;
+	header.entryCount = static_cast<std::uint32_t>(entries.size());
+	header.checksum = Utils::checksum(entries.data(), entries.size() * sizeof(ResourcePackEntry));
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	if (!file.good())
+	{
+		std::cout << "Could not write resource pack: " << packPath << std::endl;
+		return false;
+	}
+
+	std::cout << "Packed " << entries.size() << " files into " << packPath << std::endl;
+	return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "MappedFile.h"
+
+struct ResourcePackEntry;
+
+// Memory mapped archive of the resources directory, built with --pack-resources.
+// Files are served straight from the mapping, images are stored already decoded.
+// Every loader falls back to the loose file when the pack or the entry is missing,
+// and a loose file edited after the pack was built is preferred over its entry.
+class ResourcePack
+{
+public:
+
+	struct Image
+	{
+		unsigned int width = 0;
+		unsigned int height = 0;
+		const sf::Uint8* pixels = nullptr;
+		const sf::Uint32* texels = nullptr; //transposed, only for images of the texture size
+	};
+
+	// the pack of the game, opened on first use and kept mapped until exit
+	static const ResourcePack& get();
+
+	ResourcePack() = default;
+	virtual ~ResourcePack() = default;
+
+	ResourcePack(const ResourcePack&) = delete;
+	ResourcePack& operator=(const ResourcePack&) = delete;
+
+	bool open(const std::string& path);
+	bool isOpen() const { return m_file.isOpen(); }
+	size_t getEntryCount() const { return m_index.size(); }
+
+	// the data stays valid as long as the pack is open
+	bool findFile(const std::string& path, const char*& data, size_t& size) const;
+	bool findImage(const std::string& path, Image& image) const;
+
+	// files changed on disk while the game runs are read from the loose file from then on
+	void markChanged(const std::string& path) const;
+
+	// the pack first unless the loose file is newer, then the loose file
+	static bool loadImage(const std::string& path, sf::Image& image);
+	static std::string readText(const std::string& path);
+
+	// packs every file below the directory except the ones written while the game runs
+	static bool build(const std::string& directory, const std::string& packPath);
+
+private:
+
+	MappedFile m_file;
+	std::unordered_map<std::string, const ResourcePackEntry*> m_index;
+	long long m_modified = 0;
+
+	//paths served from their loose file, and paths whose loose file was already compared with the pack
+	mutable std::mutex m_changedMutex;
+	mutable std::unordered_set<std::string> m_changed;
+	mutable std::unordered_set<std::string> m_checked;
+
+	bool isLooseFileNewer(const std::string& path) const;
+
+	const ResourcePackEntry* find(const std::string& path) const;
+};
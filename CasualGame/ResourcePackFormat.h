@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+// Resource pack file layout:
+// [ResourcePackHeader][payloads, each aligned to 16 bytes][entryCount ResourcePackEntry]
+// Files are stored as they are, images decoded to RGBA pixels.
+// Images of the raycaster texture size are followed by their transposed texels.
+// The checksum covers the entry table.
+
+static const char g_resourcePackMagic[4] = { 'C', 'G', 'P', 'K' };
+static const std::uint32_t g_resourcePackVersion = 1;
+
+enum class ResourcePackType : std::uint32_t
+{
+	FILE = 0,
+	IMAGE = 1
+};
+
+struct ResourcePackHeader
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t entryCount;
+	std::uint32_t checksum;
+	std::uint64_t entryOffset;
+};
+
+struct ResourcePackEntry
+{
+	char path[128]; //zero terminated, relative to the working directory with '/' separators
+	ResourcePackType type;
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t reserved;
+	std::uint64_t offset;
+	std::uint64_t size;
+	std::uint64_t texelOffset; //0 for images without texels
+};
+
+static_assert(sizeof(ResourcePackHeader) == 24, "resource pack header layout changed");
+static_assert(sizeof(ResourcePackEntry) == 168, "resource pack entry layout changed");
@@ -1,25 +1,12 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
-#include <iostream>
-#include <map>
+#include <memory>
+#include <string>
 
+// Fragment shaders of the SFML renderer, shared through the resource cache
 class ShaderHandler {
 public:
-	static sf::Shader* getShader(const std::string& path);
-
-private:
-
-	class ShaderObject {
-	public:
-		ShaderObject();
-		~ShaderObject();
-		sf::Shader* getShader() const;
-		bool loadShaderFromFile(const std::string& path);
-	private:
-		sf::Shader* m_shader;
-	};
-
-	typedef std::map<std::string, ShaderObject> shadersMap_t;
-	static shadersMap_t m_shaders;
+	// keep the handle while the shader is used, the cache releases unused shaders
+	static std::shared_ptr<sf::Shader> getShader(const std::string& path);
 };
@@ -0,0 +1,274 @@
+#include "SpriteIndex.h"
+
+#include "Sprite.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+
+SpriteIndex::SpriteIndex(const double cellSize) :
+	m_cellSize(cellSize)
+{
+	//Empty
+}
+
+void SpriteIndex::rebuild(const std::vector<Sprite>& sprites)
+{
+	m_cells.clear();
+	m_size = 0;
+
+	for (size_t i = 0; i < sprites.size(); i++)
+	{
+		insert(int(i), sprites[i].x, sprites[i].y);
+	}
+}
+
+void SpriteIndex::insert(const int index, const double x, const double y)
+{
+	//appending is the common case and needs no renumbering
+	if (size_t(index) < m_size)
+	{
+		for (auto& cell : m_cells)
+		{
+			for (auto& e : cell.second)
+			{
+				if (e.index >= index)
+				{
+					e.index++;
+				}
+			}
+		}
+	}
+
+	m_cells[toKey(toCell(x), toCell(y))].push_back({ index, x, y });
+	m_size++;
+}
+
+void SpriteIndex::insert(const std::vector<int>& indices, const std::vector<Sprite>& sprites)
+{
+	if (indices.empty())
+	{
+		return;
+	}
+
+	//an inserted sprite lands before the sprite of old index i when fewer than i old sprites precede it,
+	//so every sprite moves up by the number of inserted sprites with at most its index of old sprites before them
+	std::vector<int> oldBefore(indices.size());
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		oldBefore[i] = indices[i] - int(i);
+	}
+
+	for (auto& cell : m_cells)
+	{
+		for (auto& e : cell.second)
+		{
+			e.index += int(std::upper_bound(oldBefore.begin(), oldBefore.end(), e.index) - oldBefore.begin());
+		}
+	}
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		m_cells[toKey(toCell(sprites[i].x), toCell(sprites[i].y))].push_back({ indices[i], sprites[i].x, sprites[i].y });
+	}
+	m_size += indices.size();
+}
+
+void SpriteIndex::move(const int index, const double oldX, const double oldY, const double x, const double y)
+{
+	const auto oldKey = toKey(toCell(oldX), toCell(oldY));
+	const auto key = toKey(toCell(x), toCell(y));
+
+	auto found = m_cells.find(oldKey);
+	if (found == m_cells.end())
+	{
+		return;
+	}
+
+	auto& cell = found->second;
+	auto entry = std::find_if(cell.begin(), cell.end(), [index](const Entry& e) { return e.index == index; });
+	if (entry == cell.end())
+	{
+		return;
+	}
+
+	if (oldKey == key)
+	{
+		entry->x = x;
+		entry->y = y;
+		return;
+	}
+
+	cell.erase(entry);
+	if (cell.empty())
+	{
+		m_cells.erase(found);
+	}
+	m_cells[key].push_back({ index, x, y });
+}
+
+void SpriteIndex::remove(const int index, const double x, const double y)
+{
+	const auto key = toKey(toCell(x), toCell(y));
+	auto found = m_cells.find(key);
+	if (found == m_cells.end())
+	{
+		return;
+	}
+
+	auto& cell = found->second;
+	auto entry = std::find_if(cell.begin(), cell.end(), [index](const Entry& e) { return e.index == index; });
+	if (entry == cell.end())
+	{
+		return;
+	}
+
+	cell.erase(entry);
+	if (cell.empty())
+	{
+		m_cells.erase(found);
+	}
+	m_size--;
+
+	//linear like the erase from the sprite vector itself
+	for (auto& other : m_cells)
+	{
+		for (auto& e : other.second)
+		{
+			if (e.index > index)
+			{
+				e.index--;
+			}
+		}
+	}
+}
+
+void SpriteIndex::remove(const std::vector<int>& indices)
+{
+	if (indices.empty())
+	{
+		return;
+	}
+
+	//every sprite moves down by the number of removed sprites before it
+	for (auto cell = m_cells.begin(); cell != m_cells.end();)
+	{
+		auto& entries = cell->second;
+		size_t kept = 0;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			const auto removed = std::lower_bound(indices.begin(), indices.end(), entries[i].index);
+			if (removed != indices.end() && *removed == entries[i].index)
+			{
+				continue;
+			}
+
+			entries[kept] = entries[i];
+			entries[kept].index -= int(removed - indices.begin());
+			kept++;
+		}
+
+		m_size -= entries.size() - kept;
+		entries.resize(kept);
+		cell = entries.empty() ? m_cells.erase(cell) : std::next(cell);
+	}
+}
+
+int SpriteIndex::findNearest(const double x, const double y, const double halfSize) const
+{
+	int nearest = -1;
+	double nearestDistance = 0.0;
+
+	const int lastX = toCell(x + halfSize);
+	const int lastY = toCell(y + halfSize);
+	for (int cellX = toCell(x - halfSize); cellX <= lastX; cellX++)
+	{
+		for (int cellY = toCell(y - halfSize); cellY <= lastY; cellY++)
+		{
+			auto cell = m_cells.find(toKey(cellX, cellY));
+			if (cell == m_cells.end())
+			{
+				continue;
+			}
+
+			for (auto& e : cell->second)
+			{
+				const double dx = e.x - x;
+				const double dy = e.y - y;
+				if (std::abs(dx) >= halfSize || std::abs(dy) >= halfSize)
+				{
+					continue;
+				}
+
+				//equally near sprites are drawn in index order, the one on top wins
+				const double distance = dx * dx + dy * dy;
+				if (nearest == -1 || distance < nearestDistance || (distance == nearestDistance && e.index > nearest))
+				{
+					nearest = e.index;
+					nearestDistance = distance;
+				}
+			}
+		}
+	}
+
+	return nearest;
+}
+
+std::vector<int> SpriteIndex::findInBox(const double minX, const double minY, const double maxX, const double maxY) const
+{
+	std::vector<int> found;
+
+	const int firstX = toCell(minX);
+	const int firstY = toCell(minY);
+	const int lastX = toCell(maxX);
+	const int lastY = toCell(maxY);
+
+	//a large box over a sparse level visits fewer occupied cells than grid cells
+	const double boxCells = (double(lastX) - firstX + 1.0) * (double(lastY) - firstY + 1.0);
+	auto test = [&](const std::vector<Entry>& cell)
+	{
+		for (auto& e : cell)
+		{
+			if (e.x >= minX && e.x <= maxX && e.y >= minY && e.y <= maxY)
+			{
+				found.push_back(e.index);
+			}
+		}
+	};
+
+	if (boxCells > double(m_cells.size()))
+	{
+		for (auto& cell : m_cells)
+		{
+			test(cell.second);
+		}
+	}
+	else
+	{
+		for (int cellX = firstX; cellX <= lastX; cellX++)
+		{
+			for (int cellY = firstY; cellY <= lastY; cellY++)
+			{
+				auto cell = m_cells.find(toKey(cellX, cellY));
+				if (cell != m_cells.end())
+				{
+					test(cell->second);
+				}
+			}
+		}
+	}
+
+	std::sort(found.begin(), found.end());
+	return found;
+}
+
+int SpriteIndex::toCell(const double position) const
+{
+	return static_cast<int>(std::floor(position / m_cellSize));
+}
+
+long long SpriteIndex::toKey(const int cellX, const int cellY)
+{
+	return static_cast<long long>((static_cast<std::uint64_t>(static_cast<std::uint32_t>(cellX)) << 32) | static_cast<std::uint32_t>(cellY));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+struct Sprite;
+
+// Uniform grid over the sprite positions of a level, only occupied cells are stored.
+// Answers which sprites cover a point or lie in a box by looking at the cells around it
+// instead of every sprite. Indices are the ones of the level's sprite vector and have to
+// be kept in sync with it: insert after inserting or appending, remove after erasing.
+class SpriteIndex
+{
+public:
+	explicit SpriteIndex(const double cellSize);
+	virtual ~SpriteIndex() = default;
+
+	void rebuild(const std::vector<Sprite>& sprites);
+
+	// the sprites from index on move up by one, like in the sprite vector
+	void insert(const int index, const double x, const double y);
+	// sorted final indices of the sprites, renumbers the rest in one pass like LevelReaderWriter::insertSprites()
+	void insert(const std::vector<int>& indices, const std::vector<Sprite>& sprites);
+	void move(const int index, const double oldX, const double oldY, const double x, const double y);
+	// the sprites after index move down by one, like in the sprite vector
+	void remove(const int index, const double x, const double y);
+	// removes the sorted indices and renumbers the rest in one pass, like LevelReaderWriter::deleteSprites()
+	void remove(const std::vector<int>& indices);
+
+	// nearest sprite whose square of the given half size covers the point, -1 if there is none
+	int findNearest(const double x, const double y, const double halfSize) const;
+	// sprites positioned inside the box, sorted by index
+	std::vector<int> findInBox(const double minX, const double minY, const double maxX, const double maxY) const;
+
+	size_t size() const { return m_size; }
+
+private:
+
+	struct Entry
+	{
+		int index;
+		double x;
+		double y;
+	};
+
+	double m_cellSize;
+	size_t m_size = 0;
+	std::unordered_map<long long, std::vector<Entry>> m_cells;
+
+	int toCell(const double position) const;
+	static long long toKey(const int cellX, const int cellY);
+};
@@ -0,0 +1,369 @@
+#include "TextLevelParser.h"
+
+#include "TileMap.h"
+#include "Sprite.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	//lines parsed between progress reports
+	const int progressInterval = 256;
+
+	//powers of ten exactly representable as a double
+	const double exactPowers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	inline bool isDigit(const char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	inline bool isSpace(const char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+}
+
+TextLevelParser::TextLevelParser(const char* begin, const char* end) :
+	m_begin(begin),
+	m_end(end)
+{
+	//files saved by some editors start with an utf-8 byte order mark
+	if (m_end - m_begin >= 3 && std::memcmp(m_begin, "\xEF\xBB\xBF", 3) == 0)
+	{
+		m_begin += 3;
+	}
+	m_pos = m_begin;
+	m_lineStart = m_begin;
+}
+
+bool TextLevelParser::parse(TileMap& level, std::vector<Sprite>& sprites)
+{
+	return parseWalls(level) && parseSprites(sprites);
+}
+
+// counts the wall lines and the longest line so the grid is allocated once
+void TextLevelParser::measureWalls(int& sizeX, int& sizeY) const
+{
+	sizeX = 0;
+	sizeY = 0;
+
+	const char* pos = m_begin;
+	while (pos != m_end)
+	{
+		auto lineEnd = static_cast<const char*>(std::memchr(pos, '\n', m_end - pos));
+		if (lineEnd == nullptr)
+		{
+			lineEnd = m_end;
+		}
+
+		//tiles are comma terminated, the last one may omit its comma
+		int tiles = 0;
+		bool pending = false;
+		bool blank = true;
+		for (auto c = pos; c != lineEnd; ++c)
+		{
+			if (*c == ',')
+			{
+				tiles++;
+				pending = false;
+				blank = false;
+			}
+			else if (!isSpace(*c) && *c != '\r')
+			{
+				pending = true;
+				blank = false;
+			}
+		}
+
+		if (blank)
+		{
+			break;
+		}
+
+		sizeX++;
+		sizeY = std::max(sizeY, tiles + (pending ? 1 : 0));
+		pos = lineEnd == m_end ? m_end : lineEnd + 1;
+	}
+}
+
+bool TextLevelParser::parseWalls(TileMap& level)
+{
+	int sizeX, sizeY;
+	measureWalls(sizeX, sizeY);
+
+	//short lines are padded with empty tiles
+	level = TileMap(sizeX, sizeY);
+
+	for (int x = 0; x < sizeX; x++)
+	{
+		auto line = level.editLine(x);
+
+		skipSpaces();
+		for (int y = 0; !isLineEnd(); y++)
+		{
+			int tile;
+			if (!parseInt(tile) || !expectSeparator())
+			{
+				return false;
+			}
+			line[y] = tile;
+			skipSpaces();
+		}
+		nextLine();
+
+		if (x % progressInterval == 0 && !reportProgress())
+		{
+			return false;
+		}
+	}
+
+	//the empty line closing the walls
+	nextLine();
+	return true;
+}
+
+bool TextLevelParser::parseSprites(std::vector<Sprite>& sprites)
+{
+	sprites.clear();
+	sprites.reserve(std::count(m_pos, m_end, '\n') + 1);
+
+	while (m_pos != m_end)
+	{
+		skipSpaces();
+		if (isLineEnd())
+		{
+			nextLine();
+			continue;
+		}
+
+		Sprite spr;
+		if (!parseDouble(spr.x) || !expectSeparator() ||
+			!parseDouble(spr.y) || !expectSeparator() ||
+			!parseInt(spr.texture) || !expectSeparator())
+		{
+			return false;
+		}
+
+		skipSpaces();
+		if (!isLineEnd())
+		{
+			return fail("expected the end of the sprite line");
+		}
+
+		sprites.push_back(spr);
+		nextLine();
+
+		if (sprites.size() % progressInterval == 0 && !reportProgress())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool TextLevelParser::parseInt(int& value)
+{
+	skipSpaces();
+
+	const char* pos = m_pos;
+	bool negative = false;
+	if (pos != m_end && (*pos == '-' || *pos == '+'))
+	{
+		negative = *pos == '-';
+		++pos;
+	}
+
+	if (pos == m_end || !isDigit(*pos))
+	{
+		return fail("expected a number");
+	}
+
+	long long result = 0;
+	for (; pos != m_end && isDigit(*pos); ++pos)
+	{
+		result = result * 10 + (*pos - '0');
+		if (result > static_cast<long long>(INT_MAX) + 1)
+		{
+			return fail("number out of range");
+		}
+	}
+
+	result = negative ? -result : result;
+	if (result > INT_MAX)
+	{
+		return fail("number out of range");
+	}
+
+	value = static_cast<int>(result);
+	m_pos = pos;
+	return true;
+}
+
+bool TextLevelParser::parseDouble(double& value)
+{
+	skipSpaces();
+
+	const char* pos = m_pos;
+	bool negative = false;
+	if (pos != m_end && (*pos == '-' || *pos == '+'))
+	{
+		negative = *pos == '-';
+		++pos;
+	}
+
+	//up to 19 significant digits fit the mantissa
+	std::uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool any = false;
+
+	for (; pos != m_end && isDigit(*pos); ++pos)
+	{
+		any = true;
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*pos - '0');
+			digits += mantissa != 0;
+		}
+		else
+		{
+			exponent++;
+		}
+	}
+
+	if (pos != m_end && *pos == '.')
+	{
+		for (++pos; pos != m_end && isDigit(*pos); ++pos)
+		{
+			any = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*pos - '0');
+				digits += mantissa != 0;
+				exponent--;
+			}
+		}
+	}
+
+	if (!any)
+	{
+		return fail("expected a number");
+	}
+
+	if (pos != m_end && (*pos == 'e' || *pos == 'E'))
+	{
+		++pos;
+		bool negativeExponent = false;
+		if (pos != m_end && (*pos == '-' || *pos == '+'))
+		{
+			negativeExponent = *pos == '-';
+			++pos;
+		}
+		if (pos == m_end || !isDigit(*pos))
+		{
+			return fail("expected an exponent");
+		}
+
+		int written = 0;
+		for (; pos != m_end && isDigit(*pos); ++pos)
+		{
+			written = std::min(written * 10 + (*pos - '0'), 100000);
+		}
+		exponent += negativeExponent ? -written : written;
+	}
+
+	if (digits <= 15 && exponent >= -22 && exponent <= 22)
+	{
+		//exact mantissa and power, a single rounding like strtod
+		const double scaled = static_cast<double>(mantissa);
+		value = exponent < 0 ? scaled / exactPowers[-exponent] : scaled * exactPowers[exponent];
+		value = negative ? -value : value;
+	}
+	else
+	{
+		//rare long or huge numbers, strtod needs a terminated copy
+		char buffer[64];
+		const size_t length = pos - m_pos;
+		if (length >= sizeof(buffer))
+		{
+			return fail("number too long");
+		}
+		std::memcpy(buffer, m_pos, length);
+		buffer[length] = '\0';
+		value = std::strtod(buffer, nullptr);
+	}
+
+	m_pos = pos;
+	return true;
+}
+
+// the comma after a value, optional at the end of a line
+bool TextLevelParser::expectSeparator()
+{
+	skipSpaces();
+	if (m_pos != m_end && *m_pos == ',')
+	{
+		++m_pos;
+		return true;
+	}
+	if (isLineEnd())
+	{
+		return true;
+	}
+	return fail("expected ','");
+}
+
+void TextLevelParser::skipSpaces()
+{
+	while (m_pos != m_end && isSpace(*m_pos))
+	{
+		++m_pos;
+	}
+}
+
+bool TextLevelParser::isLineEnd() const
+{
+	return m_pos == m_end || *m_pos == '\n' ||
+		(*m_pos == '\r' && (m_pos + 1 == m_end || m_pos[1] == '\n'));
+}
+
+void TextLevelParser::nextLine()
+{
+	if (m_pos == m_end)
+	{
+		return;
+	}
+
+	auto lineEnd = static_cast<const char*>(std::memchr(m_pos, '\n', m_end - m_pos));
+	m_pos = lineEnd == nullptr ? m_end : lineEnd + 1;
+	m_lineStart = m_pos;
+	m_line++;
+}
+
+bool TextLevelParser::reportProgress()
+{
+	if (m_progress && !m_progress(float(m_pos - m_begin) / float(std::max<std::ptrdiff_t>(m_end - m_begin, 1))))
+	{
+		m_cancelled = true;
+		return fail("loading cancelled");
+	}
+	return true;
+}
+
+bool TextLevelParser::fail(const char* message)
+{
+	m_errorLine = m_line;
+	m_errorColumn = static_cast<int>(m_pos - m_lineStart) + 1;
+	m_error = message;
+	return false;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class TileMap;
+struct Sprite;
+
+// Single pass parser of the text level format over a whole file buffer.
+// Walls are lines of comma terminated tiles up to the first empty line,
+// followed by one "x, y, texture," sprite per line.
+// Numbers are parsed in place, nothing is allocated besides the level and the sprites.
+class TextLevelParser
+{
+public:
+	TextLevelParser(const char* begin, const char* end);
+
+	bool parse(TileMap& level, std::vector<Sprite>& sprites);
+
+	// called with the parsed fraction of the input every few lines, returning false cancels parsing
+	void setProgressCallback(std::function<bool(float)> progress) { m_progress = std::move(progress); }
+
+	// position and description of the first malformed input
+	int getErrorLine() const { return m_errorLine; }
+	int getErrorColumn() const { return m_errorColumn; }
+	const std::string& getError() const { return m_error; }
+	bool isCancelled() const { return m_cancelled; }
+
+private:
+
+	const char* m_begin;
+	const char* m_end;
+	const char* m_pos;
+	const char* m_lineStart;
+	int m_line = 1;
+
+	int m_errorLine = 0;
+	int m_errorColumn = 0;
+	std::string m_error;
+
+	std::function<bool(float)> m_progress;
+	bool m_cancelled = false;
+
+	void measureWalls(int& sizeX, int& sizeY) const;
+	bool parseWalls(TileMap& level);
+	bool parseSprites(std::vector<Sprite>& sprites);
+
+	bool parseInt(int& value);
+	bool parseDouble(double& value);
+	bool expectSeparator();
+
+	void skipSpaces();
+	bool isLineEnd() const;
+	void nextLine();
+
+	bool reportProgress();
+	bool fail(const char* message);
+};
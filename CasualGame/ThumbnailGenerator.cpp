@@ -0,0 +1,386 @@
+#include "ThumbnailGenerator.h"
+
+#include "LevelReaderWriter.h"
+#include "Sprite.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = std::tr2::sys;
+
+namespace
+{
+	//texture data is stored as little endian RGBA
+	sf::Color toColor(const sf::Uint32 color)
+	{
+		return sf::Color(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF);
+	}
+
+	// average of the visible pixels, sprites are drawn as dots of this color
+	sf::Color averageColor(const std::vector<sf::Uint32>& texture)
+	{
+		unsigned long long r = 0, g = 0, b = 0, count = 0;
+		for (auto color : texture)
+		{
+			if ((color & 0xFF000000) == 0 || (color & 0x00FFFFFF) == 0)
+			{
+				continue;
+			}
+			r += color & 0xFF;
+			g += (color >> 8) & 0xFF;
+			b += (color >> 16) & 0xFF;
+			count++;
+		}
+		if (count == 0)
+		{
+			return sf::Color::White;
+		}
+		return sf::Color(sf::Uint8(r / count), sf::Uint8(g / count), sf::Uint8(b / count));
+	}
+}
+
+ThumbnailGenerator::ThumbnailGenerator(std::vector<std::vector<sf::Uint32> > textures, const std::string& cacheDirectory) :
+	m_textures(std::move(textures)),
+	m_cacheDirectory(cacheDirectory)
+{
+	m_worker = std::thread(&ThumbnailGenerator::run, this);
+}
+
+ThumbnailGenerator::~ThumbnailGenerator()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+
+	if (m_worker.joinable())
+	{
+		m_worker.join();
+	}
+}
+
+void ThumbnailGenerator::request(const std::string& path, const sf::Uint32 hash, const bool priority)
+{
+	const auto requested = m_previews.find(hash) != m_previews.end();
+	if (requested && !priority)
+	{
+		return;
+	}
+	m_previews[hash];
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		//move a queued request to the front
+		auto queued = std::find_if(m_queue.begin(), m_queue.end(), [hash](const Request& r) { return r.hash == hash; });
+		if (queued != m_queue.end())
+		{
+			m_queue.erase(queued);
+		}
+		else if (requested)
+		{
+			//already rendered or being rendered
+			return;
+		}
+
+		if (priority)
+		{
+			m_queue.push_front({ path, hash });
+		}
+		else
+		{
+			m_queue.push_back({ path, hash });
+		}
+	}
+	m_wake.notify_one();
+}
+
+const sf::Texture* ThumbnailGenerator::getMap(const sf::Uint32 hash)
+{
+	upload();
+	auto it = m_previews.find(hash);
+	return it != m_previews.end() && it->second.ready ? &it->second.map : nullptr;
+}
+
+const sf::Texture* ThumbnailGenerator::getView(const sf::Uint32 hash)
+{
+	upload();
+	auto it = m_previews.find(hash);
+	return it != m_previews.end() && it->second.ready ? &it->second.view : nullptr;
+}
+
+sf::Image ThumbnailGenerator::renderMap(const TileMap& level, const std::vector<Sprite>& sprites, const std::vector<std::vector<sf::Uint32> >& textures, const int size)
+{
+	sf::Image image;
+	image.create(size, size, sf::Color(150, 150, 150));
+
+	const int sizeX = level.getSizeX();
+	const int sizeY = level.getSizeY();
+	if (sizeX == 0 || sizeY == 0)
+	{
+		return image;
+	}
+
+	//level lines are rows like in the editor, every pixel samples one point of a tile
+	const double tilesPerPixel = double(std::max(sizeX, sizeY)) / size;
+	for (int py = 0; py < size; py++)
+	{
+		const double levelX = (py + 0.5) * tilesPerPixel;
+		const int x = static_cast<int>(levelX);
+		if (x >= sizeX)
+		{
+			break;
+		}
+
+		for (int px = 0; px < size; px++)
+		{
+			const double levelY = (px + 0.5) * tilesPerPixel;
+			const int y = static_cast<int>(levelY);
+			if (y >= sizeY)
+			{
+				break;
+			}
+
+			const int id = level.get(x, y);
+			if (id > 0 && id <= int(textures.size()) && !textures[id - 1].empty())
+			{
+				const int texX = static_cast<int>((levelY - y) * g_textureWidth);
+				const int texY = static_cast<int>((levelX - x) * g_textureHeight);
+				image.setPixel(px, py, toColor(textures[id - 1][g_textureHeight * texX + texY]));
+			}
+		}
+
+		//the samples of a paged level touch every chunk, keep the resident ones in budget
+		if (level.isPaged())
+		{
+			level.trim();
+		}
+	}
+
+	std::vector<sf::Color> spriteColors;
+	for (auto& texture : textures)
+	{
+		spriteColors.push_back(averageColor(texture));
+	}
+
+	for (auto& sprite : sprites)
+	{
+		const int px = static_cast<int>(sprite.y / tilesPerPixel);
+		const int py = static_cast<int>(sprite.x / tilesPerPixel);
+		if (px < 0 || py < 0 || px >= size || py >= size || sprite.texture < 0 || sprite.texture >= int(textures.size()))
+		{
+			continue;
+		}
+		image.setPixel(px, py, spriteColors[sprite.texture]);
+	}
+
+	return image;
+}
+
+sf::Image ThumbnailGenerator::renderView(const TileMap& level, const std::vector<std::vector<sf::Uint32> >& textures, const int width, const int height)
+{
+	sf::Image image;
+	image.create(width, height, sf::Color::Black);
+
+	const int sizeX = level.getSizeX();
+	const int sizeY = level.getSizeY();
+	if (sizeX == 0 || sizeY == 0 || textures.size() < 10)
+	{
+		return image;
+	}
+
+	//flat floor and ceiling are enough at this size
+	const auto floor = averageColor(textures[8]);
+	const auto ceiling = averageColor(textures[9]);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			image.setPixel(x, y, y < height / 2 ? ceiling : floor);
+		}
+	}
+
+	//the camera the editor resets the player to
+	const double posX = g_playerStartX;
+	const double posY = g_playerStartY;
+	const double dirX = -1.0;
+	const double dirY = 0.0;
+	const double planeX = 0.0;
+	const double planeY = 0.66;
+
+	for (int x = 0; x < width; x++)
+	{
+		const double cameraX = 2.0 * x / double(width) - 1.0;
+		const double rayDirX = dirX + planeX * cameraX;
+		const double rayDirY = dirY + planeY * cameraX;
+
+		int mapX = static_cast<int>(posX);
+		int mapY = static_cast<int>(posY);
+
+		const double deltaDistX = std::abs(1.0 / rayDirX);
+		const double deltaDistY = std::abs(1.0 / rayDirY);
+
+		const int stepX = rayDirX < 0 ? -1 : 1;
+		const int stepY = rayDirY < 0 ? -1 : 1;
+		double sideDistX = rayDirX < 0 ? (posX - mapX) * deltaDistX : (mapX + 1.0 - posX) * deltaDistX;
+		double sideDistY = rayDirY < 0 ? (posY - mapY) * deltaDistY : (mapY + 1.0 - posY) * deltaDistY;
+
+		//unlike the game the start may be anywhere, rays leaving the level hit nothing
+		int side = 0;
+		int id = 0;
+		while (id == 0)
+		{
+			if (sideDistX < sideDistY)
+			{
+				sideDistX += deltaDistX;
+				mapX += stepX;
+				side = 0;
+			}
+			else
+			{
+				sideDistY += deltaDistY;
+				mapY += stepY;
+				side = 1;
+			}
+
+			if (mapX < 0 || mapY < 0 || mapX >= sizeX || mapY >= sizeY)
+			{
+				break;
+			}
+			id = level.get(mapX, mapY);
+		}
+
+		if (id <= 0 || id > int(textures.size()) || textures[id - 1].empty())
+		{
+			continue;
+		}
+
+		double perpWallDist, wallX;
+		if (side == 0)
+		{
+			perpWallDist = std::abs((mapX - posX + (1 - stepX) / 2) / rayDirX);
+			wallX = posY + perpWallDist * rayDirY;
+		}
+		else
+		{
+			perpWallDist = std::abs((mapY - posY + (1 - stepY) / 2) / rayDirY);
+			wallX = posX + perpWallDist * rayDirX;
+		}
+		wallX -= std::floor(wallX);
+		perpWallDist = std::max(perpWallDist, 0.01);
+
+		int texX = static_cast<int>(wallX * g_textureWidth);
+		if (side == 0 && rayDirX > 0) texX = g_textureWidth - texX - 1;
+		if (side == 1 && rayDirY < 0) texX = g_textureWidth - texX - 1;
+
+		const int lineHeight = static_cast<int>(height / perpWallDist);
+		const int drawStart = std::max(height / 2 - lineHeight / 2, 0);
+		const int drawEnd = std::min(height / 2 + lineHeight / 2, height);
+
+		const auto& texture = textures[id - 1];
+		for (int y = drawStart; y < drawEnd; y++)
+		{
+			const int texY = std::min(std::max(((y - height / 2) * 2 + lineHeight) * g_textureHeight / (2 * lineHeight), 0), g_textureHeight - 1);
+			auto color = toColor(texture[g_textureHeight * texX + texY]);
+			if (side == 1)
+			{
+				color = sf::Color(color.r / 2, color.g / 2, color.b / 2);
+			}
+			image.setPixel(x, y, color);
+		}
+
+		if (level.isPaged())
+		{
+			level.trim();
+		}
+	}
+
+	return image;
+}
+
+void ThumbnailGenerator::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+		if (m_stop)
+		{
+			return;
+		}
+
+		const auto request = m_queue.front();
+		m_queue.pop_front();
+
+		lock.unlock();
+		auto result = generate(request);
+		lock.lock();
+
+		m_finished.push_back(std::move(result));
+	}
+}
+
+bool ThumbnailGenerator::isStopping()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stop;
+}
+
+ThumbnailGenerator::Result ThumbnailGenerator::generate(const Request& request)
+{
+	Result result;
+	result.hash = request.hash;
+
+	const auto mapPath = getCachePath(request.hash, "_map.png");
+	const auto viewPath = getCachePath(request.hash, "_view.png");
+	if (fs::exists(fs::path(mapPath)) && fs::exists(fs::path(viewPath)) &&
+		result.map.loadFromFile(mapPath) && result.view.loadFromFile(viewPath))
+	{
+		return result;
+	}
+
+	TileMap level;
+	std::vector<Sprite> sprites;
+	if (!LevelReaderWriter::readLevelFile(request.path, level, sprites, [this](const float) { return !isStopping(); }))
+	{
+		//left empty, the level is listed without a preview
+		return result;
+	}
+
+	result.map = renderMap(level, sprites, m_textures, g_thumbnailMapSize);
+	result.view = renderView(level, m_textures, g_thumbnailViewWidth, g_thumbnailViewHeight);
+
+	fs::create_directories(fs::path(m_cacheDirectory));
+	result.map.saveToFile(mapPath);
+	result.view.saveToFile(viewPath);
+
+	return result;
+}
+
+void ThumbnailGenerator::upload()
+{
+	std::vector<Result> finished;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		finished.swap(m_finished);
+	}
+
+	for (auto& result : finished)
+	{
+		auto& preview = m_previews[result.hash];
+		preview.ready = result.map.getSize().x > 0 && result.view.getSize().x > 0 &&
+			preview.map.loadFromImage(result.map) && preview.view.loadFromImage(result.view);
+	}
+}
+
+std::string ThumbnailGenerator::getCachePath(const sf::Uint32 hash, const std::string& suffix) const
+{
+	std::ostringstream name;
+	name << m_cacheDirectory << std::hex << std::setw(8) << std::setfill('0') << hash << suffix;
+	return name.str();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TileMap;
+struct Sprite;
+
+// Renders small previews of levels on a worker thread: a top down map and a view from the player start.
+// Images are cached on disk by the hash of the level file, so a level is only rendered again after it changed.
+// Only the finished images are uploaded to textures, by the thread drawing them.
+class ThumbnailGenerator
+{
+public:
+	ThumbnailGenerator(std::vector<std::vector<sf::Uint32> > textures, const std::string& cacheDirectory);
+	virtual ~ThumbnailGenerator();
+
+	ThumbnailGenerator(const ThumbnailGenerator&) = delete;
+	ThumbnailGenerator& operator=(const ThumbnailGenerator&) = delete;
+
+	// queues a level once per hash, priority requests are rendered next
+	void request(const std::string& path, const sf::Uint32 hash, const bool priority = false);
+
+	// nullptr until the preview is ready, call from the render thread
+	const sf::Texture* getMap(const sf::Uint32 hash);
+	const sf::Texture* getView(const sf::Uint32 hash);
+
+	// software renderers over the level reader's texture data
+	static sf::Image renderMap(const TileMap& level, const std::vector<Sprite>& sprites, const std::vector<std::vector<sf::Uint32> >& textures, const int size);
+	static sf::Image renderView(const TileMap& level, const std::vector<std::vector<sf::Uint32> >& textures, const int width, const int height);
+
+private:
+
+	struct Request
+	{
+		std::string path;
+		sf::Uint32 hash;
+	};
+
+	struct Result
+	{
+		sf::Uint32 hash;
+		sf::Image map;
+		sf::Image view;
+	};
+
+	struct Preview
+	{
+		bool ready = false;
+		sf::Texture map;
+		sf::Texture view;
+	};
+
+	std::vector<std::vector<sf::Uint32> > m_textures;
+	std::string m_cacheDirectory;
+
+	//owned by the render thread
+	std::map<sf::Uint32, Preview> m_previews;
+
+	//guards the queue and the finished results
+	std::mutex m_mutex;
+	std::deque<Request> m_queue;
+	std::vector<Result> m_finished;
+	std::condition_variable m_wake;
+	bool m_stop = false;
+
+	std::thread m_worker;
+
+	void run();
+	bool isStopping();
+	Result generate(const Request& request);
+	void upload();
+
+	std::string getCachePath(const sf::Uint32 hash, const std::string& suffix) const;
+};
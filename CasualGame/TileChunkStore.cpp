@@ -0,0 +1,299 @@
+#include "TileChunkStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	//evicted buffers kept for reuse
+	const size_t maxSpareBuffers = 16;
+}
+
+TileChunkStore::TileChunkStore(const size_t budget) :
+	m_budget(budget)
+{
+}
+
+TileChunkStore::~TileChunkStore()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+
+	if (m_loader.joinable())
+	{
+		m_loader.join();
+	}
+}
+
+bool TileChunkStore::open(const std::string& path, const int sizeX, const int sizeY, const int chunkSize, const std::uint64_t tileOffset)
+{
+	if (chunkSize <= 0 || (chunkSize & (chunkSize - 1)) != 0 || sizeX <= 0 || sizeY <= 0)
+	{
+		return false;
+	}
+
+	m_file.open(path, std::ios::in | std::ios::binary);
+	if (!m_file.is_open())
+	{
+		return false;
+	}
+
+	m_path = path;
+	m_sizeX = sizeX;
+	m_sizeY = sizeY;
+	m_chunkSize = chunkSize;
+	m_mask = chunkSize - 1;
+	m_shift = 0;
+	while ((1 << m_shift) < chunkSize)
+	{
+		m_shift++;
+	}
+	m_chunksX = (sizeX + m_mask) >> m_shift;
+	m_chunksY = (sizeY + m_mask) >> m_shift;
+	m_tileOffset = tileOffset;
+
+	m_chunks.reset(new Chunk[static_cast<size_t>(m_chunksX) * m_chunksY]);
+	m_loader = std::thread(&TileChunkStore::runLoader, this);
+	return true;
+}
+
+void TileChunkStore::set(const int x, const int y, const int value)
+{
+	if (static_cast<unsigned int>(x) >= static_cast<unsigned int>(m_sizeX) || static_cast<unsigned int>(y) >= static_cast<unsigned int>(m_sizeY))
+	{
+		return;
+	}
+
+	const size_t index = static_cast<size_t>(x >> m_shift) * m_chunksY + (y >> m_shift);
+
+	//trim() runs on the same thread, so the chunk stays resident until it is marked dirty
+	auto tiles = load(index);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	tiles[((x & m_mask) << m_shift) + (y & m_mask)] = value;
+	m_chunks[index].dirty = true;
+}
+
+void TileChunkStore::prefetch(const double posX, const double posY, const double dirX, const double dirY, const int distance)
+{
+	const double length = std::sqrt(dirX * dirX + dirY * dirY);
+	if (length <= 0.0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	//the old queue is stale once the player turned
+	for (auto index : m_queue)
+	{
+		m_chunks[index].queued = false;
+	}
+	m_queue.clear();
+
+	//a three chunk wide band from the player along the heading, nearest first
+	for (int step = 0; step <= distance; step++)
+	{
+		const double ahead = double(step) * m_chunkSize / length;
+		const int centerX = static_cast<int>(std::floor(posX + dirX * ahead)) >> m_shift;
+		const int centerY = static_cast<int>(std::floor(posY + dirY * ahead)) >> m_shift;
+
+		for (int cx = centerX - 1; cx <= centerX + 1; cx++)
+		{
+			for (int cy = centerY - 1; cy <= centerY + 1; cy++)
+			{
+				if (cx < 0 || cy < 0 || cx >= m_chunksX || cy >= m_chunksY)
+				{
+					continue;
+				}
+
+				const size_t index = static_cast<size_t>(cx) * m_chunksY + cy;
+				auto& chunk = m_chunks[index];
+				if (chunk.tiles.load(std::memory_order_relaxed) != nullptr)
+				{
+					//keep the chunks ahead from being evicted
+					chunk.lastUse.store(m_clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				}
+				else if (!chunk.queued)
+				{
+					chunk.queued = true;
+					m_queue.push_back(index);
+				}
+			}
+		}
+	}
+
+	if (!m_queue.empty())
+	{
+		m_wake.notify_one();
+	}
+}
+
+void TileChunkStore::trim()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_clock.fetch_add(1, std::memory_order_relaxed);
+
+	if (m_resident.size() <= m_budget)
+	{
+		return;
+	}
+
+	//oldest chunks first, edited chunks are never evicted
+	const size_t excess = m_resident.size() - m_budget;
+	std::nth_element(m_resident.begin(), m_resident.begin() + excess, m_resident.end(), [this](const size_t a, const size_t b)
+	{
+		return m_chunks[a].lastUse.load(std::memory_order_relaxed) < m_chunks[b].lastUse.load(std::memory_order_relaxed);
+	});
+
+	std::vector<size_t> kept;
+	kept.reserve(m_budget + excess);
+	for (size_t i = 0; i < m_resident.size(); i++)
+	{
+		const auto index = m_resident[i];
+		if (i < excess && !m_chunks[index].dirty)
+		{
+			evictLocked(index);
+		}
+		else
+		{
+			kept.push_back(index);
+		}
+	}
+	m_resident.swap(kept);
+}
+
+std::shared_ptr<TileChunkStore> TileChunkStore::snapshot() const
+{
+	auto copy = std::make_shared<TileChunkStore>(m_budget);
+	if (!copy->open(m_path, m_sizeX, m_sizeY, m_chunkSize, m_tileOffset))
+	{
+		return nullptr;
+	}
+
+	//edited chunks are only in memory, they stay resident in the copy as well
+	const size_t chunkTiles = static_cast<size_t>(m_chunkSize) * m_chunkSize;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::lock_guard<std::mutex> copyLock(copy->m_mutex);
+	for (auto index : m_resident)
+	{
+		if (!m_chunks[index].dirty)
+		{
+			continue;
+		}
+
+		std::unique_ptr<std::int32_t[]> storage(new std::int32_t[chunkTiles]);
+		std::copy(m_chunks[index].storage.get(), m_chunks[index].storage.get() + chunkTiles, storage.get());
+		copy->installLocked(index, std::move(storage));
+		copy->m_chunks[index].dirty = true;
+	}
+	return copy;
+}
+
+size_t TileChunkStore::getResidentCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_resident.size();
+}
+
+std::int32_t* TileChunkStore::load(const size_t index) const
+{
+	const size_t chunkTiles = static_cast<size_t>(m_chunkSize) * m_chunkSize;
+	std::unique_ptr<std::int32_t[]> storage;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto tiles = m_chunks[index].tiles.load(std::memory_order_relaxed);
+		if (tiles != nullptr)
+		{
+			return tiles;
+		}
+
+		if (!m_spare.empty())
+		{
+			storage = std::move(m_spare.back());
+			m_spare.pop_back();
+		}
+	}
+
+	if (!storage)
+	{
+		storage.reset(new std::int32_t[chunkTiles]);
+	}
+	readChunk(index, storage.get());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return installLocked(index, std::move(storage));
+}
+
+void TileChunkStore::readChunk(const size_t index, std::int32_t* tiles) const
+{
+	const size_t chunkTiles = static_cast<size_t>(m_chunkSize) * m_chunkSize;
+
+	std::lock_guard<std::mutex> lock(m_fileMutex);
+	m_file.seekg(static_cast<std::streamoff>(m_tileOffset + index * chunkTiles * sizeof(std::int32_t)));
+	if (!m_file.read(reinterpret_cast<char*>(tiles), chunkTiles * sizeof(std::int32_t)))
+	{
+		//unreadable chunks become solid walls so rays still stop
+		m_file.clear();
+		std::fill(tiles, tiles + chunkTiles, 1);
+		std::cout << "Could not read level chunk " << index << " of " << m_path << std::endl;
+	}
+}
+
+std::int32_t* TileChunkStore::installLocked(const size_t index, std::unique_ptr<std::int32_t[]> storage) const
+{
+	auto& chunk = m_chunks[index];
+	auto tiles = chunk.tiles.load(std::memory_order_relaxed);
+	if (tiles != nullptr)
+	{
+		if (m_spare.size() < maxSpareBuffers)
+		{
+			m_spare.push_back(std::move(storage));
+		}
+		return tiles;
+	}
+
+	chunk.storage = std::move(storage);
+	chunk.lastUse.store(m_clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	chunk.tiles.store(chunk.storage.get(), std::memory_order_release);
+	m_resident.push_back(index);
+
+	return chunk.storage.get();
+}
+
+void TileChunkStore::evictLocked(const size_t index)
+{
+	auto& chunk = m_chunks[index];
+	chunk.tiles.store(nullptr, std::memory_order_relaxed);
+	if (m_spare.size() < maxSpareBuffers)
+	{
+		m_spare.push_back(std::move(chunk.storage));
+	}
+	chunk.storage.reset();
+}
+
+void TileChunkStore::runLoader()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+		if (m_stop)
+		{
+			return;
+		}
+
+		const auto index = m_queue.front();
+		m_queue.pop_front();
+		m_chunks[index].queued = false;
+
+		//readers and prefetch() are not kept waiting while the chunk is read
+		lock.unlock();
+		load(index);
+		lock.lock();
+	}
+}
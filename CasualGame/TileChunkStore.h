@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tiles of a chunked binary level file, paged in from disk on demand.
+// Reading a resident chunk is lock free, a missing chunk is loaded by the reading thread
+// and chunks ahead of the player are loaded by a background thread.
+// The disk is read outside the store's lock, only the file handle is held meanwhile.
+// Chunks are only evicted in trim(), which must not run while other threads read tiles.
+class TileChunkStore
+{
+public:
+	explicit TileChunkStore(const size_t budget);
+	virtual ~TileChunkStore();
+
+	TileChunkStore(const TileChunkStore&) = delete;
+	TileChunkStore& operator=(const TileChunkStore&) = delete;
+
+	// chunkSize has to be a power of two
+	bool open(const std::string& path, const int sizeX, const int sizeY, const int chunkSize, const std::uint64_t tileOffset);
+
+	const std::string& getPath() const { return m_path; }
+	int getSizeX() const { return m_sizeX; }
+	int getSizeY() const { return m_sizeY; }
+	int getChunkSize() const { return m_chunkSize; }
+
+	int get(const int x, const int y) const
+	{
+		//outside the level is solid, rays and collisions stop even at an open border
+		if (static_cast<unsigned int>(x) >= static_cast<unsigned int>(m_sizeX) || static_cast<unsigned int>(y) >= static_cast<unsigned int>(m_sizeY))
+		{
+			return 1;
+		}
+
+		const size_t index = static_cast<size_t>(x >> m_shift) * m_chunksY + (y >> m_shift);
+		auto& chunk = m_chunks[index];
+
+		const std::int32_t* tiles = chunk.tiles.load(std::memory_order_acquire);
+		if (tiles == nullptr)
+		{
+			tiles = load(index);
+		}
+
+		//avoid writing the shared cache line on every read
+		const unsigned int clock = m_clock.load(std::memory_order_relaxed);
+		if (chunk.lastUse.load(std::memory_order_relaxed) != clock)
+		{
+			chunk.lastUse.store(clock, std::memory_order_relaxed);
+		}
+
+		return tiles[((x & m_mask) << m_shift) + (y & m_mask)];
+	}
+
+	// edited chunks stay resident until the store is closed, tiles outside the level are ignored
+	void set(const int x, const int y, const int value);
+
+	// queues the chunks around a position and along a heading for the background loader
+	void prefetch(const double posX, const double posY, const double dirX, const double dirY, const int distance);
+
+	// evicts the least recently used chunks over the budget, called once per frame
+	void trim();
+
+	// a store of its own on the same file holding the edits made so far,
+	// another thread can stream through it while this one keeps trimming
+	std::shared_ptr<TileChunkStore> snapshot() const;
+
+	size_t getResidentCount() const;
+
+private:
+
+	struct Chunk
+	{
+		std::atomic<std::int32_t*> tiles{ nullptr };
+		std::atomic<unsigned int> lastUse{ 0 };
+		std::unique_ptr<std::int32_t[]> storage;
+		bool dirty = false;
+		bool queued = false;
+	};
+
+	std::string m_path;
+	int m_sizeX = 0;
+	int m_sizeY = 0;
+	int m_chunkSize = 0;
+	int m_shift = 0;
+	int m_mask = 0;
+	int m_chunksX = 0;
+	int m_chunksY = 0;
+	std::uint64_t m_tileOffset = 0;
+
+	size_t m_budget;
+	std::atomic<unsigned int> m_clock{ 1 };
+
+	std::unique_ptr<Chunk[]> m_chunks;
+
+	//guards the resident list, the spare buffers and the prefetch queue
+	mutable std::mutex m_mutex;
+	//guards the file, never taken while holding m_mutex
+	mutable std::mutex m_fileMutex;
+	mutable std::ifstream m_file;
+	mutable std::vector<size_t> m_resident;
+	mutable std::vector<std::unique_ptr<std::int32_t[]> > m_spare;
+
+	std::deque<size_t> m_queue;
+	std::condition_variable m_wake;
+	std::thread m_loader;
+	bool m_stop = false;
+
+	std::int32_t* load(const size_t index) const;
+	void readChunk(const size_t index, std::int32_t* tiles) const;
+	// another thread may have loaded the chunk meanwhile, its tiles are kept then
+	std::int32_t* installLocked(const size_t index, std::unique_ptr<std::int32_t[]> storage) const;
+	void evictLocked(const size_t index);
+	void runLoader();
+};
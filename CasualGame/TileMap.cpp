@@ -0,0 +1,148 @@
+#include "TileMap.h"
+
+#include <algorithm>
+
+TileMap::TileMap(const int sizeX, const int sizeY, const int value) :
+	m_sizeX(sizeX),
+	m_sizeY(sizeY),
+	m_storage(static_cast<size_t>(sizeX) * sizeY, value)
+{
+	m_tiles = m_storage.data();
+}
+
+TileMap::TileMap(const TileMap& other) :
+	m_sizeX(other.m_sizeX),
+	m_sizeY(other.m_sizeY),
+	m_storage(other.m_storage),
+	m_owner(other.m_owner),
+	m_store(other.m_store)
+{
+	m_tiles = m_owner ? other.m_tiles : m_storage.data();
+}
+
+TileMap& TileMap::operator=(const TileMap& other)
+{
+	if (this != &other)
+	{
+		m_sizeX = other.m_sizeX;
+		m_sizeY = other.m_sizeY;
+		m_storage = other.m_storage;
+		m_owner = other.m_owner;
+		m_store = other.m_store;
+		m_tiles = m_owner ? other.m_tiles : m_storage.data();
+	}
+	return *this;
+}
+
+void TileMap::set(const int x, const int y, const int value)
+{
+	if (m_store)
+	{
+		m_store->set(x, y, value);
+		return;
+	}
+
+	detach();
+	m_storage[static_cast<size_t>(x) * m_sizeY + y] = value;
+}
+
+void TileMap::fill(const TileRun& run)
+{
+	if (m_store)
+	{
+		for (int y = run.y; y < run.y + run.length; y++)
+		{
+			m_store->set(run.x, y, run.value);
+		}
+		return;
+	}
+
+	auto line = editLine(run.x);
+	std::fill(line + run.y, line + run.y + run.length, run.value);
+}
+
+std::int32_t* TileMap::editLine(const int x)
+{
+	detach();
+	return m_storage.data() + static_cast<size_t>(x) * m_sizeY;
+}
+
+void TileMap::copyLine(const int x, std::int32_t* destination) const
+{
+	if (m_store)
+	{
+		for (int y = 0; y < m_sizeY; y++)
+		{
+			destination[y] = m_store->get(x, y);
+		}
+		return;
+	}
+
+	std::copy(getLine(x), getLine(x) + m_sizeY, destination);
+}
+
+void TileMap::attach(std::shared_ptr<const void> owner, const std::int32_t* tiles, const int sizeX, const int sizeY)
+{
+	std::vector<std::int32_t>().swap(m_storage);
+	m_store.reset();
+	m_owner = std::move(owner);
+	m_tiles = tiles;
+	m_sizeX = sizeX;
+	m_sizeY = sizeY;
+}
+
+void TileMap::page(std::shared_ptr<TileChunkStore> store)
+{
+	std::vector<std::int32_t>().swap(m_storage);
+	m_owner.reset();
+	m_tiles = nullptr;
+	m_sizeX = store->getSizeX();
+	m_sizeY = store->getSizeY();
+	m_store = std::move(store);
+}
+
+void TileMap::trim() const
+{
+	if (m_store)
+	{
+		m_store->trim();
+	}
+}
+
+void TileMap::clear()
+{
+	std::vector<std::int32_t>().swap(m_storage);
+	m_owner.reset();
+	m_store.reset();
+	m_tiles = nullptr;
+	m_sizeX = 0;
+	m_sizeY = 0;
+}
+
+void TileMap::detach()
+{
+	if (m_store)
+	{
+		m_storage.resize(static_cast<size_t>(m_sizeX) * m_sizeY);
+		for (int x = 0; x < m_sizeX; x++)
+		{
+			copyLine(x, m_storage.data() + static_cast<size_t>(x) * m_sizeY);
+			if ((x + 1) % m_store->getChunkSize() == 0)
+			{
+				m_store->trim();
+			}
+		}
+		m_tiles = m_storage.data();
+		m_store.reset();
+		return;
+	}
+
+	if (!m_owner)
+	{
+		return;
+	}
+
+	m_storage.assign(m_tiles, m_tiles + static_cast<size_t>(m_sizeX) * m_sizeY);
+	m_tiles = m_storage.data();
+	m_owner.reset();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "TileChunkStore.h"
+
+// length tiles of line x from column y on, all set to value
+struct TileRun
+{
+	int x;
+	int y;
+	int length;
+	int value;
+};
+
+// Tile grid of a level, indexed (x, y) like the level files: x is the line, y the column.
+// The tiles are either owned, a read only view into a mapped level file
+// or paged in chunk by chunk from a chunked level file.
+// A view is copied into owned storage on the first write,
+// paged maps share their chunks and edits between copies.
+class TileMap
+{
+public:
+	TileMap() = default;
+	TileMap(const int sizeX, const int sizeY, const int value = 0);
+
+	TileMap(const TileMap& other);
+	TileMap& operator=(const TileMap& other);
+	TileMap(TileMap&& other) = default;
+	TileMap& operator=(TileMap&& other) = default;
+
+	int getSizeX() const { return m_sizeX; }
+	int getSizeY() const { return m_sizeY; }
+	bool empty() const { return m_sizeX == 0 || m_sizeY == 0; }
+	bool contains(const int x, const int y) const { return x >= 0 && y >= 0 && x < m_sizeX && y < m_sizeY; }
+
+	int get(const int x, const int y) const
+	{
+		return m_store ? m_store->get(x, y) : m_tiles[static_cast<size_t>(x) * m_sizeY + y];
+	}
+	void set(const int x, const int y, const int value);
+	void fill(const TileRun& run);
+
+	// tiles of line x, sizeY entries, not available for paged maps
+	const std::int32_t* getLine(const int x) const { return m_tiles + static_cast<size_t>(x) * m_sizeY; }
+
+	// copies the sizeY tiles of line x, works for every kind of map
+	void copyLine(const int x, std::int32_t* destination) const;
+
+	// writable tiles of line x, detaches a mapped view first
+	std::int32_t* editLine(const int x);
+
+	// uses tiles owned by someone else without copying, owner keeps them alive
+	void attach(std::shared_ptr<const void> owner, const std::int32_t* tiles, const int sizeX, const int sizeY);
+	bool isAttached() const { return m_owner != nullptr; }
+
+	// reads the tiles through a chunk store
+	void page(std::shared_ptr<TileChunkStore> store);
+	bool isPaged() const { return m_store != nullptr; }
+	TileChunkStore* getChunkStore() const { return m_store.get(); }
+
+	// lets a paged map evict chunks while streaming through it, no other thread may read tiles
+	void trim() const;
+
+	// copies attached or paged tiles into owned storage and releases the owner
+	void detach();
+
+	void clear();
+
+private:
+
+	int m_sizeX = 0;
+	int m_sizeY = 0;
+
+	std::vector<std::int32_t> m_storage;
+	const std::int32_t* m_tiles = nullptr;
+	std::shared_ptr<const void> m_owner;
+	std::shared_ptr<TileChunkStore> m_store;
+};
@@ -1,9 +1,18 @@
 #include "Utils.h"
 
+#include "Config.h"
+
+#include <cstdio>
 #include <string>
 #include <fstream>
 #include <streambuf>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
 const sf::Vector2f& Utils::normalize(const sf::Vector2f& source)
 {
 	sf::Vector2f result(source.x, source.y);
@@ -56,3 +65,41 @@ std::string Utils::readFile(const std::string path)
 
 	return result;
 }
+
+sf::Uint32 Utils::checksum(const void* data, const size_t size, sf::Uint32 seed)
+{
+	auto bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		seed ^= bytes[i];
+		seed *= 16777619u;
+	}
+	return seed;
+}
+
+std::string Utils::temporaryPath(const std::string& path)
+{
+	return path + g_temporaryFileSuffix;
+}
+
+bool Utils::isTemporaryFile(const std::string& path)
+{
+	const std::string suffix = g_temporaryFileSuffix;
+	return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+#ifdef _WIN32
+
+bool Utils::replaceFile(const std::string& from, const std::string& to)
+{
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+#else
+
+bool Utils::replaceFile(const std::string& from, const std::string& to)
+{
+	return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <string>
 
 class Utils
 {
@@ -9,4 +10,11 @@ public:
 	static float length(const sf::Vector2f& source);
 	static void combSort(std::vector<int>& order, std::vector<double>& dist, int amount);
 	static std::string readFile(const std::string path);
+	// FNV-1a hash of a memory block
+	static sf::Uint32 checksum(const void* data, const size_t size, sf::Uint32 seed = 2166136261u);
+	// renames over an existing file, atomic where the platform allows it
+	static bool replaceFile(const std::string& from, const std::string& to);
+	// files written next to their target before they replace it
+	static std::string temporaryPath(const std::string& path);
+	static bool isTemporaryFile(const std::string& path);
 };
\ No newline at end of file
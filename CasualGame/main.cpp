@@ -1,7 +1,113 @@
 #include "Game.h"
+#include "RenderVerifier.h"
+#include "Benchmark.h"
+#include "LevelGenerator.h"
+#include "LevelReaderWriter.h"
+#include "ResourcePack.h"
+#include "Config.h"
 
-int main()
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[])
 {
+	// --verify-render [--update] [--tolerance N]
+	// renders every level without a window and compares it with the reference images
+	// --generate-render-references
+	// writes the reference images, same as --verify-render --update
+	if (argc > 1 && (std::string(argv[1]) == "--verify-render" || std::string(argv[1]) == "--generate-render-references"))
+	{
+		RenderVerifier verifier(g_renderReferenceDirectory, g_renderVerifyOutputDirectory);
+		verifier.setUpdateReferences(std::string(argv[1]) == "--generate-render-references");
+		for (int i = 2; i < argc; i++)
+		{
+			const std::string arg(argv[i]);
+			if (arg == "--update")
+			{
+				verifier.setUpdateReferences(true);
+			}
+			else if (arg == "--tolerance" && i + 1 < argc)
+			{
+				verifier.setTolerance(std::stoi(argv[++i]));
+			}
+		}
+		return verifier.run() ? 0 : 1;
+	}
+
+	// --benchmark [--filter name] [--output file.json]
+	// runs the microbenchmarks and prints the results as json
+	if (argc > 1 && std::string(argv[1]) == "--benchmark")
+	{
+		Benchmark benchmark;
+		std::string output;
+		for (int i = 2; i + 1 < argc; i++)
+		{
+			const std::string arg(argv[i]);
+			if (arg == "--filter")
+			{
+				benchmark.setFilter(argv[++i]);
+			}
+			else if (arg == "--output")
+			{
+				output = argv[++i];
+			}
+		}
+		benchmark.run();
+
+		if (output.empty())
+		{
+			benchmark.writeJson(std::cout);
+		}
+		else
+		{
+			std::ofstream file(output);
+			benchmark.writeJson(file);
+		}
+		return 0;
+	}
+
+	// --generate-level <maze|arena|pillars|sprites> <width> <height> <wallDensity> <sprites> <seed> <output>
+	// writes a procedural level in the text level format
+	if (argc > 1 && std::string(argv[1]) == "--generate-level")
+	{
+		LevelGenerator::Settings settings;
+		if (argc != 9 || !LevelGenerator::parseType(argv[2], settings.type))
+		{
+			std::cerr << "usage: --generate-level <maze|arena|pillars|sprites> <width> <height> <wallDensity> <sprites> <seed> <output>" << std::endl;
+			return 1;
+		}
+		settings.width = std::stoi(argv[3]);
+		settings.height = std::stoi(argv[4]);
+		settings.wallDensity = std::stof(argv[5]);
+		settings.spriteCount = std::stoi(argv[6]);
+		settings.seed = static_cast<unsigned int>(std::stoul(argv[7]));
+
+		LevelGenerator generator(settings);
+		generator.generate();
+		generator.save(argv[8]);
+		return 0;
+	}
+
+	// --convert-level <source> <destination>
+	// converts between the text and the binary level format, chosen by the file extensions
+	if (argc > 1 && std::string(argv[1]) == "--convert-level")
+	{
+		if (argc != 4)
+		{
+			std::cerr << "usage: --convert-level <source> <destination>" << std::endl;
+			return 1;
+		}
+		return LevelReaderWriter::convertLevelFile(argv[2], argv[3]) ? 0 : 1;
+	}
+
+	// --pack-resources [output]
+	// packs the resources directory for faster starts, the game uses it when it exists
+	if (argc > 1 && std::string(argv[1]) == "--pack-resources")
+	{
+		return ResourcePack::build(g_resourceDirectory, argc > 2 ? argv[2] : g_resourcePackFile) ? 0 : 1;
+	}
+
 	Game().run();
 	return 0;
-}
\ No newline at end of file
+}